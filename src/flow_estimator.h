@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Flow rate as the least-squares slope of weight over the last N samples,
+// i.e. a first-order Savitzky-Golay derivative that also copes with uneven
+// sample spacing. Running sums are kept in fixed point (weight in 0.01 g,
+// time in ms since an epoch) so sliding the window is O(1) and exact, with no
+// float drift however long the session runs. Only the final division is done
+// in floating point, and getFlowRateCentigrams() avoids even that.
+class FlowEstimator {
+public:
+  // A slope needs three samples before isReady(); a smaller window never would be.
+  static constexpr size_t MIN_WINDOW = 3;
+  static constexpr size_t MAX_WINDOW = 32;
+  // Sample times are rebased once they get this far from the epoch, which
+  // keeps every sum comfortably inside int64 for MAX_WINDOW samples.
+  static constexpr int32_t REBASE_AFTER_MS = 1 << 20;
+
+  explicit FlowEstimator(size_t windowSamples = 10) { setWindow(windowSamples); }
+
+  // Clamped to [MIN_WINDOW, MAX_WINDOW].
+  void setWindow(size_t windowSamples) {
+    window = windowSamples < MIN_WINDOW ? MIN_WINDOW : (windowSamples > MAX_WINDOW ? MAX_WINDOW : windowSamples);
+    reset();
+  }
+
+  void reset() {
+    count = 0;
+    next = 0;
+    hasEpoch = false;
+    sumT = sumW = sumTT = sumTW = 0;
+  }
+
+  void addSample(float weightGrams, uint32_t timestampMs) {
+    if (!hasEpoch) {
+      epochMs = timestampMs;
+      hasEpoch = true;
+    }
+    int32_t t = static_cast<int32_t>(timestampMs - epochMs);
+    if (t >= REBASE_AFTER_MS) {
+      rebase(timestampMs);
+      t = static_cast<int32_t>(timestampMs - epochMs);
+    }
+    int32_t w = static_cast<int32_t>(weightGrams * 100.f + (weightGrams >= 0.f ? 0.5f : -0.5f));
+
+    if (count == window) {
+      remove(samples[next]);
+    }
+    else {
+      count++;
+    }
+    samples[next] = Sample{ t, w };
+    add(samples[next]);
+    next = (next + 1) % window;
+  }
+
+  // Enough spread in time for a slope.
+  bool isReady() const { return count >= 3 && denominator() > 0; }
+
+  // g/s, 0 until isReady().
+  float getFlowRate() const {
+    int64_t den = denominator();
+    if (count < 3 || den <= 0) return 0.f;
+    // centigrams per ms -> grams per second
+    return static_cast<float>(numerator()) / static_cast<float>(den) * 10.f;
+  }
+
+  // Integer-only variant in 0.01 g/s for callers that avoid float maths.
+  int32_t getFlowRateCentigrams() const {
+    int64_t den = denominator();
+    if (count < 3 || den <= 0) return 0;
+    return static_cast<int32_t>(numerator() * 1000 / den);
+  }
+
+private:
+  struct Sample {
+    int32_t t; // ms since epoch
+    int32_t w; // 0.01 g
+  };
+
+  Sample samples[MAX_WINDOW] = {};
+  size_t window = 10;
+  size_t count = 0;
+  size_t next = 0;
+  bool hasEpoch = false;
+  uint32_t epochMs = 0;
+  int64_t sumT = 0;
+  int64_t sumW = 0;
+  int64_t sumTT = 0;
+  int64_t sumTW = 0;
+
+  int64_t numerator() const { return static_cast<int64_t>(count) * sumTW - sumT * sumW; }
+  int64_t denominator() const { return static_cast<int64_t>(count) * sumTT - sumT * sumT; }
+
+  void add(const Sample& s) {
+    sumT += s.t;
+    sumW += s.w;
+    sumTT += static_cast<int64_t>(s.t) * s.t;
+    sumTW += static_cast<int64_t>(s.t) * s.w;
+  }
+
+  void remove(const Sample& s) {
+    sumT -= s.t;
+    sumW -= s.w;
+    sumTT -= static_cast<int64_t>(s.t) * s.t;
+    sumTW -= static_cast<int64_t>(s.t) * s.w;
+  }
+
+  // O(window), once every ~17 minutes of samples.
+  void rebase(uint32_t newEpochMs) {
+    int32_t shift = static_cast<int32_t>(newEpochMs - epochMs);
+    epochMs = newEpochMs;
+    sumT = sumW = sumTT = sumTW = 0;
+    for (size_t i = 0; i < count; i++) {
+      samples[i].t -= shift;
+      add(samples[i]);
+    }
+  }
+};
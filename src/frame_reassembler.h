@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Turns a stream of notifications into whole protocol frames, whatever the
+// split: frames may arrive in pieces, several per notification, or behind
+// junk. The driver supplies two callables:
+//
+//   int32_t measure(const uint8_t* data, size_t available)
+//     > 0  length of the frame starting at data[0] (it may not all be there yet)
+//     0    need more bytes before the length is known
+//     < 0  data[0] cannot start a frame; it is dropped and the search goes on
+//   void handle(const uint8_t* frame, size_t length)
+//     or bool: false when the frame fails its own check (a CRC, say). Its
+//     start was junk after all, so only its first byte is dropped and the
+//     rest is searched again, in case a real frame begins inside it.
+//
+// Frames are handed out straight from the notification when they don't span
+// two, so the common one-frame-per-notification case copies nothing. The
+// buffer is fixed, never allocates, and a declared length over CAPACITY is
+// treated as junk rather than waited for.
+template <size_t CAPACITY>
+class FrameReassembler {
+public:
+  void reset() { size = 0; }
+
+  // Returns the number of bytes discarded while looking for frame starts.
+  template <typename Measure, typename Handle>
+  size_t feed(const uint8_t* data, size_t length, Measure measure, Handle handle) {
+    size_t discarded = 0;
+
+    if (size == 0) {
+      size_t consumed = drain(data, length, measure, handle, discarded);
+      data += consumed;
+      length -= consumed;
+    }
+
+    while (length > 0) {
+      size_t take = CAPACITY - size < length ? CAPACITY - size : length;
+      memcpy(buffer + size, data, take);
+      size += take;
+      data += take;
+      length -= take;
+
+      size_t consumed = drain(buffer, size, measure, handle, discarded);
+      if (consumed == 0 && size == CAPACITY) {
+        // measure() keeps asking for more than fits, so the first byte cannot
+        // start a frame. Only that byte goes: a real frame may start after it.
+        memmove(buffer, buffer + 1, --size);
+        discarded++;
+        consumed = drain(buffer, size, measure, handle, discarded);
+      }
+      size -= consumed;
+      memmove(buffer, buffer + consumed, size);
+    }
+    return discarded;
+  }
+
+private:
+  uint8_t buffer[CAPACITY];
+  size_t size = 0;
+
+  template <typename Measure, typename Handle>
+  static size_t drain(const uint8_t* data, size_t length, Measure& measure, Handle& handle, size_t& discarded) {
+    size_t position = 0;
+    while (position < length) {
+      int32_t frameLength = measure(data + position, length - position);
+      if (frameLength < 0 || static_cast<size_t>(frameLength) > CAPACITY) {
+        position++;
+        discarded++;
+        continue;
+      }
+      if (frameLength == 0 || static_cast<size_t>(frameLength) > length - position) {
+        break;
+      }
+      if (!deliver(handle, data + position, static_cast<size_t>(frameLength))) {
+        position++;
+        discarded++;
+        continue;
+      }
+      position += frameLength;
+    }
+    return position;
+  }
+
+  template <typename Handle>
+  static bool deliver(Handle& handle, const uint8_t* frame, size_t length) {
+    if constexpr (std::is_void<decltype(handle(frame, length))>::value) {
+      handle(frame, length);
+      return true;
+    }
+    else {
+      return handle(frame, length);
+    }
+  }
+};
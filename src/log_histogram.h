@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Fixed-size log-linear histogram for intervals and latencies.
+// Values below 8 get a bin each; above that every power of two is split into
+// 4 sub-bins, so a reported percentile is never more than 25% above the true
+// value. Recording is O(1) and never allocates, which keeps it safe to call
+// from the BLE notification path.
+class LogHistogram {
+public:
+  static constexpr uint32_t MAX_VALUE = (1u << 24) - 1; // larger values are clamped
+  static constexpr size_t BIN_COUNT = 8 + (24 - 3) * 4;
+
+  void record(uint32_t value) {
+    if (value > MAX_VALUE) value = MAX_VALUE;
+    bins[binFor(value)]++;
+    if (total == 0 || value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+    sumValue += value;
+    total++;
+  }
+
+  void reset() {
+    for (auto& bin : bins) bin = 0;
+    total = 0;
+    minValue = 0;
+    maxValue = 0;
+    sumValue = 0;
+  }
+
+  uint32_t count() const { return total; }
+  uint32_t min() const { return minValue; }
+  uint32_t max() const { return maxValue; }
+  uint64_t sum() const { return sumValue; }
+  uint32_t mean() const { return total == 0 ? 0 : static_cast<uint32_t>(sumValue / total); }
+
+  // Upper bound of the bin holding the p-th fraction (0..1) of recorded values,
+  // clamped to the observed range. Returns 0 when nothing was recorded.
+  uint32_t percentile(float p) const {
+    if (total == 0) return 0;
+    if (p <= 0.f) return minValue;
+    uint64_t target = static_cast<uint64_t>(p * total + 0.999999f);
+    if (target > total) target = total;
+
+    uint64_t seen = 0;
+    for (size_t bin = 0; bin < BIN_COUNT; bin++) {
+      seen += bins[bin];
+      if (seen >= target) {
+        uint32_t upper = binUpperBound(bin);
+        if (upper > maxValue) return maxValue;
+        if (upper < minValue) return minValue;
+        return upper;
+      }
+    }
+    return maxValue;
+  }
+
+private:
+  uint32_t bins[BIN_COUNT] = {};
+  uint32_t total = 0;
+  uint32_t minValue = 0;
+  uint32_t maxValue = 0;
+  uint64_t sumValue = 0;
+
+  static size_t binFor(uint32_t value) {
+    if (value < 8) return value;
+    uint32_t exponent = 31 - __builtin_clz(value);
+    uint32_t sub = (value >> (exponent - 2)) & 0x3;
+    return 8 + (exponent - 3) * 4 + sub;
+  }
+
+  static uint32_t binUpperBound(size_t bin) {
+    if (bin < 8) return static_cast<uint32_t>(bin);
+    uint32_t exponent = 3 + static_cast<uint32_t>(bin - 8) / 4;
+    uint32_t sub = static_cast<uint32_t>(bin - 8) % 4;
+    uint32_t width = 1u << (exponent - 2);
+    return (1u << exponent) + (sub + 1) * width - 1;
+  }
+};
@@ -0,0 +1,146 @@
+#pragma once
+#include "remote_scales.h"
+
+// One captured notification: when it arrived, which characteristic sent it
+// and its payload.
+struct ReplayRecord {
+  uint32_t timestampMs;
+  NimBLEUUID characteristicUUID;
+  const uint8_t* data;
+  size_t length;
+};
+
+struct ReplayResult {
+  uint32_t frames = 0;     // records fed to the driver, however many pieces they were split into
+  uint32_t unmatched = 0;  // records for characteristics the driver never subscribed
+  uint32_t oversized = 0;  // records longer than an ATT payload can be, skipped
+  uint32_t samples = 0;    // weight samples the driver produced
+  uint32_t decodeUs = 0;   // wall time of the replay, pacing waits excluded
+  uint32_t nsPerFrame = 0;
+};
+
+// Optional damage applied on the way in, for stress-testing a driver's
+// framing and validation on a real trace. Deterministic for a given seed.
+struct ReplayDistortion {
+  size_t maxFragmentLength = 0; // > 0 splits each record into random pieces of 1..max bytes
+  uint32_t corruptOneIn = 0;    // > 0 flips one random bit in about 1 of this many bytes
+  uint32_t seed = 1;
+};
+
+// Plays a captured trace back through a connected driver's real notification
+// handlers via RemoteScales::injectNotification(). RECORDED keeps the original
+// spacing between records, which reproduces timing-dependent behaviour such as
+// timeouts and heartbeats; FAST feeds them back to back for profiling.
+class NotificationReplay {
+public:
+  enum class Pace : uint8_t { RECORDED, FAST };
+  // Called for every weight sample the driver decodes, with the timestamp of
+  // the record that carried it. Takes one of the scale's sample subscriber
+  // slots for the duration of run(); with none free, run() feeds nothing.
+  using SampleCallback = void (*)(uint32_t recordedMs, float weight);
+
+  explicit NotificationReplay(RemoteScales& scale) : scale(scale) {}
+
+  ReplayResult run(const ReplayRecord* records, size_t count, Pace pace, SampleCallback onSample = nullptr,
+    const ReplayDistortion& distortion = {}) {
+    ReplayResult result;
+    if (onSample != nullptr) {
+      if (!scale.subscribeSamples(&NotificationReplay::forwardSample)) return result;
+      this->onSample = onSample;
+      replaying = this;
+    }
+
+    uint32_t random = distortion.seed != 0 ? distortion.seed : 1;
+    uint8_t frame[MAX_FRAME_LENGTH];
+    uint32_t samplesBefore = scale.getSampleRateStats().samples;
+    uint32_t startedMs = remoteScalesMillis();
+    uint64_t startedNs = remoteScalesWallNanos();
+    uint64_t waitedNs = 0;
+
+    for (size_t i = 0; i < count; i++) {
+      const ReplayRecord& record = records[i];
+      if (pace == Pace::RECORDED) {
+        uint32_t dueMs = startedMs + (record.timestampMs - records[0].timestampMs);
+        int32_t waitMs = static_cast<int32_t>(dueMs - remoteScalesMillis());
+        if (waitMs > 0) {
+          uint64_t waitStartedNs = remoteScalesWallNanos();
+          remoteScalesDelay(waitMs);
+          waitedNs += remoteScalesWallNanos() - waitStartedNs;
+        }
+      }
+
+      if (record.length > MAX_FRAME_LENGTH) {
+        result.oversized++;
+        continue;
+      }
+
+      // Drivers may decode in place, so every replay works on its own copy.
+      size_t length = record.length;
+      memcpy(frame, record.data, length);
+      if (distortion.corruptOneIn > 0) {
+        for (size_t j = 0; j < length; j++) {
+          if (nextRandom(random) % distortion.corruptOneIn == 0) {
+            frame[j] ^= 1 << (nextRandom(random) % 8);
+          }
+        }
+      }
+
+      currentRecordMs = record.timestampMs;
+      bool delivered = true;
+      size_t offset = 0;
+      do {
+        size_t piece = length - offset;
+        if (distortion.maxFragmentLength > 0 && piece > 0) {
+          size_t limit = 1 + nextRandom(random) % distortion.maxFragmentLength;
+          if (piece > limit) piece = limit;
+        }
+        delivered = scale.injectNotification(record.characteristicUUID, frame + offset, piece) && delivered;
+        offset += piece;
+      } while (offset < length);
+
+      result.frames++;
+      if (!delivered) {
+        result.unmatched++;
+        continue;
+      }
+
+      uint32_t samples = scale.getSampleRateStats().samples;
+      result.samples += samples - samplesBefore;
+      samplesBefore = samples;
+    }
+
+    // One reading for the whole loop: per-notification reads round to zero
+    // at microsecond resolution.
+    uint64_t elapsedNs = remoteScalesWallNanos() - startedNs - waitedNs;
+    result.decodeUs = static_cast<uint32_t>(elapsedNs / 1000);
+    result.nsPerFrame = result.frames > 0 ? static_cast<uint32_t>(elapsedNs / result.frames) : 0;
+
+    if (onSample != nullptr) {
+      scale.unsubscribeSamples(&NotificationReplay::forwardSample);
+      replaying = nullptr;
+    }
+    return result;
+  }
+
+private:
+  static constexpr size_t MAX_FRAME_LENGTH = 512; // largest ATT payload
+
+  // Subscribers are plain function pointers; injectNotification() runs them
+  // on this thread, so the replay in progress is found through a thread local.
+  static inline thread_local NotificationReplay* replaying = nullptr;
+  SampleCallback onSample = nullptr;
+  uint32_t currentRecordMs = 0;
+
+  static void forwardSample(const ScaleSnapshot& sample) {
+    if (replaying != nullptr) replaying->onSample(replaying->currentRecordMs, sample.weight);
+  }
+
+  static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  RemoteScales& scale;
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// Fixed table of periodic tasks keyed by their next due time. run() is a
+// single comparison until the earliest deadline passes, and then only visits
+// the table once, so a loop can call it as often as it likes and can sleep
+// for untilNext() between calls. A task that falls more than a period behind
+// (the loop stalled) runs once and is rescheduled from now rather than
+// bursting to catch up.
+template <size_t CAPACITY>
+class PeriodicScheduler {
+public:
+  using Task = std::function<void()>;
+
+  // Returns false when the table is full. The first run is one period from
+  // the next restart(), or from now if the scheduler is already running.
+  bool add(uint32_t periodMs, Task task, uint32_t nowMs) {
+    if (count == CAPACITY || periodMs == 0) return false;
+    entries[count++] = Entry{ periodMs, nowMs + periodMs, task };
+    updateNextDue();
+    return true;
+  }
+
+  void clear() { count = 0; }
+
+  // Restarts every period from now, e.g. after a (re)connect.
+  void restart(uint32_t nowMs) {
+    for (size_t i = 0; i < count; i++) {
+      entries[i].dueMs = nowMs + entries[i].periodMs;
+    }
+    updateNextDue();
+  }
+
+  void run(uint32_t nowMs) {
+    if (count == 0 || static_cast<int32_t>(nowMs - nextDueMs) < 0) return;
+
+    for (size_t i = 0; i < count; i++) {
+      Entry& entry = entries[i];
+      if (static_cast<int32_t>(nowMs - entry.dueMs) < 0) continue;
+      entry.dueMs += entry.periodMs;
+      if (static_cast<int32_t>(nowMs - entry.dueMs) >= 0) {
+        entry.dueMs = nowMs + entry.periodMs;
+      }
+      entry.task();
+    }
+    updateNextDue();
+  }
+
+  // Milliseconds until run() next has work, or UINT32_MAX with no tasks.
+  uint32_t untilNext(uint32_t nowMs) const {
+    if (count == 0) return UINT32_MAX;
+    int32_t remaining = static_cast<int32_t>(nextDueMs - nowMs);
+    return remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+  }
+
+private:
+  struct Entry {
+    uint32_t periodMs;
+    uint32_t dueMs;
+    Task task;
+  };
+
+  Entry entries[CAPACITY];
+  size_t count = 0;
+  uint32_t nextDueMs = 0;
+
+  void updateNextDue() {
+    if (count == 0) return;
+    nextDueMs = entries[0].dueMs;
+    for (size_t i = 1; i < count; i++) {
+      if (static_cast<int32_t>(entries[i].dueMs - nextDueMs) < 0) nextDueMs = entries[i].dueMs;
+    }
+  }
+};
@@ -1,5 +1,7 @@
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
+#include <cstdarg>
+#include <cstdio>
 
 // ---------------------------------------------------------------------------------------
 // ------------------------   Common RemoteScales methods    ------------------------------
@@ -7,12 +9,12 @@
 
 RemoteScales::RemoteScales(const DiscoveredDevice& device) : device(device) {}
 
-void RemoteScales::log(std::string msgFormat, ...) {
+void RemoteScales::log(const char* msgFormat, ...) {
   if (!this->logCallback) return;
 
   va_list args;
   va_start(args, msgFormat);
-  int length = vsnprintf(nullptr, 0, msgFormat.c_str(), args); // Find length of string
+  int length = vsnprintf(nullptr, 0, msgFormat, args); // Find length of string
   va_end(args); // End before restarting
 
   if (length < 0) {
@@ -22,23 +24,168 @@ void RemoteScales::log(std::string msgFormat, ...) {
 
   va_start(args, msgFormat); // Restart for the actual printing
   std::string formattedMessage(length + 1, '\0'); // Instantiate formatted strigng with correct length
-  vsnprintf(&formattedMessage[0], length + 1, msgFormat.c_str(), args); // print formatted message in the string
+  vsnprintf(&formattedMessage[0], length + 1, msgFormat, args); // print formatted message in the string
   formattedMessage.resize(length); // Remove the trailing null character
   va_end(args);
   logCallback("Scale[" + device.getName() + "] " + formattedMessage);
 }
 
 void RemoteScales::setWeight(float newWeight) {
+  uint32_t now = remoteScalesMillis();
+  recordSampleArrival(now);
+  // Drivers also set a placeholder zero on connect; only a decoded sample
+  // shows the stream is alive.
+  if (decodingNotification) {
+    lastStreamActivityMs = now;
+    awaitingFirstSample = false;
+  }
+
+  sampleTimestampMs = now;
+  sampleDatedByScale = false;
+  if (scaleTimerFresh && clockSync.isLocked()) {
+    // The line through minimum-delay points can land slightly after the actual
+    // arrival for an unusually fast delivery; a sample never predates itself.
+    uint32_t taken = clockSync.toLocal(scaleTimerMs);
+    if (static_cast<int32_t>(now - taken) >= 0) {
+      sampleTimestampMs = taken;
+      sampleDatedByScale = true;
+    }
+  }
+  scaleTimerFresh = false;
+
+  if (tareState == TareState::PENDING && tareWritesDone && fabsf(newWeight) <= getTareTolerance()) {
+    finishTare(TareState::CONFIRMED);
+    // The tare step is not flow; start the slope from the new zero.
+    flowEstimator.reset();
+  }
+
+  if (flowEstimationEnabled && !nativeFlowRate) {
+    flowEstimator.addSample(newWeight, sampleTimestampMs);
+    flowRate = flowEstimator.getFlowRate();
+  }
+
   float previousWeight = weight;
   weight = newWeight;
+  ScaleSnapshot sample = publishSnapshot();
 
-  if (weightCallback == nullptr) {
-    return;
+  // Only the first sample decoded from a notification is attributed to it.
+  bool instrumented = latencyInstrumentation && notificationInFlight;
+  notificationInFlight = false;
+  uint32_t decodedUs = instrumented ? remoteScalesMicros() : 0;
+
+  if (weightCallback != nullptr && !(weightCallbackOnlyChanges && previousWeight == newWeight)) {
+    if (callbackDispatch == CallbackDispatch::INLINE) {
+      weightCallback(newWeight);
+    }
+    else {
+      deferSample(WEIGHT_CONSUMER, nullptr, callbackDispatch, sample);
+    }
   }
-  if (weightCallbackOnlyChanges && previousWeight == newWeight) {
-    return;
+  notifySampleSubscribers(sample, now);
+
+  if (instrumented) {
+    uint32_t consumedUs = remoteScalesMicros();
+    decodeLatencyUs.record(decodedUs - notificationEntryUs);
+    consumerLatencyUs.record(consumedUs - decodedUs);
+    totalLatencyUs.record(consumedUs - notificationEntryUs);
   }
-  weightCallback(newWeight);
+}
+
+ScaleSnapshot RemoteScales::publishSnapshot() {
+  ScaleSnapshot sample{
+    .sample = ++publishedSamples,
+    .weight = weight,
+    .flowRate = flowRate,
+    .sampleTimestampMs = sampleTimestampMs,
+    .scaleTimerMs = scaleTimerMs,
+    .batteryLevel = batteryLevel,
+    .weightUnit = weightUnit,
+    .autoModeStopCondition = autoModeStopCondition,
+  };
+  snapshot.write(sample);
+  return sample;
+}
+
+bool RemoteScales::subscribeSamples(SampleCallback callback, const SampleSubscriberOptions& options) {
+  if (callback == nullptr) return false;
+
+  SampleSubscriber* slot = nullptr;
+  for (auto& subscriber : sampleSubscribers) {
+    SampleCallback current = subscriber.callback.load(std::memory_order_acquire);
+    if (current == callback) {
+      slot = &subscriber;
+      break;
+    }
+    if (current == nullptr && slot == nullptr) {
+      slot = &subscriber;
+    }
+  }
+  if (slot == nullptr) return false;
+
+  // Hide the slot while it is rewritten so setWeight() never sees half the options.
+  slot->callback.store(nullptr, std::memory_order_release);
+  slot->options = options;
+  slot->delivered = false;
+  slot->callback.store(callback, std::memory_order_release);
+  return true;
+}
+
+void RemoteScales::unsubscribeSamples(SampleCallback callback) {
+  for (auto& subscriber : sampleSubscribers) {
+    SampleCallback expected = callback;
+    subscriber.callback.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+  }
+}
+
+bool RemoteScales::wantsSample(const SampleSubscriber& subscriber, const ScaleSnapshot& sample, uint32_t now) {
+  if (!subscriber.delivered) return true;
+
+  const SampleSubscriberOptions& options = subscriber.options;
+  if (now - subscriber.lastDeliveredMs < options.minIntervalMs) return false;
+  if (options.deadband <= 0.f && (options.channels & SCALE_CHANNEL_ALL) == SCALE_CHANNEL_ALL) return true;
+
+  // Without a deadband any change on a watched channel counts.
+  auto moved = [&options](float value, float last) {
+    return options.deadband > 0.f ? fabsf(value - last) >= options.deadband : value != last;
+  };
+  return ((options.channels & SCALE_CHANNEL_WEIGHT) && moved(sample.weight, subscriber.lastWeight))
+    || ((options.channels & SCALE_CHANNEL_FLOW) && moved(sample.flowRate, subscriber.lastFlowRate))
+    || ((options.channels & SCALE_CHANNEL_BATTERY) && sample.batteryLevel != subscriber.lastBatteryLevel)
+    || ((options.channels & SCALE_CHANNEL_UNIT) && sample.weightUnit != subscriber.lastWeightUnit);
+}
+
+void RemoteScales::notifySampleSubscribers(const ScaleSnapshot& sample, uint32_t now) {
+  for (size_t i = 0; i < MAX_SAMPLE_SUBSCRIBERS; i++) {
+    SampleSubscriber& subscriber = sampleSubscribers[i];
+    SampleCallback callback = subscriber.callback.load(std::memory_order_acquire);
+    if (callback == nullptr || !wantsSample(subscriber, sample, now)) continue;
+
+    subscriber.delivered = true;
+    subscriber.lastDeliveredMs = now;
+    subscriber.lastWeight = sample.weight;
+    subscriber.lastFlowRate = sample.flowRate;
+    subscriber.lastBatteryLevel = sample.batteryLevel;
+    subscriber.lastWeightUnit = sample.weightUnit;
+    if (subscriber.options.dispatch == CallbackDispatch::INLINE) {
+      callback(sample);
+    }
+    else {
+      deferSample(static_cast<uint8_t>(i + 1), callback, subscriber.options.dispatch, sample);
+    }
+  }
+}
+
+void RemoteScales::setFlowEstimation(bool enabled, size_t windowSamples) {
+  flowEstimationEnabled = enabled;
+  flowEstimator.setWindow(windowSamples);
+}
+
+void RemoteScales::setScaleTimerMs(uint32_t t, bool datesWeight) {
+  // A stopped stopwatch repeats its last reading; mapping that onto local time
+  // would date every later sample to the moment it stopped.
+  scaleTimerFresh = datesWeight && t != scaleTimerMs;
+  scaleTimerMs = t;
+  clockSync.update(t, remoteScalesMillis());
 }
 
 void RemoteScales::setWeightUpdatedCallback(void (*callback)(float), bool onlyChanges) {
@@ -46,14 +193,311 @@ void RemoteScales::setWeightUpdatedCallback(void (*callback)(float), bool onlyCh
   this->weightCallback = callback;
 }
 
+void RemoteScales::setCallbackDispatch(CallbackDispatch dispatch) {
+  // Samples already queued under the previous policy are still delivered.
+  callbackDispatch = dispatch;
+}
+
+void RemoteScales::deferSample(uint8_t consumer, SampleCallback callback, CallbackDispatch dispatch, const ScaleSnapshot& sample) {
+  {
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    if (dispatch == CallbackDispatch::LATEST_WINS) {
+      latestSamples[consumer] = DeferredSample{ consumer, callback, sample };
+      latestPending[consumer] = true;
+    }
+    else if (dispatchQueueSize == DISPATCH_QUEUE_CAPACITY) {
+      countHealth(ScaleHealthCounter::DISPATCH_DROPS);
+      return;
+    }
+    else {
+      dispatchQueue[(dispatchQueueHead + dispatchQueueSize) % DISPATCH_QUEUE_CAPACITY] = DeferredSample{ consumer, callback, sample };
+      dispatchQueueSize++;
+    }
+    // One job drains everything; only the first pending sample posts it.
+    if (dispatchScheduled) return;
+    dispatchScheduled = true;
+  }
+
+  if (!RemoteScalesDispatcher::getInstance()->post(&RemoteScales::runDeferredCallbacks, this)) {
+    // The samples stay queued and the next one tries again.
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    dispatchScheduled = false;
+  }
+}
+
+void RemoteScales::runDeferredCallbacks(void* context) {
+  RemoteScales* scale = static_cast<RemoteScales*>(context);
+  // Bounded so a scale that never goes quiet still yields the dispatcher to others.
+  for (size_t delivered = 0; delivered < DISPATCH_BATCH; delivered++) {
+    DeferredSample next;
+    {
+      std::lock_guard<std::mutex> lock(scale->dispatchMutex);
+      if (scale->dispatchQueueSize > 0) {
+        next = scale->dispatchQueue[scale->dispatchQueueHead];
+        scale->dispatchQueueHead = (scale->dispatchQueueHead + 1) % DISPATCH_QUEUE_CAPACITY;
+        scale->dispatchQueueSize--;
+      }
+      else {
+        size_t consumer = 0;
+        while (consumer < DISPATCH_CONSUMERS && !scale->latestPending[consumer]) consumer++;
+        if (consumer == DISPATCH_CONSUMERS) {
+          scale->dispatchScheduled = false;
+          return;
+        }
+        next = scale->latestSamples[consumer];
+        scale->latestPending[consumer] = false;
+      }
+    }
+    scale->deliverDeferred(next);
+  }
+
+  {
+    // Cancelled while the batch ran: the queues were emptied, so no successor.
+    std::lock_guard<std::mutex> lock(scale->dispatchMutex);
+    bool pending = scale->dispatchQueueSize > 0;
+    for (bool latest : scale->latestPending) pending = pending || latest;
+    if (!pending) {
+      scale->dispatchScheduled = false;
+      return;
+    }
+  }
+  if (!RemoteScalesDispatcher::getInstance()->post(&RemoteScales::runDeferredCallbacks, scale)) {
+    std::lock_guard<std::mutex> lock(scale->dispatchMutex);
+    scale->dispatchScheduled = false;
+  }
+}
+
+void RemoteScales::deliverDeferred(const DeferredSample& deferred) {
+  if (deferred.consumer == WEIGHT_CONSUMER) {
+    WeightCallback callback = weightCallback;
+    if (callback != nullptr) {
+      callback(deferred.sample.weight);
+    }
+    return;
+  }
+  const SampleSubscriber& subscriber = sampleSubscribers[deferred.consumer - 1];
+  if (subscriber.callback.load(std::memory_order_acquire) == deferred.callback) {
+    deferred.callback(deferred.sample);
+  }
+}
+
+void RemoteScales::cancelDeferredCallbacks() {
+  {
+    std::lock_guard<std::mutex> lock(dispatchMutex);
+    // A job already running finds nothing left and returns.
+    dispatchQueueSize = 0;
+    for (bool& pending : latestPending) pending = false;
+    // Nothing scheduled means no job is queued and none will touch this scale again.
+    if (!dispatchScheduled) return;
+  }
+  RemoteScalesDispatcher::getInstance()->cancel(this);
+}
+
+void RemoteScales::recordSampleArrival(uint32_t now) {
+  if (!hasSampleArrival) {
+    // The first sample only anchors the clock; gaps start with the next one.
+    hasSampleArrival = true;
+    firstSampleMs = now;
+    lastSampleMs = now;
+    return;
+  }
+
+  uint32_t gap = now - lastSampleMs;
+  lastSampleMs = now;
+  sampleGapsMs.record(gap);
+  // Exponential moving average over roughly the last 8 gaps.
+  recentGapMs = recentGapMs == 0.f ? gap : recentGapMs + (gap - recentGapMs) / 8.f;
+}
+
+SampleRateStats RemoteScales::getSampleRateStats() const {
+  SampleRateStats stats;
+  uint32_t gaps = sampleGapsMs.count();
+  if (gaps == 0) {
+    stats.samples = hasSampleArrival ? 1 : 0;
+    return stats;
+  }
+
+  stats.samples = gaps + 1;
+  uint32_t elapsedMs = lastSampleMs - firstSampleMs;
+  stats.effectiveHz = elapsedMs > 0 ? gaps * 1000.f / elapsedMs : 0.f;
+  stats.recentHz = recentGapMs > 0.f ? 1000.f / recentGapMs : 0.f;
+  stats.p50GapMs = sampleGapsMs.percentile(0.50f);
+  stats.p99GapMs = sampleGapsMs.percentile(0.99f);
+  stats.maxGapMs = sampleGapsMs.max();
+  return stats;
+}
+
+void RemoteScales::resetSampleRateStats() {
+  sampleGapsMs.reset();
+  hasSampleArrival = false;
+  firstSampleMs = 0;
+  lastSampleMs = 0;
+  recentGapMs = 0.f;
+}
+
 bool RemoteScales::clientConnect() {
   clientCleanup();
+  resetSampleRateStats();
+  clockSync.reset();
+  scaleTimerFresh = false;
+  flowEstimator.reset();
   log("Connecting to BLE client\n");
   client = NimBLEDevice::createClient(device.getAddress());
-  return client->connect();
+  connectionParamsRequested = false;
+
+  // As central we pick the initial parameters, so ask for the preferred ones
+  // up front; the post-connect request only covers peripherals that override them.
+  const BLEConnectionParams preferred = getPreferredConnectionParams();
+  if (preferred.maxInterval != 0) {
+    client->setConnectionParams(preferred.minInterval, preferred.maxInterval, preferred.latency, preferred.supervisionTimeout);
+  }
+
+  if (!client->connect()) {
+    return false;
+  }
+  if (hasConnected) {
+    countHealth(ScaleHealthCounter::RECONNECTS);
+  }
+  hasConnected = true;
+  requestPreferredConnectionParams();
+  periodicTasks.restart(remoteScalesMillis());
+  lastStreamActivityMs = remoteScalesMillis();
+  awaitingFirstSample = true;
+  reportedStale = false;
+  watchdogReconnectFailed = false;
+  return true;
+}
+
+void RemoteScales::setStaleWatchdog(uint8_t missedIntervals, bool reconnect) {
+  staleMissedIntervals = missedIntervals;
+  staleReconnect = reconnect;
+}
+
+uint32_t RemoteScales::getStaleThresholdMs() const {
+  // The measured cadence wins once there is enough of it to trust.
+  uint32_t interval = sampleGapsMs.count() >= 8 ? sampleGapsMs.percentile(0.50f) : getExpectedSampleIntervalMs();
+  uint32_t threshold = staleMissedIntervals * interval;
+  if (threshold < STALE_MIN_MS) threshold = STALE_MIN_MS;
+  if (awaitingFirstSample && threshold < STALE_FIRST_SAMPLE_GRACE_MS) threshold = STALE_FIRST_SAMPLE_GRACE_MS;
+  return threshold;
+}
+
+bool RemoteScales::isStale() const {
+  uint32_t threshold = staleThresholdMs;
+  return threshold != 0 && getStreamAgeMs() > threshold;
+}
+
+void RemoteScales::serviceStaleWatchdog() {
+  if (watchdogReconnecting) return;
+
+  // Published for isStale(), which other tasks call.
+  bool watching = staleMissedIntervals > 0 && client != nullptr && client->isConnected();
+  staleThresholdMs = watching ? getStaleThresholdMs() : 0;
+  if (staleMissedIntervals == 0) return;
+
+  bool stale = isStale();
+  if (stale && !reportedStale) {
+    log("No weight sample for %u ms, stream is stale\n", (unsigned)getStreamAgeMs());
+  }
+  reportedStale = stale;
+
+  uint32_t now = remoteScalesMillis();
+  bool backedOff = !hasWatchdogReconnected || now - lastWatchdogReconnectMs >= STALE_RECONNECT_BACKOFF_MS;
+  // A failed attempt is retried here too; not every driver notices on its own.
+  if (!backedOff || !staleReconnect || !(stale || watchdogReconnectFailed)) {
+    return;
+  }
+
+  // Straight to cleanup: a driver's disconnect() may write to the scale first,
+  // which on a dead link would block until the supervision timeout anyway.
+  log("Reconnecting stale scale\n");
+  watchdogReconnecting = true;
+  hasWatchdogReconnected = true;
+  lastWatchdogReconnectMs = now;
+  clientCleanup();
+  watchdogReconnectFailed = !connect();
+  watchdogReconnecting = false;
+}
+
+uint32_t RemoteScales::getMsUntilNextUpdate() {
+  {
+    std::lock_guard<std::mutex> lock(commandQueueMutex);
+    if (commandQueueSize > 0) return 0;
+  }
+
+  uint32_t now = remoteScalesMillis();
+  uint32_t wait = periodicTasks.untilNext(now);
+  if (staleMissedIntervals > 0 && client != nullptr) {
+    uint32_t threshold = getStaleThresholdMs();
+    uint32_t age = getStreamAgeMs();
+    if (age <= threshold && threshold + 1 - age < wait) wait = threshold + 1 - age;
+  }
+  if (tareState == TareState::PENDING) {
+    int32_t tareRemaining = static_cast<int32_t>(tareStartedMs + TARE_TIMEOUT_MS + 1 - now);
+    uint32_t tareWait = tareRemaining > 0 ? static_cast<uint32_t>(tareRemaining) : 0;
+    if (tareWait < wait) wait = tareWait;
+  }
+  return wait;
+}
+
+void RemoteScales::requestPreferredConnectionParams() {
+  const BLEConnectionParams preferred = getPreferredConnectionParams();
+  if (preferred.maxInterval == 0) {
+    return;
+  }
+
+  NimBLEConnInfo info = client->getConnInfo();
+  uint16_t interval = info.getConnInterval();
+  if (interval >= preferred.minInterval && interval <= preferred.maxInterval) {
+    log("Connection interval %.2f ms within preferred range\n", interval * 1.25f);
+    return;
+  }
+
+  // The update completes asynchronously. If the peripheral refuses we simply
+  // keep the current parameters; getConnectionParams() reports the outcome.
+  log("Connection interval %.2f ms, requesting %.2f-%.2f ms\n",
+    interval * 1.25f, preferred.minInterval * 1.25f, preferred.maxInterval * 1.25f);
+  client->updateConnParams(preferred.minInterval, preferred.maxInterval, preferred.latency, preferred.supervisionTimeout);
+  connectionParamsRequested = true;
+}
+
+BLEConnectionParamsReport RemoteScales::getConnectionParams() const {
+  BLEConnectionParamsReport report;
+  report.requested = connectionParamsRequested;
+  if (client == nullptr || !client->isConnected()) {
+    return report;
+  }
+
+  NimBLEConnInfo info = client->getConnInfo();
+  report.interval = info.getConnInterval();
+  report.latency = info.getConnLatency();
+  report.supervisionTimeout = info.getConnTimeout();
+
+  const BLEConnectionParams preferred = getPreferredConnectionParams();
+  report.accepted = preferred.maxInterval == 0
+    || (report.interval >= preferred.minInterval && report.interval <= preferred.maxInterval);
+  return report;
 }
 
 void RemoteScales::clientCleanup() {
+  clearCommandQueue();
+  // A tare whose writes all went out is still waiting for its zero; that can
+  // no longer arrive, and a placeholder zero after reconnect must not confirm it.
+  if (tareState == TareState::PENDING) {
+    log("Tare abandoned with the connection\n");
+    finishTare(TareState::FAILED);
+  }
+  {
+    std::lock_guard<std::mutex> lock(commandQueueMutex);
+    pendingTareWrites = 0;
+    tareWritesDone = false;
+  }
+  staleThresholdMs = 0;
+  // The characteristics go away with the client.
+  for (size_t i = 0; i < subscriptionCount; i++) {
+    subscriptions[i] = Subscription{};
+  }
+  subscriptionCount = 0;
   if (client == nullptr) {
     return;
   }
@@ -70,10 +514,301 @@ NimBLERemoteService* RemoteScales::clientGetService(const NimBLEUUID uuid) {
   return client->getService(uuid);
 }
 
+bool RemoteScales::subscribe(NimBLERemoteCharacteristic* characteristic, NotifyCallback callback, bool notifications, bool response) {
+  if (characteristic == nullptr) {
+    return false;
+  }
+  NotifyCallback instrumented = [this, callback](NimBLERemoteCharacteristic* source, uint8_t* data, size_t length, bool isNotify) {
+    if (latencyInstrumentation) {
+      notificationEntryUs = remoteScalesMicros();
+      notificationInFlight = true;
+    }
+    decodingNotification = true;
+    callback(source, data, length, isNotify);
+    decodingNotification = false;
+    // Notifications that carried no weight (acks, battery, ...) are not timed.
+    notificationInFlight = false;
+  };
+
+  // Remembered for injectNotification(). Resubscribing the same
+  // characteristic (e.g. notify failed, retry with indicate) replaces it.
+  size_t slot = 0;
+  while (slot < subscriptionCount && subscriptions[slot].characteristic != characteristic) {
+    slot++;
+  }
+  if (slot == MAX_SUBSCRIPTIONS) {
+    log("No subscription slot left, not subscribing\n");
+    return false;
+  }
+  if (!characteristic->subscribe(notifications, instrumented, response)) {
+    return false;
+  }
+  subscriptions[slot] = Subscription{ characteristic, instrumented };
+  if (slot == subscriptionCount) subscriptionCount++;
+  return true;
+}
+
+bool RemoteScales::injectNotification(const NimBLEUUID& characteristicUUID, uint8_t* data, size_t length) {
+  for (size_t i = 0; i < subscriptionCount; i++) {
+    if (subscriptions[i].characteristic->getUUID() == characteristicUUID) {
+      subscriptions[i].callback(subscriptions[i].characteristic, data, length, true);
+      return true;
+    }
+  }
+  return false;
+}
+
+NotificationLatencyStats RemoteScales::getLatencyStats() const {
+  NotificationLatencyStats stats;
+  stats.notifications = totalLatencyUs.count();
+  stats.decodeP50Us = decodeLatencyUs.percentile(0.50f);
+  stats.decodeP99Us = decodeLatencyUs.percentile(0.99f);
+  stats.decodeMaxUs = decodeLatencyUs.max();
+  stats.consumerP50Us = consumerLatencyUs.percentile(0.50f);
+  stats.consumerP99Us = consumerLatencyUs.percentile(0.99f);
+  stats.consumerMaxUs = consumerLatencyUs.max();
+  stats.totalP50Us = totalLatencyUs.percentile(0.50f);
+  stats.totalP99Us = totalLatencyUs.percentile(0.99f);
+  stats.totalMaxUs = totalLatencyUs.max();
+  return stats;
+}
+
+void RemoteScales::resetLatencyStats() {
+  decodeLatencyUs.reset();
+  consumerLatencyUs.reset();
+  totalLatencyUs.reset();
+}
+
+bool RemoteScales::sendCommand(ScaleCommand command, NimBLERemoteCharacteristic* characteristic, const uint8_t* data, size_t length, bool withResponse) {
+  if (characteristic == nullptr) {
+    return false;
+  }
+  return enqueueCommand(command, characteristic, nullptr, data, length, withResponse);
+}
+
+bool RemoteScales::sendCommand(ScaleCommand command, NimBLERemoteDescriptor* descriptor, const uint8_t* data, size_t length, bool withResponse) {
+  if (descriptor == nullptr) {
+    return false;
+  }
+  return enqueueCommand(command, nullptr, descriptor, data, length, withResponse);
+}
+
+bool RemoteScales::enqueueCommand(ScaleCommand command, NimBLERemoteCharacteristic* characteristic, NimBLERemoteDescriptor* descriptor,
+  const uint8_t* data, size_t length, bool withResponse) {
+  if (length > MAX_COMMAND_LENGTH) {
+    log("Command of %u bytes exceeds queue slot, rejected\n", (unsigned)length);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(commandQueueMutex);
+
+  // A write identical to the one last queued collapses into it; this is what
+  // keeps repeated heartbeats or double-tapped tares from piling up. Only the
+  // tail is compared: folding into an earlier entry would reorder the write
+  // against whatever was queued since, e.g. the Dot's poll after a tare.
+  if (commandQueueSize > 0) {
+    const PendingCommand& tail = commandQueue[(commandQueueHead + commandQueueSize - 1) % COMMAND_QUEUE_CAPACITY];
+    if (tail.command == command && tail.withResponse == withResponse
+      && tail.characteristic == characteristic && tail.descriptor == descriptor
+      && tail.length == length && memcmp(tail.data, data, length) == 0) {
+      return true;
+    }
+  }
+
+  if (commandQueueSize == COMMAND_QUEUE_CAPACITY) {
+    log("Command queue full, rejecting command\n");
+    return false;
+  }
+
+  if (command == ScaleCommand::TARE) {
+    // A tare already in progress keeps its start time; its remaining writes
+    // simply grow by one.
+    if (tareState != TareState::PENDING) {
+      tareStartedMs = remoteScalesMillis();
+      tareWritesDone = false;
+      tareState = TareState::PENDING;
+    }
+    pendingTareWrites++;
+  }
+
+  PendingCommand& slot = commandQueue[(commandQueueHead + commandQueueSize) % COMMAND_QUEUE_CAPACITY];
+  slot.command = command;
+  slot.characteristic = characteristic;
+  slot.descriptor = descriptor;
+  slot.withResponse = withResponse;
+  slot.length = static_cast<uint8_t>(length);
+  memcpy(slot.data, data, length);
+  slot.deadlineMs = remoteScalesMillis() + COMMAND_TIMEOUT_MS;
+  commandQueueSize++;
+  return true;
+}
+
+void RemoteScales::processCommandQueue() {
+  if (tareState == TareState::PENDING && remoteScalesMillis() - tareStartedMs > TARE_TIMEOUT_MS) {
+    log("Tare not confirmed within %u ms\n", (unsigned)TARE_TIMEOUT_MS);
+    finishTare(TareState::TIMED_OUT);
+  }
+
+  for (size_t sent = 0; sent < COMMAND_BURST_LIMIT;) {
+    PendingCommand pending;
+    {
+      std::lock_guard<std::mutex> lock(commandQueueMutex);
+      if (commandQueueSize == 0) {
+        return;
+      }
+      pending = commandQueue[commandQueueHead];
+      commandQueueHead = (commandQueueHead + 1) % COMMAND_QUEUE_CAPACITY;
+      commandQueueSize--;
+    }
+
+    if (static_cast<int32_t>(remoteScalesMillis() - pending.deadlineMs) > 0) {
+      log("Command %u timed out before it could be sent\n", static_cast<unsigned>(pending.command));
+      completeCommand(pending.command, ScaleCommandStatus::TIMED_OUT);
+      continue;
+    }
+
+    // The write happens outside the lock: with a response it blocks for a
+    // full round trip, and notification handlers may be queueing meanwhile.
+    bool ok = pending.characteristic != nullptr
+      ? pending.characteristic->writeValue(pending.data, pending.length, pending.withResponse)
+      : pending.descriptor->writeValue(pending.data, pending.length, pending.withResponse);
+    sent++;
+    if (!ok) {
+      countHealth(ScaleHealthCounter::WRITE_FAILURES);
+      log("Write failed for command %u\n", static_cast<unsigned>(pending.command));
+    }
+    completeCommand(pending.command, ok ? ScaleCommandStatus::SENT : ScaleCommandStatus::FAILED);
+  }
+}
+
+void RemoteScales::clearCommandQueue() {
+  while (true) {
+    ScaleCommand command;
+    {
+      std::lock_guard<std::mutex> lock(commandQueueMutex);
+      if (commandQueueSize == 0) {
+        return;
+      }
+      command = commandQueue[commandQueueHead].command;
+      commandQueueHead = (commandQueueHead + 1) % COMMAND_QUEUE_CAPACITY;
+      commandQueueSize--;
+    }
+    completeCommand(command, ScaleCommandStatus::DROPPED);
+  }
+}
+
+void RemoteScales::completeCommand(ScaleCommand command, ScaleCommandStatus status) {
+  if (command == ScaleCommand::TARE) {
+    bool tareWriteFailed = false;
+    {
+      // Counted under the queue lock, as enqueueCommand() adds to it from the
+      // caller's task; finishTare() runs the tare callback, so not in here.
+      std::lock_guard<std::mutex> lock(commandQueueMutex);
+      if (pendingTareWrites > 0) {
+        pendingTareWrites--;
+        if (tareState == TareState::PENDING) {
+          if (status != ScaleCommandStatus::SENT) {
+            tareWriteFailed = true;
+          }
+          else if (pendingTareWrites == 0) {
+            // Only samples produced after the last tare write can show the zero.
+            tareWritesDone = true;
+          }
+        }
+      }
+    }
+    if (tareWriteFailed) {
+      finishTare(TareState::FAILED);
+    }
+  }
+
+  if (commandCallback != nullptr) {
+    commandCallback(command, status);
+  }
+}
+
+void RemoteScales::confirmTare() {
+  finishTare(TareState::CONFIRMED);
+}
+
+void RemoteScales::finishTare(TareState result) {
+  // Confirmation arrives on the BLE task while timeouts and write failures are
+  // detected from update(); whichever claims the pending tare first reports it.
+  TareState expected = TareState::PENDING;
+  if (!tareState.compare_exchange_strong(expected, result)) {
+    return;
+  }
+
+  uint32_t latencyMs = remoteScalesMillis() - tareStartedMs;
+  tareLastMs = latencyMs;
+  if (result == TareState::CONFIRMED) {
+    tareLatenciesMs.record(latencyMs);
+  }
+  else if (result == TareState::TIMED_OUT) {
+    taresTimedOut++;
+  }
+  else {
+    taresFailed++;
+  }
+
+  if (tareCallback != nullptr) {
+    tareCallback(result, latencyMs);
+  }
+}
+
+TareLatencyStats RemoteScales::getTareLatencyStats() const {
+  TareLatencyStats stats;
+  stats.confirmed = tareLatenciesMs.count();
+  stats.failed = taresFailed;
+  stats.timedOut = taresTimedOut;
+  stats.lastMs = tareLastMs;
+  stats.minMs = tareLatenciesMs.min();
+  stats.p50Ms = tareLatenciesMs.percentile(0.50f);
+  stats.p90Ms = tareLatenciesMs.percentile(0.90f);
+  stats.maxMs = tareLatenciesMs.max();
+  return stats;
+}
+
+ScaleHealthCounters RemoteScales::getHealthCounters() const {
+  auto read = [this](ScaleHealthCounter counter) {
+    return healthCounters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+  };
+  ScaleHealthCounters counters;
+  counters.framesOk = read(ScaleHealthCounter::FRAMES_OK);
+  counters.checksumFailures = read(ScaleHealthCounter::CHECKSUM_FAILURES);
+  counters.bytesDiscarded = read(ScaleHealthCounter::BYTES_DISCARDED);
+  counters.resyncs = read(ScaleHealthCounter::RESYNCS);
+  counters.unknownTypes = read(ScaleHealthCounter::UNKNOWN_TYPES);
+  counters.malformedFrames = read(ScaleHealthCounter::MALFORMED_FRAMES);
+  counters.reconnects = read(ScaleHealthCounter::RECONNECTS);
+  counters.writeFailures = read(ScaleHealthCounter::WRITE_FAILURES);
+  counters.dispatchDrops = read(ScaleHealthCounter::DISPATCH_DROPS);
+  return counters;
+}
+
+void RemoteScales::resetHealthCounters() {
+  for (auto& counter : healthCounters) {
+    counter.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::string RemoteScales::formatHealthCounters() const {
+  ScaleHealthCounters counters = getHealthCounters();
+  char line[176];
+  snprintf(line, sizeof(line), "ok=%u crc=%u drop=%u resync=%u unknown=%u malformed=%u reconnect=%u wfail=%u ddrop=%u",
+    (unsigned)counters.framesOk, (unsigned)counters.checksumFailures, (unsigned)counters.bytesDiscarded,
+    (unsigned)counters.resyncs, (unsigned)counters.unknownTypes, (unsigned)counters.malformedFrames,
+    (unsigned)counters.reconnects, (unsigned)counters.writeFailures, (unsigned)counters.dispatchDrops);
+  return line;
+}
+
 bool RemoteScales::clientIsConnected() { return client != nullptr && client->isConnected(); };
 
 std::string RemoteScales::byteArrayToHexString(const uint8_t* byteArray, size_t length) {
   std::string hexString;
+  if (!logCallback) {
+    return hexString;
+  }
   hexString.reserve(length * 3); // Reserve space for the resulting string
 
   char hex[4];
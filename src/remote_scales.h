@@ -1,9 +1,21 @@
 #pragma once
 #include <NimBLEDevice.h>
-#include <Arduino.h>
+#include <remote_scales_platform.h>
+#include <cmath>
+#include <cstring>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <mutex>
+#include <atomic>
 #include <lru_cache.h>
+#include <log_histogram.h>
+#include <scale_clock_sync.h>
+#include <flow_estimator.h>
+#include <frame_reassembler.h>
+#include <remote_scales_dispatcher.h>
+#include <seqlock.h>
+#include <periodic_scheduler.h>
 
 
 class DiscoveredDevice {
@@ -30,10 +42,161 @@ enum class ScaleWeightUnit : uint8_t { UNKNOWN = 0, GRAM = 1, OUNCE = 2 };
 // Sentinel for "driver has no battery reading available".
 constexpr uint8_t REMOTE_SCALES_BATTERY_UNKNOWN = 0xFF;
 
+// Measured cadence of weight samples since the last connect. Gaps are the time
+// between consecutive setWeight() calls as seen by this library, so they
+// include BLE connection-interval jitter and any scale-side throttling.
+struct SampleRateStats {
+  uint32_t samples = 0;     // samples recorded since connect
+  float effectiveHz = 0.f;  // samples / elapsed time over the whole session
+  float recentHz = 0.f;     // from a short moving average of the latest gaps
+  uint32_t p50GapMs = 0;
+  uint32_t p99GapMs = 0;
+  uint32_t maxGapMs = 0;
+};
+
+// BLE connection parameters in NimBLE units: intervals in 1.25 ms steps,
+// supervision timeout in 10 ms steps. A zero maxInterval means "no preference",
+// i.e. keep whatever the stack and peripheral settle on.
+struct BLEConnectionParams {
+  uint16_t minInterval = 0;
+  uint16_t maxInterval = 0;
+  uint16_t latency = 0;
+  uint16_t supervisionTimeout = 0;
+};
+
+// Parameters actually in effect on the link, plus whether they honour the
+// driver's preference. The peripheral is free to refuse or later renegotiate,
+// so accepted can flip back to false during a session.
+struct BLEConnectionParamsReport {
+  bool requested = false;          // an update was sent after connect
+  bool accepted = false;           // negotiated interval lies within the preferred range
+  uint16_t interval = 0;           // 1.25 ms units
+  uint16_t latency = 0;
+  uint16_t supervisionTimeout = 0; // 10 ms units
+};
+
+// What a queued GATT write is for. Reported back through the command callback
+// so consumers can match completions to the calls that caused them.
+enum class ScaleCommand : uint8_t { TARE, START_TIMER, STOP_TIMER, RESET_TIMER, HEARTBEAT, SETUP };
+
+enum class ScaleCommandStatus : uint8_t {
+  SENT,       // write accepted by the stack (acknowledged when sent with response)
+  FAILED,     // the write itself failed
+  TIMED_OUT,  // not sent before its deadline
+  DROPPED,    // discarded because the client was cleaned up
+};
+
+// Progress of the most recent tare. A tare is CONFIRMED once the driver sees
+// a protocol acknowledgement, or otherwise the first near-zero sample after
+// every tare write went out.
+enum class TareState : uint8_t { IDLE, PENDING, CONFIRMED, FAILED, TIMED_OUT };
+
+// Time from tare() to confirmation, over all tares since the scale object was
+// created. Kept across reconnects so it characterises the scale model.
+struct TareLatencyStats {
+  uint32_t confirmed = 0;
+  uint32_t failed = 0;
+  uint32_t timedOut = 0;
+  uint32_t lastMs = 0;
+  uint32_t minMs = 0;
+  uint32_t p50Ms = 0;
+  uint32_t p90Ms = 0;
+  uint32_t maxMs = 0;
+};
+
+// Where the library spends its time on each weight notification, in
+// microseconds. Decode runs from notification entry to setWeight(), consumer
+// from there until the weight callback returns, total is both. Only recorded
+// while setLatencyInstrumentation(true).
+struct NotificationLatencyStats {
+  uint32_t notifications = 0;
+  uint32_t decodeP50Us = 0;
+  uint32_t decodeP99Us = 0;
+  uint32_t decodeMaxUs = 0;
+  uint32_t consumerP50Us = 0;
+  uint32_t consumerP99Us = 0;
+  uint32_t consumerMaxUs = 0;
+  uint32_t totalP50Us = 0;
+  uint32_t totalP99Us = 0;
+  uint32_t totalMaxUs = 0;
+};
+
+// Protocol health counters, kept since the scale object was created so they
+// survive reconnects. Cheap enough to leave on in production: each is a
+// relaxed atomic increment on the notification path.
+enum class ScaleHealthCounter : uint8_t {
+  FRAMES_OK,         // frames that passed the protocol's length and checksum checks
+  CHECKSUM_FAILURES,
+  BYTES_DISCARDED,   // skipped while hunting for a frame start, or dropped with a bad frame
+  RESYNCS,           // times the parser had to search for the next frame start
+  UNKNOWN_TYPES,     // frames of a type the driver does not handle
+  MALFORMED_FRAMES,  // wrong length or impossible field values
+  RECONNECTS,
+  WRITE_FAILURES,
+  DISPATCH_DROPS,    // samples a LOSSLESS consumer lost to a full dispatch queue
+  COUNT
+};
+
+struct ScaleHealthCounters {
+  uint32_t framesOk = 0;
+  uint32_t checksumFailures = 0;
+  uint32_t bytesDiscarded = 0;
+  uint32_t resyncs = 0;
+  uint32_t unknownTypes = 0;
+  uint32_t malformedFrames = 0;
+  uint32_t reconnects = 0;
+  uint32_t writeFailures = 0;
+  uint32_t dispatchDrops = 0;
+};
+
+// Every field as of the same weight sample. Drivers set the optional fields
+// for a frame before its weight, and setWeight() publishes them together.
+struct ScaleSnapshot {
+  uint32_t sample = 0;            // counts published samples; unchanged means no new data
+  float weight = 0.f;
+  float flowRate = 0.f;
+  uint32_t sampleTimestampMs = 0;
+  uint32_t scaleTimerMs = 0;
+  uint8_t batteryLevel = REMOTE_SCALES_BATTERY_UNKNOWN;
+  ScaleWeightUnit weightUnit = ScaleWeightUnit::UNKNOWN;
+  uint8_t autoModeStopCondition = 0;
+};
+
+// Fields a sample subscriber watches for changes, see SampleSubscriberOptions.
+enum ScaleChannel : uint8_t {
+  SCALE_CHANNEL_WEIGHT = 1 << 0,
+  SCALE_CHANNEL_FLOW = 1 << 1,
+  SCALE_CHANNEL_BATTERY = 1 << 2,
+  SCALE_CHANNEL_UNIT = 1 << 3,
+  SCALE_CHANNEL_ALL = 0x0F,
+};
+
+// Where a consumer's callback runs. INLINE calls it on the BLE host task from
+// inside the notification. The deferred modes hand each sample to the shared
+// RemoteScalesDispatcher task instead: LATEST_WINS keeps at most one sample
+// pending and overwrites it, so a slow consumer sees fewer but current
+// samples; LOSSLESS queues every sample in the scale's own dispatch queue and
+// drops, counted as DISPATCH_DROPS, only when that queue is full.
+enum class CallbackDispatch : uint8_t { INLINE, LATEST_WINS, LOSSLESS };
+
+// A subscriber gets a sample once minIntervalMs has passed since its last
+// delivery and a watched channel has moved since then: weight or flow by at
+// least deadband (g, g/s; any change when it is zero), battery or unit at all.
+// Watching every channel with no deadband takes every sample, changed or not,
+// which is what the defaults do, inline.
+struct SampleSubscriberOptions {
+  uint32_t minIntervalMs = 0;
+  float deadband = 0.f;
+  uint8_t channels = SCALE_CHANNEL_ALL;
+  CallbackDispatch dispatch = CallbackDispatch::INLINE;
+};
+
 class RemoteScales {
 
 public:
   using LogCallback = void (*)(std::string);
+  using CommandCallback = void (*)(ScaleCommand, ScaleCommandStatus);
+  using TareCallback = void (*)(TareState, uint32_t latencyMs);
 
   // Core weight (always available).
   float getWeight() const { return weight; }
@@ -42,35 +205,122 @@ public:
   // protected setters from their notification handler AND override the
   // matching hasX() virtuals to return true. Defaults are safe no-ops for the
   // drivers (Acaia, Decent, Felicita, Timemore, ...) that only parse weight.
-  float getFlowRate() const { return flowRate; }            // g/s, native from scale when available
+  float getFlowRate() const { return flowRate; }            // g/s, native from scale or estimated, see setFlowEstimation()
   uint8_t getBatteryLevel() const { return batteryLevel; }  // 0-100 %, or REMOTE_SCALES_BATTERY_UNKNOWN
   uint32_t getScaleTimerMs() const { return scaleTimerMs; } // scale's internal stopwatch
   ScaleWeightUnit getWeightUnit() const { return weightUnit; }
   uint8_t getAutoModeStopCondition() const { return autoModeStopCondition; } // driver-defined
 
+  // Local millis() at which the latest weight sample was taken. For scales that
+  // timestamp their frames (see hasScaleTimer()) this comes from the scale clock
+  // mapped onto local time, which removes BLE delivery jitter; otherwise, and
+  // while the scale's stopwatch is stopped, it is the arrival time.
+  uint32_t getSampleTimestampMs() const { return sampleTimestampMs; }
+  bool isSampleDatedByScale() const { return sampleDatedByScale; } // the scale-clock case above
+  bool isScaleClockSynchronized() const { return clockSync.isLocked(); }
+  float getScaleClockDriftPpm() const { return clockSync.getDriftPpm(); }
+
+  // Consistent view of the fields above, safe to call from any task or core
+  // without locking. The individual getters may mix fields from two frames
+  // while a notification is being decoded.
+  ScaleSnapshot getSnapshot() const { return snapshot.read(); }
+
   // Capability flags. Default false; each driver overrides to true for the
   // fields it actually parses. Consumers should check these before trusting
   // the corresponding getter.
-  virtual bool hasFlowRate() const { return false; }
+  virtual bool hasFlowRate() const { return flowEstimationEnabled; }
   virtual bool hasBatteryLevel() const { return false; }
   virtual bool hasScaleTimer() const { return false; }
   virtual bool hasWeightUnit() const { return false; }
   virtual bool hasAutoModeStopCondition() const { return false; }
   virtual bool hasTimerControl() const { return false; }
 
+  // Derive getFlowRate() from the weight stream for scales that don't report
+  // flow themselves, as the least-squares slope over the last windowSamples
+  // samples (see FlowEstimator). Native flow always wins once the driver
+  // reports it. Longer windows are smoother but lag by about half the window.
+  void setFlowEstimation(bool enabled, size_t windowSamples = 10);
+
+  // Stale-stream watchdog. A link that dies quietly (brown-out, out of range)
+  // keeps isConnected() true until the supervision timeout, several seconds
+  // during which the weight is frozen. The stream counts as stale once no
+  // sample has arrived for missedIntervals expected sample intervals (see
+  // getExpectedSampleIntervalMs()); with reconnect set, update() then drops
+  // the link and reconnects straight away instead of waiting for the stack.
+  void setStaleWatchdog(uint8_t missedIntervals, bool reconnect = false);
+  // Can be called from any task. Compares the stream age against the
+  // threshold the last update() published, which is zero while the watchdog
+  // is off or the scale is disconnected, so it is then always false.
+  bool isStale() const;
+  // Time since the latest sample, or since connect before the first one.
+  uint32_t getStreamAgeMs() const { return remoteScalesMillis() - lastStreamActivityMs; }
+
+  // Effective streaming rate and inter-sample jitter, reset on every connect.
+  SampleRateStats getSampleRateStats() const;
+  void resetSampleRateStats();
+
   void setWeightUpdatedCallback(void (*callback)(float), bool onlyChanges = false);
+  // Up to MAX_SAMPLE_SUBSCRIBERS consumers, each filtered on its own terms in
+  // one pass over a fixed table per sample and delivered per its own dispatch
+  // option. Subscribers may unsubscribe themselves; a deferred sample still
+  // queued for one that has left is discarded. Subscribing the same callback
+  // again updates its options. Returns false when the table is full.
+  using SampleCallback = void (*)(const ScaleSnapshot&);
+  static constexpr size_t MAX_SAMPLE_SUBSCRIBERS = 4;
+  bool subscribeSamples(SampleCallback callback, const SampleSubscriberOptions& options = {});
+  void unsubscribeSamples(SampleCallback callback);
+
+  // Policy for the weight callback. With a deferred policy the consumer span in
+  // getLatencyStats() covers only the hand-off, not the callback itself.
+  static constexpr size_t DISPATCH_QUEUE_CAPACITY = 16;
+  void setCallbackDispatch(CallbackDispatch dispatch);
+  CallbackDispatch getCallbackDispatch() const { return callbackDispatch; }
   void setLogCallback(LogCallback logCallback) { this->logCallback = logCallback; }
+  // Called from update() once each queued write completes, fails or expires.
+  void setCommandCallback(CommandCallback commandCallback) { this->commandCallback = commandCallback; }
+  // Called once per tare with CONFIRMED, FAILED or TIMED_OUT. May run on the
+  // BLE task when confirmation comes from a weight notification.
+  void setTareCallback(TareCallback tareCallback) { this->tareCallback = tareCallback; }
+  TareState getTareState() const { return tareState; }
+  TareLatencyStats getTareLatencyStats() const;
+
+  ScaleHealthCounters getHealthCounters() const;
+  void resetHealthCounters();
+  // One line, e.g. "ok=1200 crc=3 drop=41 resync=2 unknown=0 malformed=1 reconnect=0 wfail=0 ddrop=0".
+  std::string formatHealthCounters() const;
+
+  // Feeds bytes into the driver exactly as if the subscribed characteristic
+  // with this UUID had notified them, instrumentation included. Meant for
+  // replaying captured traces (see NotificationReplay); call it from the same
+  // task that would otherwise receive the notifications. Returns false if the
+  // driver has no subscription for the UUID.
+  bool injectNotification(const NimBLEUUID& characteristicUUID, uint8_t* data, size_t length);
+
+  // Off by default; costs two timer reads per notification when on.
+  void setLatencyInstrumentation(bool enabled) { latencyInstrumentation = enabled; }
+  NotificationLatencyStats getLatencyStats() const;
+  void resetLatencyStats();
 
   std::string getDeviceName() const { return device.getName(); }
   std::string getDeviceAddress() const { return device.getAddress().toString(); }
   int getRSSI() const { return client != nullptr ? client->getRssi() : 0; }
+  BLEConnectionParamsReport getConnectionParams() const;
 
+  // tare() and the timer controls only queue their writes and return
+  // immediately; the writes go out from update(). A false return means the
+  // command could not be queued, write failures arrive via the command callback.
   virtual bool tare() = 0;
   virtual bool isConnected() = 0;
   virtual bool connect() = 0;
   virtual void disconnect() = 0;
   virtual void update() = 0;
 
+  // How long the caller may sleep before update() next has work: the next
+  // periodic task such as a heartbeat, the pending tare's timeout, or 0 while
+  // writes are queued. Notifications and disconnects can create work sooner
+  // (a tare acknowledgement, a reconnect), so cap the sleep to taste.
+  uint32_t getMsUntilNextUpdate();
+
   // Optional timer controls. Drivers that can drive the scale's internal
   // stopwatch over BLE should override these AND return true from
   // hasTimerControl(). Defaults are no-ops so non-Bookoo drivers don't need
@@ -81,7 +331,9 @@ public:
 
   virtual ~RemoteScales() noexcept {
     try {
+      // Cleanup first so no notification schedules new work meanwhile.
       clientCleanup();
+      cancelDeferredCallbacks();
     } catch (...) {
       // Swallow: destructors must not propagate exceptions (noexcept guarantee).
       // clientCleanup calls into NimBLE stack which in practice doesn't throw,
@@ -97,23 +349,114 @@ protected:
   bool clientIsConnected();
   NimBLERemoteService* clientGetService(const NimBLEUUID uuid);
 
+  // Drivers subscribe through here rather than on the characteristic so every
+  // notification passes the library's instrumentation before the driver sees it.
+  // Returns false, leaving the characteristic unsubscribed, when it refuses or
+  // MAX_SUBSCRIPTIONS other characteristics are already subscribed.
+  using NotifyCallback = std::function<void(NimBLERemoteCharacteristic*, uint8_t*, size_t, bool)>;
+  static constexpr size_t MAX_SUBSCRIPTIONS = 4;
+  bool subscribe(NimBLERemoteCharacteristic* characteristic, NotifyCallback callback, bool notifications = true, bool response = false);
+
+  // Outbound command queue. Writes are copied, identical pending writes are
+  // coalesced, and update() sends at most COMMAND_BURST_LIMIT per call so a
+  // backlog never stalls the caller for more than a few round trips.
+  static constexpr size_t MAX_COMMAND_LENGTH = 20;
+  static constexpr size_t COMMAND_QUEUE_CAPACITY = 8;
+  static constexpr size_t COMMAND_BURST_LIMIT = 4;
+  static constexpr uint32_t COMMAND_TIMEOUT_MS = 1000;
+  static constexpr uint32_t TARE_TIMEOUT_MS = 3000;
+
+  bool sendCommand(ScaleCommand command, NimBLERemoteCharacteristic* characteristic, const uint8_t* data, size_t length, bool withResponse = false);
+  bool sendCommand(ScaleCommand command, NimBLERemoteDescriptor* descriptor, const uint8_t* data, size_t length, bool withResponse = true);
+  void processCommandQueue();
+
+  // Stale-stream check and fast reconnect (see setStaleWatchdog()). Drivers
+  // call it from update() only; it may reconnect, so never from disconnect().
+  void serviceStaleWatchdog();
+
+  // For drivers whose protocol acknowledges a completed tare. Without it the
+  // tare is confirmed by the first sample within getTareTolerance() of zero.
+  void confirmTare();
+  virtual float getTareTolerance() const { return 0.2f; }
+
+  // Connection parameters requested for this scale. The default asks for a
+  // 15-30 ms interval instead of NimBLE's 30-50 ms, which directly shortens
+  // weight-to-pump-stop latency. Drivers whose peripherals misbehave at short
+  // intervals can override this, or return {} to keep the stack defaults.
+  virtual BLEConnectionParams getPreferredConnectionParams() const {
+    return BLEConnectionParams{ .minInterval = 12, .maxInterval = 24, .latency = 0, .supervisionTimeout = 256 };
+  }
+
+  // Sample interval the stale watchdog assumes until it has measured the real
+  // one. Drivers whose scales stream much slower than 10 Hz should override.
+  virtual uint32_t getExpectedSampleIntervalMs() const { return 100; }
+  static constexpr uint32_t STALE_MIN_MS = 250;
+  static constexpr uint32_t STALE_FIRST_SAMPLE_GRACE_MS = 3000;
+  static constexpr uint32_t STALE_RECONNECT_BACKOFF_MS = 2000;
+
+  // Periodic driver work such as heartbeats and polls. Register from the
+  // constructor; periods restart on every connect, and the tasks run from
+  // runPeriodicTasks(), which the driver calls from update().
+  static constexpr size_t MAX_PERIODIC_TASKS = 4;
+  bool schedulePeriodic(uint32_t periodMs, PeriodicScheduler<MAX_PERIODIC_TASKS>::Task task) {
+    return periodicTasks.add(periodMs, task, remoteScalesMillis());
+  }
+  void runPeriodicTasks() { periodicTasks.run(remoteScalesMillis()); }
+
   void setWeight(float newWeight);
 
+  void countHealth(ScaleHealthCounter counter, uint32_t amount = 1) {
+    healthCounters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+  }
+
   // Setters for optional fields. Drivers that parse these call from their
-  // notification handler. Stored centrally so consumers can read via the
-  // public getters without caring which driver the scale is.
-  void setFlowRate(float newFlow) { flowRate = newFlow; }
+  // notification handler, before setWeight() for the same frame so the
+  // snapshot it publishes is complete. Stored centrally so consumers can read
+  // via the public getters without caring which driver the scale is.
+  void setFlowRate(float newFlow) { flowRate = newFlow; nativeFlowRate = true; }
   void setBatteryLevel(uint8_t pct) { batteryLevel = pct; }
-  void setScaleTimerMs(uint32_t t) { scaleTimerMs = t; }
+  // Call before setWeight() for the same frame so the sample gets the scale's
+  // timestamp. It only does while the timer advances; a timer that arrives in
+  // frames of its own passes datesWeight = false and just feeds the clock sync.
+  void setScaleTimerMs(uint32_t t, bool datesWeight = true);
   void setWeightUnit(ScaleWeightUnit u) { weightUnit = u; }
   void setAutoModeStopCondition(uint8_t c) { autoModeStopCondition = c; }
 
-  void log(std::string msgFormat, ...);
+  // Both are free when no log callback is set: no formatting, and the hex dump
+  // comes back empty without touching the heap, so drivers can leave them on
+  // the notification path.
+  void log(const char* msgFormat, ...);
   std::string byteArrayToHexString(const uint8_t* byteArray, size_t length);
 
 private:
   using WeightCallback = void (*)(float);
 
+  struct Subscription {
+    NimBLERemoteCharacteristic* characteristic;
+    NotifyCallback callback;
+  };
+
+  struct SampleSubscriber {
+    std::atomic<SampleCallback> callback{ nullptr };
+    SampleSubscriberOptions options;
+    bool delivered = false;
+    uint32_t lastDeliveredMs = 0;
+    float lastWeight = 0.f;
+    float lastFlowRate = 0.f;
+    uint8_t lastBatteryLevel = 0;
+    ScaleWeightUnit lastWeightUnit = ScaleWeightUnit::UNKNOWN;
+  };
+
+  struct PendingCommand {
+    ScaleCommand command;
+    NimBLERemoteCharacteristic* characteristic;
+    NimBLERemoteDescriptor* descriptor;
+    bool withResponse;
+    uint8_t length;
+    uint8_t data[MAX_COMMAND_LENGTH];
+    uint32_t deadlineMs;
+  };
+
   float weight = 0.f;
   float flowRate = 0.0f;
   uint8_t batteryLevel = REMOTE_SCALES_BATTERY_UNKNOWN;
@@ -121,11 +464,114 @@ private:
   ScaleWeightUnit weightUnit = ScaleWeightUnit::UNKNOWN;
   uint8_t autoModeStopCondition = 0;
 
+  bool flowEstimationEnabled = false;
+  bool nativeFlowRate = false;
+  FlowEstimator flowEstimator;
+
+  ScaleClockSync clockSync;
+  bool scaleTimerFresh = false;
+  uint32_t sampleTimestampMs = 0;
+  bool sampleDatedByScale = false;
+
+  SeqLock<ScaleSnapshot> snapshot;
+  uint32_t publishedSamples = 0;
+  ScaleSnapshot publishSnapshot();
+
+  SampleSubscriber sampleSubscribers[MAX_SAMPLE_SUBSCRIBERS];
+  void notifySampleSubscribers(const ScaleSnapshot& sample, uint32_t now);
+  static bool wantsSample(const SampleSubscriber& subscriber, const ScaleSnapshot& sample, uint32_t now);
+
+  LogHistogram sampleGapsMs;
+  bool hasSampleArrival = false;
+  uint32_t firstSampleMs = 0;
+  uint32_t lastSampleMs = 0;
+  float recentGapMs = 0.f;
+
+  std::atomic<uint32_t> healthCounters[static_cast<size_t>(ScaleHealthCounter::COUNT)] = {};
+  bool hasConnected = false;
+
+  Subscription subscriptions[MAX_SUBSCRIPTIONS];
+  size_t subscriptionCount = 0;
+
+  bool latencyInstrumentation = false;
+  bool notificationInFlight = false;
+  bool decodingNotification = false;
+  uint32_t notificationEntryUs = 0;
+  LogHistogram decodeLatencyUs;
+  LogHistogram consumerLatencyUs;
+  LogHistogram totalLatencyUs;
+
+  void recordSampleArrival(uint32_t now);
+  void requestPreferredConnectionParams();
+  bool enqueueCommand(ScaleCommand command, NimBLERemoteCharacteristic* characteristic, NimBLERemoteDescriptor* descriptor,
+    const uint8_t* data, size_t length, bool withResponse);
+  void clearCommandQueue();
+  void completeCommand(ScaleCommand command, ScaleCommandStatus status);
+  void finishTare(TareState result);
+
   NimBLEClient* client = nullptr;
+  bool connectionParamsRequested = false;
   DiscoveredDevice device;
   LogCallback logCallback = nullptr;
+  CommandCallback commandCallback = nullptr;
+  TareCallback tareCallback = nullptr;
+
+  std::atomic<TareState> tareState{ TareState::IDLE };
+  // pendingTareWrites is guarded by commandQueueMutex; setWeight() reads
+  // tareWritesDone on the BLE task without it.
+  std::atomic<bool> tareWritesDone{ false };
+  uint8_t pendingTareWrites = 0;
+  uint32_t tareStartedMs = 0;
+  LogHistogram tareLatenciesMs;
+  uint32_t tareLastMs = 0;
+  uint32_t taresFailed = 0;
+  uint32_t taresTimedOut = 0;
+
+  PeriodicScheduler<MAX_PERIODIC_TASKS> periodicTasks;
+
+  uint8_t staleMissedIntervals = 0;
+  bool staleReconnect = false;
+  bool watchdogReconnecting = false;
+  bool reportedStale = false;
+  std::atomic<bool> awaitingFirstSample{ true };
+  std::atomic<uint32_t> lastStreamActivityMs{ 0 };
+  std::atomic<uint32_t> staleThresholdMs{ 0 };
+  bool hasWatchdogReconnected = false;
+  bool watchdogReconnectFailed = false;
+  uint32_t lastWatchdogReconnectMs = 0;
+  uint32_t getStaleThresholdMs() const;
+
+  std::mutex commandQueueMutex;
+  PendingCommand commandQueue[COMMAND_QUEUE_CAPACITY];
+  size_t commandQueueHead = 0;
+  size_t commandQueueSize = 0;
   WeightCallback weightCallback = nullptr;
   bool weightCallbackOnlyChanges = false;
+
+  std::atomic<CallbackDispatch> callbackDispatch{ CallbackDispatch::INLINE };
+
+  // Samples waiting for the dispatcher task. Consumer 0 is the weight
+  // callback, 1.. the sample subscribers; callback is the subscriber's at the
+  // time of queueing, so a sample for one that has since left is discarded.
+  static constexpr uint8_t WEIGHT_CONSUMER = 0;
+  static constexpr size_t DISPATCH_CONSUMERS = 1 + MAX_SAMPLE_SUBSCRIBERS;
+  static constexpr size_t DISPATCH_BATCH = DISPATCH_QUEUE_CAPACITY + DISPATCH_CONSUMERS;
+  struct DeferredSample {
+    uint8_t consumer;
+    SampleCallback callback;
+    ScaleSnapshot sample;
+  };
+  std::mutex dispatchMutex;
+  DeferredSample dispatchQueue[DISPATCH_QUEUE_CAPACITY];
+  size_t dispatchQueueHead = 0;
+  size_t dispatchQueueSize = 0;
+  DeferredSample latestSamples[DISPATCH_CONSUMERS];
+  bool latestPending[DISPATCH_CONSUMERS] = {};
+  bool dispatchScheduled = false;
+  void deferSample(uint8_t consumer, SampleCallback callback, CallbackDispatch dispatch, const ScaleSnapshot& sample);
+  void deliverDeferred(const DeferredSample& deferred);
+  void cancelDeferredCallbacks();
+  static void runDeferredCallbacks(void* context);
 };
 
 // ---------------------------------------------------------------------------------------
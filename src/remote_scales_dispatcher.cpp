@@ -0,0 +1,108 @@
+#include "remote_scales_dispatcher.h"
+
+// ---------------------------------------------------------------------------------------
+// ------------------------   RemoteScalesDispatcher    -----------------------------------
+// ---------------------------------------------------------------------------------------
+RemoteScalesDispatcher* RemoteScalesDispatcher::instance = nullptr;
+
+bool RemoteScalesDispatcher::post(Job job, void* context) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((!started && !start()) || size == CAPACITY) {
+      dropped++;
+      return false;
+    }
+    entries[(head + size) % CAPACITY] = Entry{ job, context };
+    size++;
+  }
+
+#if defined(ESP_PLATFORM)
+  xTaskNotifyGive(task);
+#else
+  wake.notify_one();
+#endif
+  return true;
+}
+
+void RemoteScalesDispatcher::cancel(void* context) {
+  std::unique_lock<std::mutex> lock(mutex);
+  removeJobs(context);
+  if (onDispatcherTask()) {
+    return;
+  }
+  idle.wait(lock, [this, context]() { return runningContext != context; });
+  // The job that was running may have posted its successor before returning.
+  removeJobs(context);
+}
+
+void RemoteScalesDispatcher::removeJobs(void* context) {
+  for (size_t i = 0; i < size; i++) {
+    Entry& entry = entries[(head + i) % CAPACITY];
+    if (entry.context == context) {
+      entry.job = nullptr;
+    }
+  }
+}
+
+bool RemoteScalesDispatcher::start() {
+#if defined(ESP_PLATFORM)
+  // Left unstarted on failure, so the next post() tries again.
+  if (xTaskCreate(&RemoteScalesDispatcher::taskEntry, "scales-dispatch", TASK_STACK_SIZE, this, TASK_PRIORITY, &task) != pdPASS) {
+    task = nullptr;
+    return false;
+  }
+#else
+  thread = std::thread([this]() { run(); });
+  thread.detach();
+#endif
+  started = true;
+  return true;
+}
+
+bool RemoteScalesDispatcher::onDispatcherTask() const {
+#if defined(ESP_PLATFORM)
+  return xTaskGetCurrentTaskHandle() == task;
+#else
+  return std::this_thread::get_id() == thread.get_id();
+#endif
+}
+
+#if defined(ESP_PLATFORM)
+void RemoteScalesDispatcher::taskEntry(void* self) {
+  static_cast<RemoteScalesDispatcher*>(self)->run();
+}
+#endif
+
+void RemoteScalesDispatcher::run() {
+  while (true) {
+    Entry entry;
+    {
+#if defined(ESP_PLATFORM)
+      std::unique_lock<std::mutex> lock(mutex);
+      while (size == 0) {
+        lock.unlock();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        lock.lock();
+      }
+#else
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [this]() { return size > 0; });
+#endif
+      entry = entries[head];
+      head = (head + 1) % CAPACITY;
+      size--;
+      if (entry.job == nullptr) {
+        continue; // cancelled
+      }
+      runningContext = entry.context;
+    }
+
+    entry.job(entry.context);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      runningContext = nullptr;
+    }
+    idle.notify_all();
+  }
+}
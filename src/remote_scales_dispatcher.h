@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <condition_variable>
+#include <mutex>
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+// Runs consumer callbacks on a library-owned task so that slow consumers
+// never hold up the NimBLE host task. Shared by all scales; started on the
+// first post(). A FreeRTOS task on device, a std::thread elsewhere.
+//
+// Jobs live in a fixed ring under a mutex rather than in a FreeRTOS queue so
+// that cancel() can pull a scale's pending jobs out before it is destroyed.
+// The ring carries wake-ups, not samples: each scale buffers its own samples
+// and keeps at most one job here, so a busy scale cannot crowd out the rest.
+class RemoteScalesDispatcher {
+public:
+  using Job = void (*)(void* context);
+
+  static constexpr size_t CAPACITY = 32;
+  static constexpr uint32_t TASK_STACK_SIZE = 4096;
+  static constexpr uint32_t TASK_PRIORITY = 1;
+
+  static RemoteScalesDispatcher* getInstance() {
+    if (instance == nullptr) {
+      instance = new RemoteScalesDispatcher();
+    }
+    return instance;
+  }
+
+  RemoteScalesDispatcher(RemoteScalesDispatcher& other) = delete;
+  void operator=(const RemoteScalesDispatcher&) = delete;
+
+  // Returns false, and counts a drop, when the ring is full or the task
+  // could not be started.
+  bool post(Job job, void* context);
+
+  // Removes every queued job for context and blocks until one that is already
+  // running returns, then removes any job that one posted. Safe to call from
+  // inside a job.
+  void cancel(void* context);
+
+  uint32_t getDropped() const { return dropped; }
+
+private:
+  struct Entry {
+    Job job;
+    void* context;
+  };
+
+  static RemoteScalesDispatcher* instance;
+  RemoteScalesDispatcher() {}  // Private constructor to enforce singleton
+
+  std::mutex mutex;
+  Entry entries[CAPACITY] = {};
+  size_t head = 0;
+  size_t size = 0;
+  void* runningContext = nullptr;
+  uint32_t dropped = 0;
+  bool started = false;
+  // Signalled each time a job returns, for cancel().
+  std::condition_variable idle;
+
+#if defined(ESP_PLATFORM)
+  TaskHandle_t task = nullptr;
+  static void taskEntry(void* self);
+#else
+  std::thread thread;
+  std::condition_variable wake;
+#endif
+
+  bool start();
+  bool onDispatcherTask() const;
+  void removeJobs(void* context);
+  void run();
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Time and delay primitives for the core and the drivers. Everything that
+// needs a clock goes through here rather than calling Arduino directly, so
+// a build without the Arduino core only has to satisfy this header, and a
+// RemoteScalesClock installed with setInstance() replaces time for all of it.
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+#if defined(ESP_PLATFORM)
+#include <esp_timer.h>
+#endif
+
+// Replacement time source, e.g. SimulatedRemoteScalesClock for running hours
+// of heartbeats and timeouts in a host test. Install it before connecting and
+// keep it alive until it is removed again with setInstance(nullptr).
+class RemoteScalesClock {
+public:
+  virtual ~RemoteScalesClock() {}
+  virtual uint32_t millis() = 0;
+  virtual uint32_t micros() = 0;
+  virtual void delay(uint32_t ms) = 0;
+
+  static RemoteScalesClock* getInstance() { return instance.load(std::memory_order_acquire); }
+  static void setInstance(RemoteScalesClock* clock) { instance.store(clock, std::memory_order_release); }
+
+private:
+  static inline std::atomic<RemoteScalesClock*> instance{ nullptr };
+};
+
+// Time that only moves when told to. delay() advances it instead of blocking,
+// so driver code that waits returns immediately with the clock moved on.
+class SimulatedRemoteScalesClock : public RemoteScalesClock {
+public:
+  explicit SimulatedRemoteScalesClock(uint64_t startUs = 0) : nowUs(startUs) {}
+
+  uint32_t millis() override { return static_cast<uint32_t>(nowUs.load() / 1000); }
+  uint32_t micros() override { return static_cast<uint32_t>(nowUs.load()); }
+  void delay(uint32_t ms) override { advanceMs(ms); }
+
+  void advanceMs(uint32_t ms) { nowUs += uint64_t(ms) * 1000; }
+  void advanceUs(uint32_t us) { nowUs += us; }
+
+private:
+  std::atomic<uint64_t> nowUs;
+};
+
+inline uint32_t remoteScalesMillis() {
+  if (RemoteScalesClock* clock = RemoteScalesClock::getInstance()) return clock->millis();
+#if defined(ARDUINO)
+  return millis();
+#else
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Truncated to 32 bits; only use differences, which stay valid for ~71 minutes.
+inline uint32_t remoteScalesMicros() {
+  if (RemoteScalesClock* clock = RemoteScalesClock::getInstance()) return clock->micros();
+#if defined(ESP_PLATFORM)
+  return static_cast<uint32_t>(esp_timer_get_time());
+#elif defined(ARDUINO)
+  return micros();
+#else
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Real elapsed time for profiling. An installed RemoteScalesClock does not
+// replace it, since under a simulated clock all decode work would cost nothing.
+inline uint64_t remoteScalesWallNanos() {
+#if defined(ESP_PLATFORM)
+  return static_cast<uint64_t>(esp_timer_get_time()) * 1000;
+#elif defined(ARDUINO)
+  return static_cast<uint64_t>(micros()) * 1000;
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline void remoteScalesDelay(uint32_t ms) {
+  if (RemoteScalesClock* clock = RemoteScalesClock::getInstance()) return clock->delay(ms);
+#if defined(ARDUINO)
+  delay(ms);
+#else
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
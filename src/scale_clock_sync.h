@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Online mapping from a scale's millisecond clock onto local millis().
+// Each (scale time, arrival time) pair satisfies arrival = offset + rate * scale
+// + BLE delay, where the delay is never negative and carries all the jitter.
+// Keeping only the minimum-delay pair per block strips most of that jitter, and
+// a least-squares line through the last few block minima tracks both offset and
+// crystal drift. Everything is relative to the first pair after reset() so the
+// float maths keeps millisecond precision for hours.
+class ScaleClockSync {
+public:
+  static constexpr size_t BLOCKS = 8;
+  static constexpr uint32_t BLOCK_MS = 2000;
+  // A scale clock step that disagrees with local time by more than this is a
+  // restarted stopwatch or a dropped link, not jitter.
+  static constexpr uint32_t MAX_STEP_ERROR_MS = 1000;
+  static constexpr float MAX_DRIFT = 0.002f; // 2000 ppm; anything beyond is a bad fit
+
+  void reset() {
+    started = false;
+    blockCount = 0;
+    nextBlock = 0;
+    rate = 1.f;
+    offset = 0.f;
+  }
+
+  void update(uint32_t scaleMs, uint32_t localMs) {
+    if (!started) {
+      start(scaleMs, localMs);
+      return;
+    }
+    if (scaleMs == lastScaleMs) {
+      return; // stopwatch not running; nothing new to learn
+    }
+
+    int32_t scaleStep = static_cast<int32_t>(scaleMs - lastScaleMs);
+    int32_t localStep = static_cast<int32_t>(localMs - lastLocalMs);
+    int32_t stepError = scaleStep - localStep;
+    if (scaleStep < 0 || stepError > static_cast<int32_t>(MAX_STEP_ERROR_MS) || -stepError > static_cast<int32_t>(MAX_STEP_ERROR_MS)) {
+      start(scaleMs, localMs);
+      return;
+    }
+    lastScaleMs = scaleMs;
+    lastLocalMs = localMs;
+
+    Point point{ static_cast<int32_t>(scaleMs - anchorScaleMs), static_cast<int32_t>(localMs - anchorLocalMs) };
+    if (point.y - point.x < current.y - current.x) {
+      current = point;
+    }
+
+    if (localMs - blockStartMs >= BLOCK_MS) {
+      blocks[nextBlock] = current;
+      nextBlock = (nextBlock + 1) % BLOCKS;
+      if (blockCount < BLOCKS) blockCount++;
+      fit();
+      blockStartMs = localMs;
+      current = point;
+    }
+  }
+
+  // At least one full block of minima has been collected.
+  bool isLocked() const { return blockCount > 0; }
+
+  // Local time at which the scale produced scaleMs. Only meaningful when locked.
+  uint32_t toLocal(uint32_t scaleMs) const {
+    float x = static_cast<float>(static_cast<int32_t>(scaleMs - anchorScaleMs));
+    float y = offset + rate * x;
+    return anchorLocalMs + static_cast<int32_t>(y >= 0.f ? y + 0.5f : y - 0.5f);
+  }
+
+  // Minimum observed BLE delay folded into the offset at the current time.
+  int32_t getOffsetMs() const { return static_cast<int32_t>(anchorLocalMs - anchorScaleMs) + static_cast<int32_t>(offset); }
+  float getDriftPpm() const { return (rate - 1.f) * 1e6f; }
+
+private:
+  struct Point {
+    int32_t x; // scale time since anchor
+    int32_t y; // arrival time since anchor
+  };
+
+  bool started = false;
+  uint32_t anchorScaleMs = 0;
+  uint32_t anchorLocalMs = 0;
+  uint32_t lastScaleMs = 0;
+  uint32_t lastLocalMs = 0;
+  uint32_t blockStartMs = 0;
+  Point current{};
+  Point blocks[BLOCKS] = {};
+  size_t blockCount = 0;
+  size_t nextBlock = 0;
+  float rate = 1.f;
+  float offset = 0.f;
+
+  void start(uint32_t scaleMs, uint32_t localMs) {
+    reset();
+    started = true;
+    anchorScaleMs = scaleMs;
+    anchorLocalMs = localMs;
+    lastScaleMs = scaleMs;
+    lastLocalMs = localMs;
+    blockStartMs = localMs;
+    current = Point{ 0, 0 };
+  }
+
+  void fit() {
+    float meanX = 0.f;
+    float meanY = 0.f;
+    for (size_t i = 0; i < blockCount; i++) {
+      meanX += blocks[i].x;
+      meanY += blocks[i].y;
+    }
+    meanX /= blockCount;
+    meanY /= blockCount;
+
+    float covariance = 0.f;
+    float variance = 0.f;
+    for (size_t i = 0; i < blockCount; i++) {
+      float dx = blocks[i].x - meanX;
+      covariance += dx * (blocks[i].y - meanY);
+      variance += dx * dx;
+    }
+
+    rate = variance > 0.f ? covariance / variance : 1.f;
+    if (rate > 1.f + MAX_DRIFT || rate < 1.f - MAX_DRIFT) {
+      rate = 1.f;
+    }
+    offset = meanY - rate * meanX;
+  }
+};
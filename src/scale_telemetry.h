@@ -0,0 +1,231 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <frame_reassembler.h>
+
+// Binary telemetry for one or more scales, e.g. over Serial to a PC.
+//
+// Packet layout, little-endian:
+//   [0-1]  magic 0xA5 0x5A
+//   [2-3]  sequence number, +1 per packet, so the receiver can count losses
+//   [4]    sample count N
+//   [5-8]  timestamp of the first sample, ms
+//   then N samples of 9 bytes:
+//     [0]    scale id
+//     [1-2]  ms after the packet timestamp
+//     [3-6]  weight, 0.01 g
+//     [7-8]  flow rate, 0.01 g/s
+//   [last 2] CRC-16/CCITT over everything after the magic
+//
+// At 100 Hz that is about 1 KB/s, against roughly 3 KB/s for a text line
+// per sample.
+struct TelemetrySample {
+  uint8_t scale = 0;
+  uint32_t timestampMs = 0;
+  float weight = 0.f;
+  float flowRate = 0.f;
+};
+
+namespace scale_telemetry {
+  constexpr uint8_t MAGIC_0 = 0xA5;
+  constexpr uint8_t MAGIC_1 = 0x5A;
+  constexpr size_t HEADER_LENGTH = 9;
+  constexpr size_t SAMPLE_LENGTH = 9;
+  constexpr size_t CRC_LENGTH = 2;
+  constexpr size_t MAX_SAMPLES_PER_PACKET = 16;
+  constexpr size_t MAX_PACKET_LENGTH = HEADER_LENGTH + MAX_SAMPLES_PER_PACKET * SAMPLE_LENGTH + CRC_LENGTH;
+
+  inline uint16_t crc16(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+      crc ^= static_cast<uint16_t>(data[i]) << 8;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+      }
+    }
+    return crc;
+  }
+
+  inline void put16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+  }
+  inline void put32(uint8_t* out, uint32_t value) {
+    put16(out, value & 0xFFFF);
+    put16(out + 2, value >> 16);
+  }
+  inline uint16_t get16(const uint8_t* in) { return in[0] | (in[1] << 8); }
+  inline uint32_t get32(const uint8_t* in) { return get16(in) | (static_cast<uint32_t>(get16(in + 2)) << 16); }
+
+  // Saturating, so an out-of-range value can't wrap into a plausible one.
+  inline int32_t centi(float value, int32_t limit) {
+    if (value != value) return 0;
+    float scaled = roundf(value * 100.f);
+    if (scaled > limit) return limit;
+    if (scaled < -limit) return -limit;
+    return static_cast<int32_t>(scaled);
+  }
+}
+
+// Collects samples from one producer task and writes them as packets to an
+// Output with write(const uint8_t*, size_t), such as Arduino's Serial or any
+// Stream. add() is wait-free and meant for the notification path (a sample
+// subscriber, say); poll() does the batching and writing from the loop, so
+// the BLE task never blocks on the UART. The ring is single-producer: calls
+// to add() from two tasks at once, e.g. two scales' BLE callbacks on
+// different cores, must be serialised by the caller.
+template <typename Output, size_t RING_CAPACITY = 64>
+class ScaleTelemetryExporter {
+public:
+  // A partial packet goes out once its oldest sample is maxBatchMs old.
+  explicit ScaleTelemetryExporter(Output& output, uint32_t maxBatchMs = 50) : output(output), maxBatchMs(maxBatchMs) {}
+
+  // Returns false, and counts the sample as dropped, when the ring is full.
+  bool add(const TelemetrySample& sample) {
+    size_t head = this->head.load(std::memory_order_relaxed);
+    size_t next = (head + 1) % RING_CAPACITY;
+    if (next == tail.load(std::memory_order_acquire)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    ring[head] = sample;
+    this->head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Moves queued samples into packets and writes every full or overdue one.
+  void poll(uint32_t nowMs) {
+    size_t tail = this->tail.load(std::memory_order_relaxed);
+    while (tail != head.load(std::memory_order_acquire)) {
+      const TelemetrySample& sample = ring[tail];
+      if (count > 0 && sample.timestampMs - packetTimestampMs > 0xFFFF) {
+        flush();
+      }
+      append(sample);
+      tail = (tail + 1) % RING_CAPACITY;
+      this->tail.store(tail, std::memory_order_release);
+      if (count == scale_telemetry::MAX_SAMPLES_PER_PACKET) {
+        flush();
+      }
+    }
+    if (count > 0 && nowMs - packetTimestampMs >= maxBatchMs) {
+      flush();
+    }
+  }
+
+  // Writes the pending partial packet, if any.
+  void flush() {
+    if (count == 0) return;
+    packet[0] = scale_telemetry::MAGIC_0;
+    packet[1] = scale_telemetry::MAGIC_1;
+    scale_telemetry::put16(packet + 2, sequence++);
+    packet[4] = count;
+    scale_telemetry::put32(packet + 5, packetTimestampMs);
+    size_t length = scale_telemetry::HEADER_LENGTH + count * scale_telemetry::SAMPLE_LENGTH;
+    scale_telemetry::put16(packet + length, scale_telemetry::crc16(packet + 2, length - 2));
+    output.write(packet, length + scale_telemetry::CRC_LENGTH);
+    packets++;
+    count = 0;
+  }
+
+  uint32_t getPacketsWritten() const { return packets; }
+  uint32_t getDroppedSamples() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+  Output& output;
+  uint32_t maxBatchMs;
+
+  TelemetrySample ring[RING_CAPACITY];
+  std::atomic<size_t> head{ 0 };
+  std::atomic<size_t> tail{ 0 };
+  std::atomic<uint32_t> dropped{ 0 };
+
+  uint8_t packet[scale_telemetry::MAX_PACKET_LENGTH];
+  uint8_t count = 0;
+  uint32_t packetTimestampMs = 0;
+  uint16_t sequence = 0;
+  uint32_t packets = 0;
+
+  void append(const TelemetrySample& sample) {
+    if (count == 0) {
+      packetTimestampMs = sample.timestampMs;
+    }
+    uint8_t* out = packet + scale_telemetry::HEADER_LENGTH + count * scale_telemetry::SAMPLE_LENGTH;
+    out[0] = sample.scale;
+    scale_telemetry::put16(out + 1, static_cast<uint16_t>(sample.timestampMs - packetTimestampMs));
+    scale_telemetry::put32(out + 3, static_cast<uint32_t>(scale_telemetry::centi(sample.weight, 2000000000)));
+    scale_telemetry::put16(out + 7, static_cast<uint16_t>(scale_telemetry::centi(sample.flowRate, 32767)));
+    count++;
+  }
+};
+
+// Receiving side, for the host tool or a second board: feed it the byte
+// stream in whatever pieces it arrives and it calls back once per sample.
+// A packet failing its CRC is counted and only its first magic byte dropped,
+// so a good packet that starts inside a truncated one is still found;
+// sequence gaps are counted as lost packets.
+class ScaleTelemetryDecoder {
+public:
+  using SampleCallback = void (*)(const TelemetrySample& sample, void* context);
+
+  ScaleTelemetryDecoder(SampleCallback callback, void* context = nullptr) : callback(callback), context(context) {}
+
+  void feed(const uint8_t* data, size_t length) {
+    discarded += packets.feed(data, length,
+      [](const uint8_t* packet, size_t available) -> int32_t {
+        if (packet[0] != scale_telemetry::MAGIC_0) return -1;
+        if (available < 2) return 0;
+        if (packet[1] != scale_telemetry::MAGIC_1) return -1;
+        if (available < 5) return 0;
+        if (packet[4] == 0 || packet[4] > scale_telemetry::MAX_SAMPLES_PER_PACKET) return -1;
+        return scale_telemetry::HEADER_LENGTH + packet[4] * scale_telemetry::SAMPLE_LENGTH + scale_telemetry::CRC_LENGTH;
+      },
+      [this](const uint8_t* packet, size_t length) { return handlePacket(packet, length); });
+  }
+
+  uint32_t getPackets() const { return received; }
+  uint32_t getLostPackets() const { return lost; }
+  uint32_t getCrcErrors() const { return crcErrors; }
+  uint32_t getBytesDiscarded() const { return discarded; }
+
+private:
+  SampleCallback callback;
+  void* context;
+  FrameReassembler<scale_telemetry::MAX_PACKET_LENGTH> packets;
+  bool hasSequence = false;
+  uint16_t nextSequence = 0;
+  uint32_t received = 0;
+  uint32_t lost = 0;
+  uint32_t crcErrors = 0;
+  uint32_t discarded = 0;
+
+  bool handlePacket(const uint8_t* packet, size_t length) {
+    size_t crcOffset = length - scale_telemetry::CRC_LENGTH;
+    if (scale_telemetry::crc16(packet + 2, crcOffset - 2) != scale_telemetry::get16(packet + crcOffset)) {
+      crcErrors++;
+      return false;
+    }
+
+    uint16_t sequence = scale_telemetry::get16(packet + 2);
+    if (hasSequence) {
+      lost += static_cast<uint16_t>(sequence - nextSequence);
+    }
+    hasSequence = true;
+    nextSequence = sequence + 1;
+    received++;
+
+    uint32_t packetTimestampMs = scale_telemetry::get32(packet + 5);
+    for (uint8_t i = 0; i < packet[4]; i++) {
+      const uint8_t* in = packet + scale_telemetry::HEADER_LENGTH + i * scale_telemetry::SAMPLE_LENGTH;
+      TelemetrySample sample;
+      sample.scale = in[0];
+      sample.timestampMs = packetTimestampMs + scale_telemetry::get16(in + 1);
+      sample.weight = static_cast<int32_t>(scale_telemetry::get32(in + 3)) / 100.f;
+      sample.flowRate = static_cast<int16_t>(scale_telemetry::get16(in + 7)) / 100.f;
+      callback(sample, context);
+    }
+    return true;
+  }
+};
@@ -38,7 +38,12 @@ enum class AcaiaEventKey : uint8_t {
 
 const size_t HEADER_LENGTH = 3;
 const size_t CHECKSUM_LENGTH = 2;
-const size_t MIN_MESSAGE_LENGTH = HEADER_LENGTH + CHECKSUM_LENGTH + 1;
+// Payload sizes (length byte included) below which a field would be read
+// past the end of the message.
+const size_t EVENT_MIN_PAYLOAD = 2;
+const size_t WEIGHT_EVENT_MIN_PAYLOAD = 2 + 6;
+const size_t TIMER_EVENT_MIN_PAYLOAD = 2 + 3;
+const size_t STATUS_MIN_PAYLOAD = 3;
 
 const NimBLEUUID serviceUUID("49535343-fe7d-4ae5-8fa9-9fafd205e455");
 const NimBLEUUID weightCharacteristicUUID("49535343-1e4d-4bd9-ba61-23c647249616");
@@ -55,7 +60,9 @@ const NimBLEUUID umbraWeightCharacteristicUUID("0000fe42-8e22-4541-9d4c-21edae82
 //-----------------------------------------------------------------------------------/
 //---------------------------        PUBLIC       -----------------------------------/
 //-----------------------------------------------------------------------------------/
-AcaiaScales::AcaiaScales(const DiscoveredDevice& device) : RemoteScales(device) {}
+AcaiaScales::AcaiaScales(const DiscoveredDevice& device) : RemoteScales(device) {
+  RemoteScales::schedulePeriodic(HEARTBEAT_PERIOD_MS, [this]() { sendHeartbeat(); });
+}
 
 bool AcaiaScales::connect() {
   if (RemoteScales::clientIsConnected()) {
@@ -70,6 +77,8 @@ bool AcaiaScales::connect() {
     return false;
   }
 
+  frames.reset();
+
   if (!performConnectionHandshake()) {
     return false;
   }
@@ -94,21 +103,21 @@ void AcaiaScales::update() {
     markedForReconnection = false;
   }
   else {
-    sendHeartbeat();
+    RemoteScales::runPeriodicTasks();
   }
+  RemoteScales::serviceStaleWatchdog();
+  RemoteScales::processCommandQueue();
 }
 
 bool AcaiaScales::tare() {
   if (!isConnected()) return false;
   uint8_t payload[] = { 0x00 };
-  sendMessage(AcaiaMessageType::TARE, payload, sizeof(payload));
-  return true;
+  return sendMessage(ScaleCommand::TARE, AcaiaMessageType::TARE, payload, sizeof(payload));
 };
 
 //-----------------------------------------------------------------------------------/
 //---------------------------       PRIVATE       -----------------------------------/
 //-----------------------------------------------------------------------------------/
-static void cleanupJunkData(std::vector<uint8_t>& dataBuffer);
 static std::pair<uint8_t, uint8_t> calculateChecksum(const uint8_t* message, size_t length);
 
 void AcaiaScales::notifyCallback(
@@ -117,39 +126,40 @@ void AcaiaScales::notifyCallback(
   size_t length,
   bool isNotify
 ) {
-  dataBuffer.insert(dataBuffer.end(), pData, pData + length);
-  bool result = true;
-  while (result) {
-    result = decodeAndHandleNotification();
+  size_t discarded = frames.feed(pData, length,
+    [](const uint8_t* frame, size_t available) -> int32_t {
+      // A message starts with both header bytes; its length byte follows the type.
+      if (frame[0] != (uint8_t)AcaiaHeader::HEADER1) return -1;
+      if (available < 2) return 0;
+      if (frame[1] != (uint8_t)AcaiaHeader::HEADER2) return -1;
+      if (available < HEADER_LENGTH + 1) return 0;
+      return HEADER_LENGTH + frame[3] + CHECKSUM_LENGTH;
+    },
+    [this](const uint8_t* message, size_t messageLength) { handleMessage(message, messageLength); });
+
+  if (discarded > 0) {
+    countHealth(ScaleHealthCounter::RESYNCS);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
   }
 }
 
-bool AcaiaScales::decodeAndHandleNotification() {
-  cleanupJunkData(dataBuffer);
-
-  if (dataBuffer.size() < MIN_MESSAGE_LENGTH) {
-    return false;
-  }
-
-  size_t messageLength = HEADER_LENGTH + dataBuffer[3] + CHECKSUM_LENGTH;
-  if (messageLength > dataBuffer.size()) {
-    return false;
-  }
-
-  uint8_t* payload = dataBuffer.data() + HEADER_LENGTH;
+void AcaiaScales::handleMessage(const uint8_t* message, size_t messageLength) {
+  const uint8_t* payload = message + HEADER_LENGTH;
   size_t payloadLength = messageLength - (HEADER_LENGTH + CHECKSUM_LENGTH);
 
   auto checksumBytes = calculateChecksum(payload, payloadLength);
-  if (checksumBytes.first != dataBuffer[messageLength - 2] || checksumBytes.second != dataBuffer[messageLength - 1]) {
+  if (checksumBytes.first != message[messageLength - 2] || checksumBytes.second != message[messageLength - 1]) {
     RemoteScales::log("Checksum failed: calc[%02X  %02X] but actual[%02X %02X]. Discarding.\n",
       checksumBytes.first, checksumBytes.second,
-      dataBuffer[messageLength - 2], dataBuffer[messageLength - 1]
+      message[messageLength - 2], message[messageLength - 1]
     );
-    dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + messageLength);
-    return false;
+    countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, messageLength);
+    return;
   }
 
-  AcaiaMessageType messageType = static_cast<AcaiaMessageType>(dataBuffer[2]);
+  countHealth(ScaleHealthCounter::FRAMES_OK);
+  AcaiaMessageType messageType = static_cast<AcaiaMessageType>(message[2]);
 
   if (messageType == AcaiaMessageType::EVENT) {
     handleScaleEventPayload(payload, payloadLength);
@@ -158,7 +168,7 @@ bool AcaiaScales::decodeAndHandleNotification() {
     handleScaleStatusPayload(payload, payloadLength);
   }
   else if (messageType == AcaiaMessageType::INFO) {
-    RemoteScales::log("Got info message: %s\n", RemoteScales::byteArrayToHexString(dataBuffer.data(), messageLength).c_str());
+    RemoteScales::log("Got info message: %s\n", RemoteScales::byteArrayToHexString(message, messageLength).c_str());
 
     // For some reason, Acaia Pearl S sends this info message upon connection.
     // It can safely be ignored; otherwise, the scale will almost never successfully connect.
@@ -169,18 +179,24 @@ bool AcaiaScales::decodeAndHandleNotification() {
 
   }
   else {
-    RemoteScales::log("Unknown message type %02X: %s\n", messageType, RemoteScales::byteArrayToHexString(dataBuffer.data(), messageLength).c_str());
+    countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
+    RemoteScales::log("Unknown message type %02X: %s\n", messageType, RemoteScales::byteArrayToHexString(message, messageLength).c_str());
   }
-
-  //Remove processed data packet from the buffer.
-  dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + messageLength);
-  return dataBuffer.size() >= MIN_MESSAGE_LENGTH;
 }
 
 void AcaiaScales::handleScaleEventPayload(const uint8_t* payload, size_t length) {
+  if (length < EVENT_MIN_PAYLOAD) {
+    countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
+    return;
+  }
   AcaiaEventType eventType = static_cast<AcaiaEventType>(payload[1]);
   if (eventType == AcaiaEventType::WEIGHT) {
-    RemoteScales::setWeight(decodeWeight(payload + 2));
+    float weight;
+    if (length < WEIGHT_EVENT_MIN_PAYLOAD || !decodeWeight(payload + 2, weight)) {
+      countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
+      return;
+    }
+    RemoteScales::setWeight(weight);
   }
   else if (eventType == AcaiaEventType::ACK) {
     // Ignore for now.
@@ -190,10 +206,12 @@ void AcaiaScales::handleScaleEventPayload(const uint8_t* payload, size_t length)
     // RemoteScales::setWeight(decodeWeight(payload + 4));
   }
   else if (eventType == AcaiaEventType::TIMER) {
-    // Ignore for now
-    // time = decodeTime(payload + 1);
-    // RemoteScales::log("TIMER - %s", byteArrayToHexString(payload, length).c_str());
-    // RemoteScales::log("Time:  %0.1f\n", time);
+    // Minutes, seconds, tenths of the running stopwatch. It comes in an event
+    // of its own, so it says nothing about when the next weight was taken.
+    if (length >= TIMER_EVENT_MIN_PAYLOAD) {
+      time = decodeTime(payload + 2);
+      RemoteScales::setScaleTimerMs(static_cast<uint32_t>(time * 1000.f + 0.5f), false);
+    }
   }
   else if (eventType == AcaiaEventType::KEY) {
     // Ignore for now
@@ -227,11 +245,16 @@ void AcaiaScales::handleScaleEventPayload(const uint8_t* payload, size_t length)
     // }
   }
   else {
+    countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
     RemoteScales::log("unknown event type %02x(%d): %s\n", eventType, eventType, RemoteScales::byteArrayToHexString(payload, length).c_str());
   }
 }
 
 void AcaiaScales::handleScaleStatusPayload(const uint8_t* payload, size_t length) {
+  if (length < STATUS_MIN_PAYLOAD) {
+    countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
+    return;
+  }
   battery = payload[1] & 0x7F;
   if (payload[2] == 2) {
     weightUnits = "grams";
@@ -246,7 +269,7 @@ void AcaiaScales::handleScaleStatusPayload(const uint8_t* payload, size_t length
   // bool beep_on = (payload[6] == 1);
 }
 
-float AcaiaScales::decodeWeight(const uint8_t* weightPayload) {
+bool AcaiaScales::decodeWeight(const uint8_t* weightPayload, float& weight) {
   float value;
   uint8_t scaling;
 
@@ -276,14 +299,15 @@ float AcaiaScales::decodeWeight(const uint8_t* weightPayload) {
     break;
   default:
     RemoteScales::log("Invalid scaling %02X - %s \n", scaling, RemoteScales::byteArrayToHexString(weightPayload, 6).c_str());
-    return -1;
+    return false;
   }
 
   if (weightPayload[5] & 0x02) {
     value *= -1.0f;
   }
 
-  return value;
+  weight = value;
+  return true;
 }
 
 float AcaiaScales::decodeTime(const uint8_t* timePayload) {
@@ -334,7 +358,7 @@ bool AcaiaScales::performConnectionHandshake() {
   RemoteScales::log("Got notifyDescriptor\n");
   if (notifyDescriptor != nullptr) {
     uint8_t value[2] = { 0x01, 0x00 };
-    notifyDescriptor->writeValue(value, 2, true);
+    RemoteScales::sendCommand(ScaleCommand::SETUP, notifyDescriptor, value, sizeof(value));
   }
   else {
     clientCleanup();
@@ -344,23 +368,22 @@ bool AcaiaScales::performConnectionHandshake() {
   // Identify
   sendId();
   RemoteScales::log("Send ID\n");
-  sendNotificationRequest();
+  sendNotificationRequest(ScaleCommand::SETUP);
   RemoteScales::log("Sent notification request\n");
-  lastHeartbeat = millis();
   return true;
 }
 
 void AcaiaScales::sendId() {
   const uint8_t payload[] = { 0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d,0x2d };
-  sendMessage(AcaiaMessageType::IDENTIFY, payload, 15, false);
+  sendMessage(ScaleCommand::SETUP, AcaiaMessageType::IDENTIFY, payload, 15, false);
 }
 
-void AcaiaScales::sendNotificationRequest() {
+void AcaiaScales::sendNotificationRequest(ScaleCommand command) {
   uint8_t payload[] = { 0, 1, 1, 2, 2, 5, 3, 4 };
-  sendEvent(payload, 8);
+  sendEvent(command, payload, 8);
 }
 
-void AcaiaScales::sendEvent(const uint8_t* payload, size_t length) {
+bool AcaiaScales::sendEvent(ScaleCommand command, const uint8_t* payload, size_t length) {
   auto bytes = std::make_unique<uint8_t[]>(length + 1);
   bytes[0] = static_cast<uint8_t>(length + 1);
 
@@ -368,7 +391,7 @@ void AcaiaScales::sendEvent(const uint8_t* payload, size_t length) {
     bytes[i + 1] = payload[i] & 0xFF;
   }
 
-  sendMessage(AcaiaMessageType::EVENT, bytes.get(), length + 1);
+  return sendMessage(command, AcaiaMessageType::EVENT, bytes.get(), length + 1);
 }
 
 void AcaiaScales::sendHeartbeat() {
@@ -376,17 +399,11 @@ void AcaiaScales::sendHeartbeat() {
     return;
   }
 
-  uint32_t now = millis();
-  if (now - lastHeartbeat < 2000) {
-    return;
-  }
-
   uint8_t payload1[] = { 0x02,0x00 };
-  sendMessage(AcaiaMessageType::SYSTEM, payload1, 2);
-  sendNotificationRequest();
+  sendMessage(ScaleCommand::HEARTBEAT, AcaiaMessageType::SYSTEM, payload1, 2);
+  sendNotificationRequest(ScaleCommand::HEARTBEAT);
   uint8_t payload2[] = { 0x00 };
-  sendMessage(AcaiaMessageType::HANDSHAKE, payload2, 1);
-  lastHeartbeat = now;
+  sendMessage(ScaleCommand::HEARTBEAT, AcaiaMessageType::HANDSHAKE, payload2, 1);
 }
 
 void AcaiaScales::subscribeToNotifications() {
@@ -398,16 +415,16 @@ void AcaiaScales::subscribeToNotifications() {
 
   if (weightCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for weight characteristic\n");
-    weightCharacteristic->subscribe(true, callback);
+    subscribe(weightCharacteristic, callback);
   }
 
   if (commandCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for command characteristic\n");
-    commandCharacteristic->subscribe(true, callback);
+    subscribe(commandCharacteristic, callback);
   }
 }
 
-void AcaiaScales::sendMessage(AcaiaMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse) {
+bool AcaiaScales::sendMessage(ScaleCommand command, AcaiaMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse) {
   size_t messageSize = HEADER_LENGTH + length + CHECKSUM_LENGTH;
   auto bytes = std::make_unique<uint8_t[]>(messageSize);
 
@@ -424,7 +441,7 @@ void AcaiaScales::sendMessage(AcaiaMessageType msgType, const uint8_t* payload,
   bytes[length + 3] = (checksums.first & 0xFF);
   bytes[length + 4] = (checksums.second & 0xFF);
 
-  commandCharacteristic->writeValue(bytes.get(), messageSize, waitResponse);
+  return RemoteScales::sendCommand(command, commandCharacteristic, bytes.get(), messageSize, waitResponse);
 };
 
 // Calculate the checksum for the payload of the message
@@ -444,25 +461,6 @@ static std::pair<uint8_t, uint8_t> calculateChecksum(const uint8_t* payload, siz
   return { cksum1 & 0xFF, cksum2 & 0xFF };
 }
 
-// Discard junk data so that the first element of the buffer is the start of a message
-static void cleanupJunkData(std::vector<uint8_t>& dataBuffer) {
-  int messageStart = 0;
-
-  // Find the start of the message
-  while (messageStart < dataBuffer.size() - 1
-    && dataBuffer[messageStart] != (uint8_t)AcaiaHeader::HEADER1
-    && dataBuffer[messageStart + 1] != (uint8_t)(AcaiaHeader::HEADER2)
-    ) {
-    messageStart++;
-  }
-
-  // Clear everything before the start of the message
-  dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + messageStart);
-  if (messageStart == dataBuffer.size() - 1 && dataBuffer[messageStart] != (uint8_t)AcaiaHeader::HEADER1) {
-    dataBuffer.clear();
-  }
-}
-
 bool AcaiaScales::isUmbraModel() const {
   return RemoteScales::getDeviceName().find("UMBRA") != std::string::npos;
 }
@@ -1,7 +1,6 @@
 #pragma once
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
-#include <Arduino.h>
 #include <NimBLEDevice.h>
 #include <NimBLEUtils.h>
 #include <NimBLEScan.h>
@@ -28,12 +27,15 @@ public:
   bool isConnected() override;
   bool tare() override;
 
+  // TIMER events carry the scale's stopwatch while it runs.
+  bool hasScaleTimer() const override { return true; }
+
 private:
   std::string weightUnits;
   float time;
   uint8_t battery;
 
-  uint32_t lastHeartbeat = 0;
+  static constexpr uint32_t HEARTBEAT_PERIOD_MS = 2000;
 
   bool markedForReconnection = false;
 
@@ -41,21 +43,22 @@ private:
   NimBLERemoteCharacteristic* weightCharacteristic;
   NimBLERemoteCharacteristic* commandCharacteristic;
 
-  std::vector<uint8_t> dataBuffer;
+  // Status and info messages run past 20 bytes; nothing known comes near 128.
+  FrameReassembler<128> frames;
 
   bool performConnectionHandshake();
   void subscribeToNotifications();
 
-  void sendMessage(AcaiaMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
-  void sendEvent(const uint8_t* payload, size_t length);
+  bool sendMessage(ScaleCommand command, AcaiaMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
+  bool sendEvent(ScaleCommand command, const uint8_t* payload, size_t length);
   void sendHeartbeat();
-  void sendNotificationRequest();
+  void sendNotificationRequest(ScaleCommand command);
   void sendId();
   void notifyCallback(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify);
-  bool decodeAndHandleNotification();
+  void handleMessage(const uint8_t* message, size_t messageLength);
   void handleScaleEventPayload(const uint8_t* pData, size_t length);
   void handleScaleStatusPayload(const uint8_t* pData, size_t length);
-  float decodeWeight(const uint8_t* weightPayload);
+  bool decodeWeight(const uint8_t* weightPayload, float& weight);
   float decodeTime(const uint8_t* timePayload);
   
   // Helper to identify Umbra model scales which use slightly different BLE characteristics
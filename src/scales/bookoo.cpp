@@ -15,7 +15,9 @@ const NimBLEUUID commandCharacteristicUUID("FF12");
 //-----------------------------------------------------------------------------------/
 //---------------------------        PUBLIC       -----------------------------------/
 //-----------------------------------------------------------------------------------/
-BookooScales::BookooScales(const DiscoveredDevice& device) : RemoteScales(device) {}
+BookooScales::BookooScales(const DiscoveredDevice& device) : RemoteScales(device) {
+  RemoteScales::schedulePeriodic(HEARTBEAT_PERIOD_MS, [this]() { sendHeartbeat(); });
+}
 
 bool BookooScales::connect() {
   if (RemoteScales::clientIsConnected()) {
@@ -30,6 +32,8 @@ bool BookooScales::connect() {
     return false;
   }
 
+  frames.reset();
+
   if (!performConnectionHandshake()) {
     return false;
   }
@@ -61,9 +65,10 @@ void BookooScales::update() {
     markedForReconnection = false;
   }
   else {
-    sendHeartbeat();
-    RemoteScales::log("Heartbeat sent.\n");
+    RemoteScales::runPeriodicTasks();
   }
+  RemoteScales::serviceStaleWatchdog();
+  RemoteScales::processCommandQueue();
 }
 
 bool BookooScales::tare() {
@@ -77,9 +82,7 @@ bool BookooScales::tare() {
   // future-proof if we ever want to cross-check shot timing against the scale.
   // sendMessage() computes and writes the final checksum byte.
   std::array<uint8_t, 6> payload = { 0x03, 0x0A, 0x07, 0x00, 0x00, 0x00 };
-  sendMessage(payload.data(), payload.size());
-
-  return true;
+  return sendMessage(ScaleCommand::TARE, payload.data(), payload.size());
 };
 
 // Note: on Bookoo Ultra these commands are only effective in timing-mode /
@@ -91,21 +94,21 @@ void BookooScales::startTimer() {
   if (!isConnected()) return;
   RemoteScales::log("StartTimer sent (cmd 0x04)");
   std::array<uint8_t, 6> payload = { 0x03, 0x0A, 0x04, 0x00, 0x00, 0x00 };
-  sendMessage(payload.data(), payload.size());
+  sendMessage(ScaleCommand::START_TIMER, payload.data(), payload.size());
 }
 
 void BookooScales::stopTimer() {
   if (!isConnected()) return;
   RemoteScales::log("StopTimer sent (cmd 0x05)");
   std::array<uint8_t, 6> payload = { 0x03, 0x0A, 0x05, 0x00, 0x00, 0x00 };
-  sendMessage(payload.data(), payload.size());
+  sendMessage(ScaleCommand::STOP_TIMER, payload.data(), payload.size());
 }
 
 void BookooScales::resetTimer() {
   if (!isConnected()) return;
   RemoteScales::log("ResetTimer sent (cmd 0x06)");
   std::array<uint8_t, 6> payload = { 0x03, 0x0A, 0x06, 0x00, 0x00, 0x00 };
-  sendMessage(payload.data(), payload.size());
+  sendMessage(ScaleCommand::RESET_TIMER, payload.data(), payload.size());
 }
 
 void BookooScales::disableScaleSmoothing() {
@@ -117,7 +120,7 @@ void BookooScales::disableScaleSmoothing() {
   // can then apply their own filtering or use the raw signal directly --
   // avoiding a double-EMA pipeline that adds lag with no accuracy benefit.
   std::array<uint8_t, 6> payload = { 0x03, 0x0A, 0x08, 0x00, 0x00, 0x00 };
-  sendMessage(payload.data(), payload.size());
+  sendMessage(ScaleCommand::SETUP, payload.data(), payload.size());
 };
 
 //-----------------------------------------------------------------------------------/
@@ -129,10 +132,16 @@ void BookooScales::notifyCallback(
   size_t length,
   bool isNotify
 ) {
-  dataBuffer.insert(dataBuffer.end(), pData, pData + length);
-  bool result = true;
-  while (result) {
-    result = decodeAndHandleNotification();
+  // Messages are a fixed 20 bytes behind the 0x03 product number.
+  size_t discarded = frames.feed(pData, length,
+    [](const uint8_t* frame, size_t) -> int32_t {
+      return frame[0] == 0x03 ? static_cast<int32_t>(RECEIVE_PROTOCOL_LENGTH) : -1;
+    },
+    [this](const uint8_t* message, size_t messageLength) { handleMessage(message, messageLength); });
+
+  if (discarded > 0) {
+    countHealth(ScaleHealthCounter::RESYNCS);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
   }
 }
 
@@ -140,34 +149,29 @@ void BookooScales::notifyCallback(
 Handle protocol according to the spec found at
 https://github.com/BooKooCode/OpenSource/blob/main/bookoo_mini_scale/protocols.md#receiving-weight
 */
-bool BookooScales::decodeAndHandleNotification() {
-  // Minimum message length check (20 bytes based on protocol definition)
-  if (dataBuffer.size() < RECEIVE_PROTOCOL_LENGTH) {
-    return false;
-  }
-
-  BookooMessageType messageType = static_cast<BookooMessageType>(dataBuffer[1]);
-  uint8_t productNumber = dataBuffer[0];
-
-  size_t messageLength = RECEIVE_PROTOCOL_LENGTH;
+void BookooScales::handleMessage(const uint8_t* message, size_t messageLength) {
+  BookooMessageType messageType = static_cast<BookooMessageType>(message[1]);
+  uint8_t productNumber = message[0];
 
   // Handle different message types
   if (productNumber == 0x03 && messageType == BookooMessageType::WEIGHT) {
     // Checksum validation: XOR of Header1 ^ Header2 ^ Data0 ^ Data1 ^ ... ^ DataN should equal DataSUM
-    uint8_t checksum = dataBuffer[0];
+    uint8_t checksum = message[0];
     for (size_t i = 1; i < messageLength - 1; i++) {
-      checksum ^= dataBuffer[i];
+      checksum ^= message[i];
     }
 
     // The last byte in the message is DataSUM
-    uint8_t dataSUM = dataBuffer[messageLength - 1];
+    uint8_t dataSUM = message[messageLength - 1];
 
     if (checksum != dataSUM) {
       RemoteScales::log("Checksum failed: calc[%02X] but actual[%02X]. Discarding.\n",
         checksum, dataSUM);
-      dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + messageLength);
-      return false;
+      countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
+      countHealth(ScaleHealthCounter::BYTES_DISCARDED, messageLength);
+      return;
     }
+    countHealth(ScaleHealthCounter::FRAMES_OK);
 
     // Parse the full 20-byte weight notification per the Bookoo protocol spec:
     // https://github.com/BooKooCode/OpenSource/blob/main/bookoo_ultra_scale/protocols.md
@@ -189,55 +193,52 @@ bool BookooScales::decodeAndHandleNotification() {
     //   [19]   checksum
 
     // Scale timer (bytes 2-4, 3 bytes big-endian unsigned, milliseconds).
-    const uint32_t timerMs = (static_cast<uint32_t>(dataBuffer[2]) << 16) |
-                             (static_cast<uint32_t>(dataBuffer[3]) << 8)  |
-                              static_cast<uint32_t>(dataBuffer[4]);
+    const uint32_t timerMs = (static_cast<uint32_t>(message[2]) << 16) |
+                             (static_cast<uint32_t>(message[3]) << 8)  |
+                              static_cast<uint32_t>(message[4]);
     RemoteScales::setScaleTimerMs(timerMs);
 
     // Weight unit (byte 5).
-    switch (dataBuffer[5]) {
+    switch (message[5]) {
       case 0x01: RemoteScales::setWeightUnit(ScaleWeightUnit::OUNCE); break;
       case 0x02: RemoteScales::setWeightUnit(ScaleWeightUnit::GRAM); break;
       default:   RemoteScales::setWeightUnit(ScaleWeightUnit::UNKNOWN); break;
     }
 
-    // Weight (sign byte 6 + value bytes 7-9, 0.01g resolution).
-    int32_t rawWeight = (static_cast<int32_t>(dataBuffer[7]) << 16) |
-                        (static_cast<int32_t>(dataBuffer[8]) << 8)  |
-                         static_cast<int32_t>(dataBuffer[9]);
-    if (dataBuffer[6] == 0x2D) { // '-'
-      rawWeight = -rawWeight;
-    }
-    RemoteScales::setWeight(rawWeight * 0.01f);
-
     // Flow rate (sign byte 10 + value bytes 11-12, 0.01 g/s resolution).
-    int32_t rawFlow = (static_cast<int32_t>(dataBuffer[11]) << 8) |
-                       static_cast<int32_t>(dataBuffer[12]);
-    if (dataBuffer[10] == 0x2D) { // '-'
+    int32_t rawFlow = (static_cast<int32_t>(message[11]) << 8) |
+                       static_cast<int32_t>(message[12]);
+    if (message[10] == 0x2D) { // '-'
       rawFlow = -rawFlow;
     }
     RemoteScales::setFlowRate(rawFlow * 0.01f);
 
     // Battery percentage (byte 13).
-    RemoteScales::setBatteryLevel(dataBuffer[13]);
+    RemoteScales::setBatteryLevel(message[13]);
 
     // Auto-mode stop condition (byte 18) -- only meaningful on Ultra scales
     // where hasAutoModeStopCondition() returns true. We still store it so an
     // Ultra-aware subclass (or a future firmware-side model check) can read it.
-    RemoteScales::setAutoModeStopCondition(dataBuffer[18]);
+    RemoteScales::setAutoModeStopCondition(message[18]);
+
+    // Weight (sign byte 6 + value bytes 7-9, 0.01g resolution). Set last: setWeight()
+    // publishes the snapshot, so every other field of this frame must be in place.
+    int32_t rawWeight = (static_cast<int32_t>(message[7]) << 16) |
+                        (static_cast<int32_t>(message[8]) << 8)  |
+                         static_cast<int32_t>(message[9]);
+    if (message[6] == 0x2D) { // '-'
+      rawWeight = -rawWeight;
+    }
+    RemoteScales::setWeight(rawWeight * 0.01f);
   }
   else if (productNumber == 0x03 && messageType == BookooMessageType::SYSTEM) {
-    RemoteScales::log("Inbound SYSTEM message ignored: %s\n", RemoteScales::byteArrayToHexString(dataBuffer.data(), messageLength).c_str());
+    countHealth(ScaleHealthCounter::FRAMES_OK);
+    RemoteScales::log("Inbound SYSTEM message ignored: %s\n", RemoteScales::byteArrayToHexString(message, messageLength).c_str());
   }
   else {
-    RemoteScales::log("Unknown message type %02X: %s\n", static_cast<uint8_t>(messageType), RemoteScales::byteArrayToHexString(dataBuffer.data(), messageLength).c_str());
+    countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
+    RemoteScales::log("Unknown message type %02X: %s\n", static_cast<uint8_t>(messageType), RemoteScales::byteArrayToHexString(message, messageLength).c_str());
   }
-
-  // Remove processed message from the buffer
-  dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + messageLength);
-
-  // Return whether there's more data to process
-  return dataBuffer.size() >= RECEIVE_PROTOCOL_LENGTH;
 }
 
 bool BookooScales::performConnectionHandshake() {
@@ -260,19 +261,18 @@ bool BookooScales::performConnectionHandshake() {
   }
   RemoteScales::log("Got weightCharacteristic and commandCharacteristic\n");
 
-  sendNotificationRequest();
+  sendNotificationRequest(ScaleCommand::SETUP);
   RemoteScales::log("Sent notification request\n");
-  lastHeartbeat = millis();
   return true;
 }
 
-void BookooScales::sendNotificationRequest() {
+void BookooScales::sendNotificationRequest(ScaleCommand command) {
   uint8_t payload[] = { 0, 0, 0, 0, 0, 0 };
-  sendEvent(payload, 6);
+  sendEvent(command, payload, 6);
   RemoteScales::log("Sent event.\n");
 }
 
-void BookooScales::sendEvent(const uint8_t* payload, size_t length) {
+bool BookooScales::sendEvent(ScaleCommand command, const uint8_t* payload, size_t length) {
   auto bytes = std::make_unique<uint8_t[]>(length + 1);
   bytes[0] = static_cast<uint8_t>(length + 1);
 
@@ -280,7 +280,7 @@ void BookooScales::sendEvent(const uint8_t* payload, size_t length) {
     bytes[i + 1] = payload[i] & 0xFF;
   }
 
-  sendMessage(bytes.get(), length + 1);
+  return sendMessage(command, bytes.get(), length + 1);
 }
 
 void BookooScales::sendHeartbeat() {
@@ -288,17 +288,11 @@ void BookooScales::sendHeartbeat() {
     return;
   }
 
-  uint32_t now = millis();
-  if (now - lastHeartbeat < 2000) {
-    return;
-  }
-
   uint8_t payload1[] = { 0x02,0x00 };
-  sendMessage(payload1, 2);
-  sendNotificationRequest();
+  sendMessage(ScaleCommand::HEARTBEAT, payload1, 2);
+  sendNotificationRequest(ScaleCommand::HEARTBEAT);
   uint8_t payload2[] = { 0x00 };
-  sendMessage(payload2, 1);
-  lastHeartbeat = now;
+  sendMessage(ScaleCommand::HEARTBEAT, payload2, 1);
 }
 
 void BookooScales::subscribeToNotifications() {
@@ -310,17 +304,17 @@ void BookooScales::subscribeToNotifications() {
 
   if (weightCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for weight characteristic\n");
-    weightCharacteristic->subscribe(true, callback);
+    subscribe(weightCharacteristic, callback);
   }
 
   if (commandCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for command characteristic\n");
-    commandCharacteristic->subscribe(true, callback);
+    subscribe(commandCharacteristic, callback);
   }
 }
 
 // NOTE: the last byte of `payload` is overwritten with the XOR checksum — callers must reserve it.
-void BookooScales::sendMessage(const uint8_t* payload, size_t length, bool waitResponse) {
+bool BookooScales::sendMessage(ScaleCommand command, const uint8_t* payload, size_t length, bool waitResponse) {
 
   auto bytes = std::make_unique<uint8_t[]>(length);
 
@@ -333,5 +327,5 @@ void BookooScales::sendMessage(const uint8_t* payload, size_t length, bool waitR
   }
   bytes[length - 1] = checksum;
 
-  commandCharacteristic->writeValue(bytes.get(), length, waitResponse);
+  return RemoteScales::sendCommand(command, commandCharacteristic, bytes.get(), length, waitResponse);
 }
@@ -1,7 +1,6 @@
 #pragma once
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
-#include <Arduino.h>
 #include <NimBLEDevice.h>
 #include <NimBLEUtils.h>
 #include <NimBLEScan.h>
@@ -27,7 +26,7 @@ public:
   void resetTimer() override;
 
   // Capability overrides — Bookoo parses all of these out of the 20-byte
-  // weight notification (0x0B). See decodeAndHandleNotification() for layout.
+  // weight notification (0x0B). See handleMessage() for layout.
   bool hasFlowRate() const override { return true; }
   bool hasBatteryLevel() const override { return true; }
   bool hasScaleTimer() const override { return true; }
@@ -46,7 +45,7 @@ public:
   void disableScaleSmoothing();
 
 private:
-  uint32_t lastHeartbeat = 0;
+  static constexpr uint32_t HEARTBEAT_PERIOD_MS = 2000;
 
   bool markedForReconnection = false;
 
@@ -54,18 +53,18 @@ private:
   NimBLERemoteCharacteristic* weightCharacteristic;
   NimBLERemoteCharacteristic* commandCharacteristic;
 
-  std::vector<uint8_t> dataBuffer;
+  FrameReassembler<64> frames;
 
   bool performConnectionHandshake();
   void subscribeToNotifications();
 
-  void sendMessage(const uint8_t* payload, size_t length, bool waitResponse = false);
-  void sendEvent(const uint8_t* payload, size_t length);
+  bool sendMessage(ScaleCommand command, const uint8_t* payload, size_t length, bool waitResponse = false);
+  bool sendEvent(ScaleCommand command, const uint8_t* payload, size_t length);
   void sendHeartbeat();
-  void sendNotificationRequest();
+  void sendNotificationRequest(ScaleCommand command);
   void sendId();
   void notifyCallback(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify);
-  bool decodeAndHandleNotification();
+  void handleMessage(const uint8_t* message, size_t messageLength);
 };
 
 class BookooScalesPlugin {
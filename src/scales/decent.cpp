@@ -10,6 +10,7 @@ const NimBLEUUID writeCharacteristicUUID("36F5");
 
 DecentScales::DecentScales(const DiscoveredDevice& device)
   : RemoteScales(device) {
+  RemoteScales::schedulePeriodic(HEARTBEAT_PERIOD_MS, [this]() { sendHeartbeat(); });
 }
 
 DecentScales::~DecentScales() {}
@@ -49,6 +50,8 @@ void DecentScales::disconnect() {
   // Turn off the OLED display before disconnecting
   if (isConnected()) {
     turnOffOLED();
+    // Flush now: clientCleanup() drops anything still queued.
+    RemoteScales::processCommandQueue();
   }
   RemoteScales::clientCleanup(); 
 }
@@ -66,23 +69,18 @@ void DecentScales::update() {
       RemoteScales::log("Failed to reconnect\n");
       return;
     }
-  } else {
-    if (verifyConnected()) {
-      // Send heartbeat every 5 seconds
-      unsigned long now = millis();
-      if (now - lastHeartbeatMillis >= 5000) {
-        sendHeartbeat();
-        lastHeartbeatMillis = now;
-      }
-    }
+  } else if (verifyConnected()) {
+    RemoteScales::runPeriodicTasks();
   }
+  RemoteScales::serviceStaleWatchdog();
+  RemoteScales::processCommandQueue();
 }
 
 void DecentScales::sendHeartbeat() {
   // Heartbeat command: 03 0A 03 FF FF 00 0A
   if (writeCharacteristic) {
     uint8_t payload[] = { 0x03, 0x0A, 0x03, 0xFF, 0xFF, 0x00, 0x0A };
-    writeCharacteristic->writeValue(payload, sizeof(payload), false);
+    RemoteScales::sendCommand(ScaleCommand::HEARTBEAT, writeCharacteristic, payload, sizeof(payload));
     RemoteScales::log("Heartbeat sent\n");
   }
 }
@@ -91,7 +89,7 @@ void DecentScales::turnOnOLED() {
   if (writeCharacteristic) {
     // 030A 01 01 00 01 08 - weight+timer LEDs on, grams, heartbeat maintained
     uint8_t payload[] = { 0x03, 0x0A, 0x01, 0x01, 0x00, 0x01, 0x08 };
-    writeCharacteristic->writeValue(payload, sizeof(payload), false);
+    RemoteScales::sendCommand(ScaleCommand::SETUP, writeCharacteristic, payload, sizeof(payload));
     RemoteScales::log("OLED turned on\n");
   }
 }
@@ -100,7 +98,7 @@ void DecentScales::turnOffOLED() {
   if (writeCharacteristic) {
     // 030A 00 00 00 01 08 - weight+timer LEDs off, grams, heartbeat maintained
     uint8_t payload[] = { 0x03, 0x0A, 0x00, 0x00, 0x00, 0x01, 0x08 };
-    writeCharacteristic->writeValue(payload, sizeof(payload), false);
+    RemoteScales::sendCommand(ScaleCommand::SETUP, writeCharacteristic, payload, sizeof(payload));
     RemoteScales::log("OLED turned off\n");
   }
 }
@@ -110,8 +108,7 @@ bool DecentScales::tare() {
     return false;
   // 030F 000000 01 0D - tare, leaves heartbeat as set (data[5]=0x01)
   uint8_t payload[] = { 0x03, 0x0F, 0x00, 0x00, 0x00, 0x01, 0x0D };
-  writeCharacteristic->writeValue(payload, sizeof(payload), false);
-  return true;
+  return RemoteScales::sendCommand(ScaleCommand::TARE, writeCharacteristic, payload, sizeof(payload));
 };
 
 bool DecentScales::performConnectionHandshake() {
@@ -142,7 +139,7 @@ bool DecentScales::subscribeToNotifications() {
       uint8_t* data, size_t length, bool isNotify) {
         readCallback(characteristic, data, length, isNotify);
       };
-    if (!readCharacteristic->subscribe(true, callback, false)) {
+    if (!subscribe(readCharacteristic, callback)) {
       clientCleanup();
       return false;
     }
@@ -161,6 +158,7 @@ void DecentScales::readCallback(NimBLERemoteCharacteristic* pCharacteristic,
     handleWeightNotification(pData, length);
   }
   else {
+    countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
     RemoteScales::log("Wrong packet length\n");
   }
 }
@@ -179,10 +177,19 @@ void DecentScales::handleWeightNotification(uint8_t* pData, size_t length) {
     }
 
     if (xorSum != xorByte) {
+      countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
       RemoteScales::log("Wrong checksum\n");
       return;
     }
   }
+  countHealth(ScaleHealthCounter::FRAMES_OK);
+
+  if (length == 10 && pData[1] == 0xCE) {
+    // Timestamped frame: minutes, seconds and tenths in bytes 4-6, same
+    // layout as the Acaia stopwatch.
+    uint32_t timestampMs = pData[4] * 60000u + pData[5] * 1000u + pData[6] * 100u;
+    RemoteScales::setScaleTimerMs(timestampMs);
+  }
 
   RemoteScales::setWeight(weight100 / 10.f);
   RemoteScales::log("Weight received\n");
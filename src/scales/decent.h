@@ -15,6 +15,10 @@ public:
   void update(void) override;
   bool tare(void) override;
 
+  // Timestamped (10-byte) weight frames carry the stopwatch; see
+  // handleWeightNotification().
+  bool hasScaleTimer() const override { return true; }
+
 private:
   NimBLERemoteService* service;
   NimBLERemoteCharacteristic* readCharacteristic;
@@ -22,7 +26,7 @@ private:
 
   bool markedForReconnection = false;
 
-  unsigned long lastHeartbeatMillis = 0;
+  static constexpr uint32_t HEARTBEAT_PERIOD_MS = 5000;
   void sendHeartbeat();
   void turnOnOLED();
   void turnOffOLED();
@@ -13,7 +13,9 @@ const NimBLEUUID weightCharacteristicUUID("AA01");
 //-----------------------------------------------------------------------------------/
 //---------------------------        PUBLIC       -----------------------------------/
 //-----------------------------------------------------------------------------------/
-DifluidScales::DifluidScales(const DiscoveredDevice& device) : RemoteScales(device) {}
+DifluidScales::DifluidScales(const DiscoveredDevice& device) : RemoteScales(device) {
+    schedulePeriodic(HEARTBEAT_PERIOD_MS, [this]() { sendHeartbeat(); });
+}
 
 bool DifluidScales::connect() {
     if (isConnected()) {
@@ -25,6 +27,7 @@ bool DifluidScales::connect() {
         clientCleanup();
         return false;
     }
+    reassembler.reset();
 
     if (!performConnectionHandshake()) {
         clientCleanup();
@@ -49,8 +52,10 @@ void DifluidScales::update() {
         connect();
         markedForReconnection = false;
     } else {
-        sendHeartbeat();
+        runPeriodicTasks();
     }
+    serviceStaleWatchdog();
+    processCommandQueue();
 }
 
 // Tare function
@@ -59,8 +64,7 @@ bool DifluidScales::tare() {
     log("Tare command sent.\n");
     uint8_t tareCommand[] = {0xDF, 0xDF, 0x03, 0x02, 0x01, 0x01, 0x00};
     tareCommand[6] = calculateChecksum(tareCommand, sizeof(tareCommand));
-    weightCharacteristic->writeValue(tareCommand, sizeof(tareCommand), true);
-    return true;
+    return sendCommand(ScaleCommand::TARE, weightCharacteristic, tareCommand, sizeof(tareCommand), true);
 }
 
 //-----------------------------------------------------------------------------------/
@@ -82,25 +86,34 @@ void DifluidScales::notifyCallback(
     size_t length,
     bool isNotify
 ) {
-    // Use the log function from RemoteScales
-    log("Notification received:\n");
-    for (size_t i = 0; i < length; i++) {
-        log("%02X ", pData[i]);
-    }
-    log("\n");
-
-    // Verify headers
-    if (length < 6 || pData[0] != 0xDF || pData[1] != 0xDF) {
-        log("Invalid data received.\n");
-        return;
+    log("Notification received: %s\n", byteArrayToHexString(pData, length).c_str());
+
+    size_t discarded = reassembler.feed(pData, length,
+        [](const uint8_t* frame, size_t available) -> int32_t {
+            if (frame[0] != 0xDF) return -1;
+            if (available < 2) return 0;
+            if (frame[1] != 0xDF) return -1;
+            if (available < 5) return 0;
+            // DF DF func cmd len data... checksum
+            return frame[4] + 6;
+        },
+        [this](const uint8_t* frame, size_t frameLength) { return handleFrame(frame, frameLength); });
+
+    if (discarded > 0) {
+        countHealth(ScaleHealthCounter::RESYNCS);
+        countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
+        log("Invalid data received, skipped %u bytes.\n", (unsigned)discarded);
     }
+}
 
+bool DifluidScales::handleFrame(const uint8_t* pData, size_t length) {
     // Verify checksum
     uint8_t receivedChecksum = pData[length - 1];
     uint8_t calculatedChecksum = calculateChecksum(pData, length);
     if (receivedChecksum != calculatedChecksum) {
+        countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
         log("Checksum mismatch. Received: %02X, Calculated: %02X\n", receivedChecksum, calculatedChecksum);
-        return;
+        return false;
     }
 
     uint8_t func = pData[2];
@@ -119,16 +132,21 @@ void DifluidScales::notifyCallback(
             log("Weight: %.1f g\n", weight);
 
             // Call weight updated callback
+            countHealth(ScaleHealthCounter::FRAMES_OK);
             setWeight(weight);
         } else {
+            countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
             log("Invalid sensor data length.\n");
         }
     } else if (func == 0x03 && cmd == 0x05) { // Heartbeat Acknowledgment(Get Device Status)
+        countHealth(ScaleHealthCounter::FRAMES_OK);
         log("Heartbeat acknowledged.\n");
-        uint8_t battery_capacity = pData[6];  // Battery capacity percentage.
+        uint8_t battery_capacity = length > 6 ? pData[6] : 0;  // Battery capacity percentage.
     } else {
+        countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
         log("Unknown function (%02X) or command (%02X).\n", func, cmd);
     }
+    return true;
 }
 
 
@@ -156,7 +174,7 @@ bool DifluidScales::performConnectionHandshake() {
 
     // Subscribe to notifications
     if (weightCharacteristic->canNotify()) {
-        weightCharacteristic->subscribe(true, [this](NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
+        subscribe(weightCharacteristic, [this](NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
             notifyCallback(characteristic, data, length, isNotify);
         });
     } else {
@@ -170,23 +188,20 @@ bool DifluidScales::performConnectionHandshake() {
     // Enable auto notifications
     enableAutoNotifications();
 
-    // Initialize heartbeat timer
-    lastHeartbeat = millis();
-
     return true;
 }
 
 void DifluidScales::setUnitToGram() {
     uint8_t unitToGramCommand[] = {0xDF, 0xDF, 0x01, 0x04, 0x01, 0x00, 0x00}; // Last byte for checksum
     unitToGramCommand[6] = calculateChecksum(unitToGramCommand, sizeof(unitToGramCommand));
-    weightCharacteristic->writeValue(unitToGramCommand, sizeof(unitToGramCommand), true);
+    sendCommand(ScaleCommand::SETUP, weightCharacteristic, unitToGramCommand, sizeof(unitToGramCommand), true);
     log("Set unit to grams.\n");
 }
 
 void DifluidScales::enableAutoNotifications() {
     uint8_t enableNotificationsCommand[] = {0xDF, 0xDF, 0x01, 0x00, 0x01, 0x01, 0x00};
     enableNotificationsCommand[6] = calculateChecksum(enableNotificationsCommand, sizeof(enableNotificationsCommand));
-    weightCharacteristic->writeValue(enableNotificationsCommand, sizeof(enableNotificationsCommand), true);
+    sendCommand(ScaleCommand::SETUP, weightCharacteristic, enableNotificationsCommand, sizeof(enableNotificationsCommand), true);
     log("Enabled auto notifications.\n");
 }
 
@@ -196,15 +211,9 @@ void DifluidScales::sendHeartbeat() {
         return;
     }
 
-    uint32_t now = millis();
-    if (now - lastHeartbeat < 2000) {
-        return;
-    }
-
     uint8_t heartbeatCommand[] = {0xDF, 0xDF, 0x03, 0x05, 0x00, 0xC6};  // Use Func 0x03 and Cmd 0x05(Get Device Status) as the heartbeat.
     heartbeatCommand[5] = calculateChecksum(heartbeatCommand, sizeof(heartbeatCommand));
-    weightCharacteristic->writeValue(heartbeatCommand, sizeof(heartbeatCommand), true);
-    lastHeartbeat = now;
+    sendCommand(ScaleCommand::HEARTBEAT, weightCharacteristic, heartbeatCommand, sizeof(heartbeatCommand), true);
 }
 
 // Calculate checksum according to the protocol
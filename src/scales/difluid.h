@@ -17,10 +17,13 @@ public:
 private:
     NimBLERemoteService *service = nullptr;
     NimBLERemoteCharacteristic *weightCharacteristic = nullptr;
-    uint32_t lastHeartbeat = 0;
+    static constexpr uint32_t HEARTBEAT_PERIOD_MS = 2000;
     bool markedForReconnection = false;
+    FrameReassembler<64> reassembler;
 
     void notifyCallback(NimBLERemoteCharacteristic *pBLERemoteCharacteristic, uint8_t *pData, size_t length, bool isNotify);
+    // False on a checksum mismatch, so the reassembler rescans the frame.
+    bool handleFrame(const uint8_t *pData, size_t length);
     bool performConnectionHandshake();
     void setUnitToGram();
     void enableAutoNotifications();
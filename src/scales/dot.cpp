@@ -50,7 +50,7 @@ bool TimemoreDotScales::connect() {
     if (RemoteScales::clientConnect()) { linkUp = true; break; }
     RemoteScales::clientCleanup();
     RemoteScales::log("clientConnect attempt %d failed, retrying\n", attempt + 1);
-    delay(500);
+    remoteScalesDelay(500);
   }
   if (!linkUp) {
     RemoteScales::log("clientConnect gave up after retries\n");
@@ -66,6 +66,8 @@ bool TimemoreDotScales::connect() {
     return false;
   }
 
+  frames.reset();
+
   if (!performConnectionHandshake()) {
     return false;
   }
@@ -97,19 +99,22 @@ void TimemoreDotScales::update() {
     }
     markedForReconnection = false;
   }
+  RemoteScales::serviceStaleWatchdog();
+  RemoteScales::processCommandQueue();
 }
 
 bool TimemoreDotScales::tare() {
   if (!isConnected() || commandCharacteristic == nullptr) return false;
-  if (!commandCharacteristic->writeValue(TARE_CMD, sizeof(TARE_CMD), true)) {
-    RemoteScales::log("Tare write failed\n");
+  // The scale ACKs the tare command but only actually zeros the reading after
+  // receiving the status poll, so both go out back to back. Both are written
+  // with response so a GATT failure reaches the command callback instead of
+  // being silently dropped.
+  if (!RemoteScales::sendCommand(ScaleCommand::TARE, commandCharacteristic, TARE_CMD, sizeof(TARE_CMD), true)) {
+    RemoteScales::log("Tare could not be queued\n");
     return false;
   }
-  // The scale ACKs the tare command but only actually zeros the reading after
-  // receiving the status poll. Use waitResponse=true so a queue/GATT failure
-  // surfaces here rather than being silently dropped.
-  if (!commandCharacteristic->writeValue(HANDSHAKE_CMD, sizeof(HANDSHAKE_CMD), true)) {
-    RemoteScales::log("Tare follow-up poll failed; scale will not zero\n");
+  if (!RemoteScales::sendCommand(ScaleCommand::TARE, commandCharacteristic, HANDSHAKE_CMD, sizeof(HANDSHAKE_CMD), true)) {
+    RemoteScales::log("Tare follow-up poll could not be queued; scale will not zero\n");
     return false;
   }
   return true;
@@ -124,53 +129,48 @@ void TimemoreDotScales::notifyCallback(
   size_t length,
   bool isNotify
 ) {
-  dataBuffer.insert(dataBuffer.end(), data, data + length);
-  // Drain frames; each iteration consumes one frame and returns whether more
-  // remain in the buffer.
-  while (decodeAndHandleNotification()) {
-    // intentionally empty
+  size_t discarded = frames.feed(data, length,
+    [this](const uint8_t* frame, size_t available) -> int32_t {
+      if (frame[0] != MAGIC_0) return -1;
+      if (available < 2) return 0;
+      if (frame[1] != MAGIC_1) return -1;
+      if (available < 6) return 0;
+      uint16_t payloadLen = (static_cast<uint16_t>(frame[4]) << 8) | frame[5];
+      if (payloadLen > MAX_PAYLOAD_LEN) {
+        // Likely a glitched / desynced frame. Drop the magic byte and resync
+        // rather than blocking the parser waiting for bytes that may never come.
+        RemoteScales::log("Implausible payloadLen=%u, resyncing\n", payloadLen);
+        countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
+        return -1;
+      }
+      return static_cast<int32_t>(payloadLen + FRAME_HEADER_LEN);
+    },
+    [this](const uint8_t* frame, size_t frameLen) { handleMessage(frame, frameLen); });
+
+  if (discarded > 0) {
+    countHealth(ScaleHealthCounter::RESYNCS);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
   }
 }
 
-bool TimemoreDotScales::decodeAndHandleNotification() {
-  // Resync to magic bytes — drop leading garbage.
-  while (!dataBuffer.empty() && dataBuffer[0] != MAGIC_0) {
-    dataBuffer.erase(dataBuffer.begin());
-  }
-  if (dataBuffer.size() < FRAME_HEADER_LEN) return false;
-  if (dataBuffer[1] != MAGIC_1) {
-    dataBuffer.erase(dataBuffer.begin());
-    return !dataBuffer.empty();
-  }
-
-  uint16_t payloadLen = (static_cast<uint16_t>(dataBuffer[4]) << 8) | dataBuffer[5];
-  if (payloadLen > MAX_PAYLOAD_LEN) {
-    // Likely a glitched / desynced frame. Drop the magic byte and re-resync
-    // rather than blocking the parser waiting for bytes that may never come.
-    RemoteScales::log("Implausible payloadLen=%u, resyncing\n", payloadLen);
-    dataBuffer.erase(dataBuffer.begin());
-    return !dataBuffer.empty();
-  }
-  size_t frameLen = static_cast<size_t>(payloadLen) + FRAME_HEADER_LEN;
-  if (dataBuffer.size() < frameLen) return false;
-
-  uint8_t cls  = dataBuffer[2];
-  uint8_t type = dataBuffer[3];
+void TimemoreDotScales::handleMessage(const uint8_t* frame, size_t frameLen) {
+  uint8_t cls  = frame[2];
+  uint8_t type = frame[3];
+  size_t payloadLen = frameLen - FRAME_HEADER_LEN;
 
   if (cls == 0x01 && type == 0x01 && payloadLen == 9) {
     // Weight frame. Signed big-endian int32 at bytes [6..9], 0.1 g resolution.
-    int32_t raw = (static_cast<int32_t>(dataBuffer[6]) << 24) |
-                  (static_cast<int32_t>(dataBuffer[7]) << 16) |
-                  (static_cast<int32_t>(dataBuffer[8]) << 8)  |
-                   static_cast<int32_t>(dataBuffer[9]);
+    int32_t raw = (static_cast<int32_t>(frame[6]) << 24) |
+                  (static_cast<int32_t>(frame[7]) << 16) |
+                  (static_cast<int32_t>(frame[8]) << 8)  |
+                   static_cast<int32_t>(frame[9]);
+    countHealth(ScaleHealthCounter::FRAMES_OK);
     RemoteScales::setWeight(raw / 10.0f);
   } else {
+    countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
     RemoteScales::log("Unhandled frame cls=%02X type=%02X len=%u\n",
                       cls, type, (unsigned)payloadLen);
   }
-
-  dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + frameLen);
-  return !dataBuffer.empty();
 }
 
 bool TimemoreDotScales::performConnectionHandshake() {
@@ -197,11 +197,10 @@ bool TimemoreDotScales::subscribeToNotifications() {
   };
   // Try notify first; fall back to indicate. Some NimBLE/peripheral combos
   // mis-report capability bits, so do not gate on canNotify().
-  if (weightCharacteristic->subscribe(true, callback)) return true;
-  return weightCharacteristic->subscribe(false, callback);
+  if (subscribe(weightCharacteristic, callback)) return true;
+  return subscribe(weightCharacteristic, callback, false);
 }
 
 void TimemoreDotScales::sendHandshake() {
-  if (commandCharacteristic == nullptr) return;
-  commandCharacteristic->writeValue(HANDSHAKE_CMD, sizeof(HANDSHAKE_CMD), false);
+  RemoteScales::sendCommand(ScaleCommand::SETUP, commandCharacteristic, HANDSHAKE_CMD, sizeof(HANDSHAKE_CMD), false);
 }
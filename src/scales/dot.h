@@ -1,7 +1,6 @@
 #pragma once
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
-#include <Arduino.h>
 #include <NimBLEDevice.h>
 #include <vector>
 #include <memory>
@@ -23,14 +22,15 @@ private:
   NimBLERemoteCharacteristic* weightCharacteristic = nullptr;
   NimBLERemoteCharacteristic* commandCharacteristic = nullptr;
 
-  std::vector<uint8_t> dataBuffer;
+  // Frames carry at most 64 bytes of payload plus 8 of framing.
+  FrameReassembler<128> frames;
 
   bool performConnectionHandshake();
   bool subscribeToNotifications();
   void sendHandshake();
 
   void notifyCallback(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify);
-  bool decodeAndHandleNotification();
+  void handleMessage(const uint8_t* frame, size_t frameLen);
 };
 
 class TimemoreDotScalesPlugin {
@@ -9,7 +9,9 @@ const NimBLEUUID ECLAIR_CONFIG_CHAR_UUID("4F9A45BA-8E1B-4E07-E157-0814D393B968")
 // ---------------------------------   PUBLIC   --------------------------------------
 // -----------------------------------------------------------------------------------
 
-EclairScales::EclairScales(const DiscoveredDevice& device) : RemoteScales(device) {}
+EclairScales::EclairScales(const DiscoveredDevice& device) : RemoteScales(device) {
+    RemoteScales::schedulePeriodic(HEARTBEAT_PERIOD_MS, [this]() { sendHeartbeat(); });
+}
 
 bool EclairScales::connect() {
     if (RemoteScales::clientIsConnected()) {
@@ -25,6 +27,9 @@ bool EclairScales::connect() {
         return false;
     }
 
+    dataFrames.reset();
+    configFrames.reset();
+
     if (!performConnectionHandshake()) {
         RemoteScales::log("Handshake failed\n");
         return false;
@@ -32,7 +37,6 @@ bool EclairScales::connect() {
 
     subscribeToNotifications();
     RemoteScales::setWeight(0.f);
-    lastHeartbeat = millis();  // Initialize the heartbeat timestamp
     return true;
 }
 
@@ -49,12 +53,13 @@ void EclairScales::update() {
     if (!isConnected()) {
         RemoteScales::log("Device disconnected. Attempting to reconnect...\n");
         if (connect()) {
-            lastHeartbeat = millis();  // Reset the heartbeat timer after reconnecting
             RemoteScales::log("Reconnected to Eclair scale successfully.");
         }
     } else {
-        sendHeartbeat();  // Send the heartbeat signal if still connected
+        RemoteScales::runPeriodicTasks();
     }
+    RemoteScales::serviceStaleWatchdog();
+    RemoteScales::processCommandQueue();
 }
 
 bool EclairScales::tare() {
@@ -62,8 +67,10 @@ bool EclairScales::tare() {
     uint8_t tareCommand[2] = { static_cast<uint8_t>(EclairMessageType::TARE_COMMAND), 0x01 };
     uint8_t checksum = calculateXOR(&tareCommand[1], 1);  // Calculate checksum
     uint8_t message[3] = { tareCommand[0], tareCommand[1], checksum };
-    configCharacteristic->writeValue(message, sizeof(message), true);
-    RemoteScales::log("Sent tare command\n");
+    if (!RemoteScales::sendCommand(ScaleCommand::TARE, configCharacteristic, message, sizeof(message), true)) {
+        return false;
+    }
+    RemoteScales::log("Queued tare command\n");
     return true;
 }
 
@@ -93,7 +100,7 @@ bool EclairScales::performConnectionHandshake() {
     return true;
 }
 
-void EclairScales::sendMessage(EclairMessageType msgType, const uint8_t* data, size_t dataLength, bool waitResponse) {
+bool EclairScales::sendMessage(ScaleCommand command, EclairMessageType msgType, const uint8_t* data, size_t dataLength, bool waitResponse) {
     size_t totalLength = 1 + dataLength + 1; // Header + Data + Checksum
     auto bytes = std::make_unique<uint8_t[]>(totalLength);
     bytes[0] = static_cast<uint8_t>(msgType); // Message type
@@ -103,25 +110,47 @@ void EclairScales::sendMessage(EclairMessageType msgType, const uint8_t* data, s
 
     RemoteScales::log("Sending message: %s\n", RemoteScales::byteArrayToHexString(bytes.get(), totalLength).c_str());
 
-    configCharacteristic->writeValue(bytes.get(), totalLength, waitResponse);
+    return RemoteScales::sendCommand(command, configCharacteristic, bytes.get(), totalLength, waitResponse);
 }
 
 void EclairScales::notifyCallback(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
-    RemoteScales::log("Received notification from characteristic %s: %s\n",
-        characteristic->getUUID().toString().c_str(),
+    // Identify the source by pointer: both are cached at handshake, and it
+    // avoids building and comparing UUIDs on every notification.
+    const bool isData = characteristic == dataCharacteristic;
+    RemoteScales::log("Received notification from %s characteristic: %s\n",
+        isData ? "data" : "config",
         RemoteScales::byteArrayToHexString(data, length).c_str());
 
-    if (characteristic->getUUID() == ECLAIR_DATA_CHAR_UUID) {
-        handleDataNotification(data, length);
-    } else if (characteristic->getUUID() == ECLAIR_CONFIG_CHAR_UUID) {
-        handleConfigNotification(data, length);
+    size_t discarded = 0;
+    if (isData) {
+        discarded = dataFrames.feed(data, length,
+            [](const uint8_t* frame, size_t) -> int32_t {
+                bool known = frame[0] == static_cast<uint8_t>(EclairMessageType::WEIGHT)
+                    || frame[0] == static_cast<uint8_t>(EclairMessageType::FLOW_RATE);
+                return known ? DATA_FRAME_LENGTH : -1;
+            },
+            [this](const uint8_t* frame, size_t frameLength) { return handleDataNotification(frame, frameLength); });
+    } else if (characteristic == configCharacteristic) {
+        discarded = configFrames.feed(data, length,
+            [](const uint8_t* frame, size_t) -> int32_t {
+                bool known = frame[0] == static_cast<uint8_t>(EclairMessageType::BATTERY_STATUS)
+                    || frame[0] == static_cast<uint8_t>(EclairMessageType::TIMER_STATUS);
+                return known ? CONFIG_FRAME_LENGTH : -1;
+            },
+            [this](const uint8_t* frame, size_t frameLength) { return handleConfigNotification(frame, frameLength); });
+    }
+
+    if (discarded > 0) {
+        countHealth(ScaleHealthCounter::RESYNCS);
+        countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
     }
 }
 
-void EclairScales::handleDataNotification(uint8_t* data, size_t length) {
-    if (length < 10) { // Header (1 byte) + Data (8 bytes) + Checksum (1 byte)
+bool EclairScales::handleDataNotification(const uint8_t* data, size_t length) {
+    if (length < DATA_FRAME_LENGTH) { // Header (1 byte) + Data (8 bytes) + Checksum (1 byte)
+        countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
         RemoteScales::log("Data notification length too short\n");
-        return;
+        return false;
     }
 
     uint8_t header = data[0];
@@ -129,26 +158,35 @@ void EclairScales::handleDataNotification(uint8_t* data, size_t length) {
     uint8_t calculatedChecksum = calculateXOR(&data[1], length - 2); // Exclude header and checksum byte
 
     if (calculatedChecksum != checksum) {
+        countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
         RemoteScales::log("Invalid checksum in data notification: calculated %02X, received %02X\n", calculatedChecksum, checksum);
-        return;
+        return false;
     }
+    countHealth(ScaleHealthCounter::FRAMES_OK);
 
     if (header == static_cast<uint8_t>(EclairMessageType::WEIGHT)) {
-        int32_t rawWeight;
-        memcpy(&rawWeight, &data[1], 4); // Assuming little-endian
+        // Little-endian on the wire, independent of host byte order.
+        int32_t rawWeight = static_cast<int32_t>(
+            static_cast<uint32_t>(data[1]) |
+            (static_cast<uint32_t>(data[2]) << 8) |
+            (static_cast<uint32_t>(data[3]) << 16) |
+            (static_cast<uint32_t>(data[4]) << 24));
         float weight = rawWeight / 1000.0f; // Convert to grams
         RemoteScales::setWeight(weight);
     } else if (header == static_cast<uint8_t>(EclairMessageType::FLOW_RATE)) {
         RemoteScales::log("Received flow rate data\n");
     } else {
+        countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
         RemoteScales::log("Unknown data notification header: %02X\n", header);
     }
+    return true;
 }
 
-void EclairScales::handleConfigNotification(uint8_t* data, size_t length) {
-    if (length < 3) { // Header (1 byte) + Data (1 byte) + Checksum (1 byte)
+bool EclairScales::handleConfigNotification(const uint8_t* data, size_t length) {
+    if (length < CONFIG_FRAME_LENGTH) { // Header (1 byte) + Data (1 byte) + Checksum (1 byte)
+        countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
         RemoteScales::log("Config notification length too short\n");
-        return;
+        return false;
     }
 
     uint8_t header = data[0];
@@ -157,9 +195,11 @@ void EclairScales::handleConfigNotification(uint8_t* data, size_t length) {
     uint8_t calculatedChecksum = calculateXOR(&data[1], length - 2); // Exclude header and checksum byte
 
     if (calculatedChecksum != checksum) {
+        countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
         RemoteScales::log("Invalid checksum in config notification: calculated %02X, received %02X\n", calculatedChecksum, checksum);
-        return;
+        return false;
     }
+    countHealth(ScaleHealthCounter::FRAMES_OK);
 
     if (header == static_cast<uint8_t>(EclairMessageType::BATTERY_STATUS)) {
         battery = value;
@@ -167,8 +207,10 @@ void EclairScales::handleConfigNotification(uint8_t* data, size_t length) {
     } else if (header == static_cast<uint8_t>(EclairMessageType::TIMER_STATUS)) {
         RemoteScales::log("Timer status updated: %d\n", value);
     } else {
+        countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
         RemoteScales::log("Unknown config notification header: %02X\n", header);
     }
+    return true;
 }
 
 uint8_t EclairScales::calculateXOR(const uint8_t* data, size_t length) {
@@ -188,14 +230,14 @@ void EclairScales::subscribeToNotifications() {
 
     if (dataCharacteristic->canNotify()) {
         RemoteScales::log("Subscribing to data characteristic\n");
-        dataCharacteristic->subscribe(true, callback);
+        subscribe(dataCharacteristic, callback);
     } else {
         RemoteScales::log("Data characteristic cannot notify\n");
     }
 
     if (configCharacteristic->canNotify()) {
         RemoteScales::log("Subscribing to config characteristic\n");
-        configCharacteristic->subscribe(true, callback);
+        subscribe(configCharacteristic, callback);
     } else {
         RemoteScales::log("Config characteristic cannot notify\n");
     }
@@ -206,12 +248,6 @@ void EclairScales::sendHeartbeat() {
         return;
     }
 
-    uint32_t now = millis();
-    if (now - lastHeartbeat < 2000) {
-        return;
-    }
-
     uint8_t heartbeatCommand[] = { 0x00 };  // Example heartbeat command
-    sendMessage(EclairMessageType::TIMER_STATUS, heartbeatCommand, sizeof(heartbeatCommand));
-    lastHeartbeat = now;
+    sendMessage(ScaleCommand::HEARTBEAT, EclairMessageType::TIMER_STATUS, heartbeatCommand, sizeof(heartbeatCommand));
 }
\ No newline at end of file
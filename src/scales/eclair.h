@@ -1,7 +1,6 @@
 #pragma once
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
-#include <Arduino.h>
 #include <NimBLEDevice.h>
 #include <vector>
 #include <memory>
@@ -31,13 +30,19 @@ private:
     NimBLERemoteCharacteristic* dataCharacteristic = nullptr;
     NimBLERemoteCharacteristic* configCharacteristic = nullptr;
     uint8_t battery = 0;
-    uint32_t lastHeartbeat = 0;
+    static constexpr uint32_t HEARTBEAT_PERIOD_MS = 2000;
+
+    static constexpr int32_t DATA_FRAME_LENGTH = 10;   // header, 8 data bytes, checksum
+    static constexpr int32_t CONFIG_FRAME_LENGTH = 3;  // header, value, checksum
+    FrameReassembler<32> dataFrames;
+    FrameReassembler<16> configFrames;
 
     bool performConnectionHandshake();
-    void sendMessage(EclairMessageType msgType, const uint8_t* data, size_t dataLength, bool waitResponse = false);
+    bool sendMessage(ScaleCommand command, EclairMessageType msgType, const uint8_t* data, size_t dataLength, bool waitResponse = false);
     void notifyCallback(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify);
-    void handleDataNotification(uint8_t* data, size_t length);
-    void handleConfigNotification(uint8_t* data, size_t length);
+    // Both return false on a bad frame, so the reassembler rescans it.
+    bool handleDataNotification(const uint8_t* data, size_t length);
+    bool handleConfigNotification(const uint8_t* data, size_t length);
     uint8_t calculateXOR(const uint8_t* data, size_t length);
     void subscribeToNotifications();
     void sendHeartbeat();
@@ -1,7 +1,8 @@
 #include "eureka.h"
 #include "remote_scales_plugin_registry.h"
 
-const size_t RECEIVE_PROTOCOL_LENGTH = 11;
+const int32_t RECEIVE_PROTOCOL_LENGTH = 11;
+const size_t WEIGHT_SIGN_OFFSET = 6;
 
 const NimBLEUUID serviceUUID("FFF0");
 const NimBLEUUID weightCharacteristicUUID("FFF1");
@@ -37,6 +38,8 @@ bool EurekaScales::connect() {
     return false;
   }
 
+  frames.reset();
+
   if (!performConnectionHandshake()) {
     return false;
   }
@@ -60,19 +63,15 @@ void EurekaScales::update() {
     connect();
     markedForReconnection = false;
   }
-  else {
-    sendHeartbeat();
-    RemoteScales::log("Heartbeat sent.\n");
-  }
+  RemoteScales::serviceStaleWatchdog();
+  RemoteScales::processCommandQueue();
 }
 
 bool EurekaScales::tare() {
   if (!isConnected()) return false;
   RemoteScales::log("Tare sent");
   uint8_t payload[6] = { CMD_HEADER, CMD_BASE, CMD_TARE, CMD_TARE };
-  sendMessage(payload, sizeof(payload));
-
-  return true;
+  return sendMessage(ScaleCommand::TARE, payload, sizeof(payload));
 };
 
 //-----------------------------------------------------------------------------------/
@@ -84,38 +83,32 @@ void EurekaScales::notifyCallback(
   size_t length,
   bool isNotify
 ) {
-  dataBuffer.insert(dataBuffer.end(), pData, pData + length);
-  bool result = true;
-  while (result) {
-    result = decodeAndHandleNotification();
+  size_t discarded = frames.feed(pData, length,
+    [](const uint8_t* frame, size_t available) -> int32_t {
+      // Frames share the 0xAA header with commands. Byte 6 is the sign
+      // flag, which rules out most false starts inside a weight value.
+      if (frame[0] != CMD_HEADER) return -1;
+      if (available > WEIGHT_SIGN_OFFSET && frame[WEIGHT_SIGN_OFFSET] > 1) return -1;
+      return RECEIVE_PROTOCOL_LENGTH;
+    },
+    [this](const uint8_t* frame, size_t) { handleFrame(frame); });
+
+  if (discarded > 0) {
+    countHealth(ScaleHealthCounter::RESYNCS);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
   }
 }
 
-bool EurekaScales::decodeAndHandleNotification() {
-  // Minimum message length check (11 bytes based on protocol definition)
-  if (dataBuffer.size() < RECEIVE_PROTOCOL_LENGTH) {
-    return false;
-  }
-
-  bool is_negative = dataBuffer[6];
-
-  uint8_t productNumber = dataBuffer[0];
+// AA .. .. .. .. .. [sign] [weight lo] [weight hi] .. ..
+void EurekaScales::handleFrame(const uint8_t* frame) {
+  float weight = (frame[8] << 8) + frame[7];
 
-  size_t messageLength = dataBuffer.size();
-
-  float weight = (dataBuffer[8] << 8) + dataBuffer[7];
-
-  if (dataBuffer[6]) { // Check if the value is negative
+  if (frame[WEIGHT_SIGN_OFFSET]) { // Check if the value is negative
     weight = -weight;
   }
 
+  countHealth(ScaleHealthCounter::FRAMES_OK);
   RemoteScales::setWeight(weight * 0.1f); // Convert to floating point
-
-  // Remove processed message from the buffer
-  dataBuffer.erase(dataBuffer.begin(), dataBuffer.end());
-
-  // Return whether there's more data to process
-  return false;
 }
 
 bool EurekaScales::performConnectionHandshake() {
@@ -141,14 +134,6 @@ bool EurekaScales::performConnectionHandshake() {
   return true;
 }
 
-void EurekaScales::sendHeartbeat() {
-  if (!isConnected()) {
-    return;
-  }
-
-  // No heartbeat necessary
-}
-
 void EurekaScales::subscribeToNotifications() {
   RemoteScales::log("subscribeToNotifications\n");
 
@@ -158,17 +143,15 @@ void EurekaScales::subscribeToNotifications() {
 
   if (weightCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for weight characteristic\n");
-    weightCharacteristic->subscribe(true, callback);
+    subscribe(weightCharacteristic, callback);
   }
 
   if (commandCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for command characteristic\n");
-    commandCharacteristic->subscribe(true, callback);
+    subscribe(commandCharacteristic, callback);
   }
 }
 
-void EurekaScales::sendMessage(const uint8_t* payload, size_t length, bool waitResponse) {
-  auto bytes = std::make_unique<uint8_t[]>(length);
-  memcpy(bytes.get(), payload, length);
-  commandCharacteristic->writeValue(bytes.get(), length, waitResponse);
+bool EurekaScales::sendMessage(ScaleCommand command, const uint8_t* payload, size_t length, bool waitResponse) {
+  return RemoteScales::sendCommand(command, commandCharacteristic, payload, length, waitResponse);
 }
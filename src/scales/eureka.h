@@ -1,7 +1,6 @@
 #pragma once
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
-#include <Arduino.h>
 #include <NimBLEDevice.h>
 #include <NimBLEUtils.h>
 #include <NimBLEScan.h>
@@ -25,16 +24,15 @@ private:
   NimBLERemoteCharacteristic* weightCharacteristic;
   NimBLERemoteCharacteristic* commandCharacteristic;
 
-  std::vector<uint8_t> dataBuffer;
+  FrameReassembler<64> frames;
 
   bool performConnectionHandshake();
   void subscribeToNotifications();
 
-  void sendMessage(const uint8_t* payload, size_t length, bool waitResponse = false);
-  void sendHeartbeat();
+  bool sendMessage(ScaleCommand command, const uint8_t* payload, size_t length, bool waitResponse = false);
   void sendId();
   void notifyCallback(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify);
-  bool decodeAndHandleNotification();
+  void handleFrame(const uint8_t* frame);
 };
 
 class EurekaScalesPlugin {
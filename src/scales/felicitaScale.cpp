@@ -17,6 +17,7 @@ bool FelicitaScale::connect() {
         clientCleanup();
         return false;
     }
+    reassembler.reset();
 
     if (!performConnectionHandshake()) {
         clientCleanup();
@@ -43,14 +44,15 @@ void FelicitaScale::update() {
     } else {
       verifyConnected();
     }
+    serviceStaleWatchdog();
+    processCommandQueue();
 }
 
 bool FelicitaScale::tare() {
     if (!verifyConnected()) return false;
-    log("Tare command sent.\n");
+    log("Tare command queued.\n");
     uint8_t tareCommand[] = {CMD_TARE};
-    dataCharacteristic->writeValue(tareCommand, sizeof(tareCommand), false);
-    return true;
+    return sendCommand(ScaleCommand::TARE, dataCharacteristic, tareCommand, sizeof(tareCommand), false);
 }
 
 bool FelicitaScale::performConnectionHandshake() {
@@ -69,7 +71,7 @@ bool FelicitaScale::performConnectionHandshake() {
     }
 
     if (dataCharacteristic->canNotify()) {
-        dataCharacteristic->subscribe(true, [this](NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
+        subscribe(dataCharacteristic, [this](NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
             notifyCallback(characteristic, data, length, isNotify);
         });
     } else {
@@ -92,14 +94,30 @@ bool FelicitaScale::verifyConnected() {
 
 void FelicitaScale::notifyCallback(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
     log("Notification received.\n");
-    if (length < 18) {
-        log("Malformed data.\n");
-        return;
+    // The protocol has no sync bytes, so a frame start is recognised by its
+    // sign character followed by six ASCII digits of weight.
+    size_t discarded = reassembler.feed(data, length,
+        [](const uint8_t* frame, size_t available) -> int32_t {
+            if (available < 3) return 0;
+            if (frame[2] != '+' && frame[2] != '-') return -1;
+            for (size_t i = 3; i < 9 && i < available; i++) {
+                if (frame[i] < '0' || frame[i] > '9') return -1;
+            }
+            return FRAME_LENGTH;
+        },
+        [this](const uint8_t* frame, size_t) {
+            countHealth(ScaleHealthCounter::FRAMES_OK);
+            parseStatusUpdate(frame);
+        });
+
+    if (discarded > 0) {
+        countHealth(ScaleHealthCounter::RESYNCS);
+        countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
+        log("Malformed data, skipped %u bytes.\n", (unsigned)discarded);
     }
-    parseStatusUpdate(data, length);
 }
 
-void FelicitaScale::parseStatusUpdate(const uint8_t* data, size_t length) {
+void FelicitaScale::parseStatusUpdate(const uint8_t* data) {
     float weight = static_cast<float>(parseWeight(data)) / 100.0f;
     setWeight(weight);
     // log("Weight updated: %.1f g\n", weight);
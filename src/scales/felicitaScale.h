@@ -18,19 +18,21 @@ private:
     NimBLERemoteCharacteristic* dataCharacteristic = nullptr;
     uint32_t lastHeartbeat = 0;
     bool markedForReconnection = false;
+    FrameReassembler<64> reassembler;
 
     void notifyCallback(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify);
     bool performConnectionHandshake();
     void toggleUnit();
     void togglePrecision();
     bool verifyConnected(void);
-    void parseStatusUpdate(const uint8_t* data, size_t length);
+    void parseStatusUpdate(const uint8_t* data);
     uint8_t calculateChecksum(const uint8_t* data, size_t length);
     int32_t parseWeight(const uint8_t* data);
 
     // Constants specific to Felicita Scales
     static const NimBLEUUID DATA_SERVICE_UUID;
     static const NimBLEUUID DATA_CHARACTERISTIC_UUID;
+    static constexpr int32_t FRAME_LENGTH = 18;
     static constexpr uint8_t CMD_TARE = 0x54;
     static constexpr uint8_t CMD_TOGGLE_UNIT = 0x55;
     static constexpr uint8_t CMD_TOGGLE_PRECISION = 0x44;
@@ -23,6 +23,7 @@ bool myscale::connect() {
         clientCleanup();
         return false;
     }
+    frames.reset();
     setWeight(0.f);
     return true;
 }
@@ -44,6 +45,8 @@ void myscale::update() {
     } else {
       verifyConnected();
     }
+    serviceStaleWatchdog();
+    processCommandQueue();
 }
 
 bool myscale::tare() {
@@ -62,8 +65,10 @@ bool myscale::tare() {
         return false;
     }
 
-    writeChar->writeValue(tare_value, sizeof(tare_value), false); // write without response
-    log("Tare command sent.\n");
+    if (!sendCommand(ScaleCommand::TARE, writeChar, tare_value, sizeof(tare_value), false)) { // write without response
+        return false;
+    }
+    log("Tare command queued.\n");
     return true;
 }
 
@@ -86,9 +91,9 @@ bool myscale::performConnectionHandshake() {
         auto cccd = dataCharacteristic->getDescriptor(NimBLEUUID((uint16_t)0x2902));
         if (cccd) {
             uint8_t notifyOn[] = {0x01, 0x00};
-            cccd->writeValue(notifyOn, 2, true); // enable notifications
+            sendCommand(ScaleCommand::SETUP, cccd, notifyOn, sizeof(notifyOn)); // enable notifications
         }
-        dataCharacteristic->subscribe(true, [this](NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
+        subscribe(dataCharacteristic, [this](NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
             notifyCallback(characteristic, data, length, isNotify);
         });
     } else {
@@ -117,16 +122,33 @@ bool myscale::verifyConnected() {
 }
 
 void myscale::notifyCallback(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
-    if (length < 15) {
-        log("Malformed data.\n");
-        return;
+    size_t discarded = frames.feed(data, length,
+        [](const uint8_t* frame, size_t) -> int32_t {
+            return frame[0] == 0xAC ? static_cast<int32_t>(FRAME_LENGTH) : -1;
+        },
+        [this](const uint8_t* frame, size_t frameLength) { return handleFrame(frame, frameLength); });
+
+    if (discarded > 0) {
+        countHealth(ScaleHealthCounter::RESYNCS);
+        countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
     }
-    parseStatusUpdate(data, length);
+}
+
+bool myscale::handleFrame(const uint8_t* frame, size_t length) {
+    if (calculateChecksum(frame, length) != frame[length - 1]) {
+        // Rejected, so the reassembler looks for a frame starting inside this one.
+        countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
+        log("Wrong checksum\n");
+        return false;
+    }
+    countHealth(ScaleHealthCounter::FRAMES_OK);
+    parseStatusUpdate(frame);
+    return true;
 }
 
 
 
-void myscale::parseStatusUpdate(const uint8_t* data, size_t length) {
+void myscale::parseStatusUpdate(const uint8_t* data) {
     int32_t raw = parseWeight(data);
     float weight = static_cast<float>(raw) / 1000.0f; 
     setWeight(weight);
@@ -20,12 +20,17 @@ private:
     uint32_t lastHeartbeat = 0;
     bool markedForReconnection = false;
 
+    // Weight frames: 0xAC, then 18 bytes, then a sum of everything before it.
+    static constexpr size_t FRAME_LENGTH = 20;
+    FrameReassembler<64> frames;
+
     void notifyCallback(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify);
     bool performConnectionHandshake();
     void toggleUnit();
     void togglePrecision();
     bool verifyConnected(void);
-    void parseStatusUpdate(const uint8_t* data, size_t length);
+    bool handleFrame(const uint8_t* frame, size_t length);
+    void parseStatusUpdate(const uint8_t* data);
     uint8_t calculateChecksum(const uint8_t* data, size_t length);
     int32_t parseWeight(const uint8_t* data);
 
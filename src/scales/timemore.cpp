@@ -6,7 +6,8 @@ enum class TimemoreEventType : uint8_t {
   WEIGHT = 0x10,
 };
 
-const size_t RECEIVE_PROTOCOL_LENGTH = 9;
+const int32_t RECEIVE_PROTOCOL_LENGTH = 9;
+const int32_t MAX_PLAUSIBLE_WEIGHT_RAW = 50000; // 5 kg
 
 const NimBLEUUID serviceUUID("181D");
 const NimBLEUUID weightCharacteristicUUID("2A9D");
@@ -15,7 +16,9 @@ const NimBLEUUID commandCharacteristicUUID("553f4e49-bf21-4468-9c6c-0e4fb5b17697
 //-----------------------------------------------------------------------------------/
 //---------------------------        PUBLIC       -----------------------------------/
 //-----------------------------------------------------------------------------------/
-TimemoreScales::TimemoreScales(const DiscoveredDevice& device) : RemoteScales(device) {}
+TimemoreScales::TimemoreScales(const DiscoveredDevice& device) : RemoteScales(device) {
+  RemoteScales::schedulePeriodic(HEARTBEAT_PERIOD_MS, [this]() { sendHeartbeat(); });
+}
 
 bool TimemoreScales::connect() {
   if (RemoteScales::clientIsConnected()) {
@@ -30,6 +33,8 @@ bool TimemoreScales::connect() {
     return false;
   }
 
+  frames.reset();
+
   if (!performConnectionHandshake()) {
     return false;
   }
@@ -54,62 +59,72 @@ void TimemoreScales::update() {
     markedForReconnection = false;
   }
   else {
-    sendHeartbeat();
+    RemoteScales::runPeriodicTasks();
   }
+  RemoteScales::serviceStaleWatchdog();
+  RemoteScales::processCommandQueue();
 }
 
 bool TimemoreScales::tare() {
   if (!isConnected()) return false;
   uint8_t payload[] = { 0x00 };
-  sendMessage(TimemoreMessageType::TARE, payload, sizeof(payload));
-  return true;
+  return sendMessage(ScaleCommand::TARE, TimemoreMessageType::TARE, payload, sizeof(payload));
 };
 
 //-----------------------------------------------------------------------------------/
 //---------------------------       PRIVATE       -----------------------------------/
 //-----------------------------------------------------------------------------------/
+static int32_t readInt32LE(const uint8_t* data) {
+  return static_cast<int32_t>(
+    static_cast<uint32_t>(data[0]) |
+    (static_cast<uint32_t>(data[1]) << 8) |
+    (static_cast<uint32_t>(data[2]) << 16) |
+    (static_cast<uint32_t>(data[3]) << 24));
+}
+
+// Both readings are in 0.1 g; a frame claiming more than this on either is a
+// misaligned window, not a weight.
+static bool plausibleWeight(int32_t raw) {
+  return raw >= -MAX_PLAUSIBLE_WEIGHT_RAW && raw <= MAX_PLAUSIBLE_WEIGHT_RAW;
+}
+
 void TimemoreScales::notifyCallback(
   NimBLERemoteCharacteristic* pBLERemoteCharacteristic,
   uint8_t* pData,
   size_t length,
   bool isNotify
 ) {
-  dataBuffer.insert(dataBuffer.end(), pData, pData + length);
-  bool result = true;
-  while (result) {
-    result = decodeAndHandleNotification();
+  // The stream has no sync bytes or checksum. A byte lost on the way used to
+  // shift every later frame; instead each candidate start must carry the
+  // type byte and two plausible readings, otherwise we slide by one.
+  size_t discarded = frames.feed(pData, length,
+    [](const uint8_t* frame, size_t available) -> int32_t {
+      if (frame[0] != static_cast<uint8_t>(TimemoreEventType::WEIGHT)) return -1;
+      if (available < RECEIVE_PROTOCOL_LENGTH) return 0;
+      if (!plausibleWeight(readInt32LE(frame + 1)) || !plausibleWeight(readInt32LE(frame + 5))) return -1;
+      return RECEIVE_PROTOCOL_LENGTH;
+    },
+    [this](const uint8_t* frame, size_t) { handleFrame(frame); });
+
+  if (discarded > 0) {
+    countHealth(ScaleHealthCounter::RESYNCS);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
+    RemoteScales::log("Resynced weight stream, skipped %u bytes\n", (unsigned)discarded);
   }
 }
 
-bool TimemoreScales::decodeAndHandleNotification() {
-  // Minimum message length check
-  if (dataBuffer.size() < RECEIVE_PROTOCOL_LENGTH) {
-    return false;
-  }
-
-  // Handle different message types
-  TimemoreEventType messageType = static_cast<TimemoreEventType>(dataBuffer[0]);
-  if (messageType == TimemoreEventType::WEIGHT) {
-    // 10 78 08 00 00 78 08 00 00
-    //   |___________|___________|
-    // Dripper Weight|Scale Weight
-    // Both are little-endian 32-bit integer
-    // E.g. 78 08 00 00 = 2168 / 10 = 216.8g
-
-    //float_t dripperWeight = dataBuffer[1] | (dataBuffer[2] << 8) | (dataBuffer[3] << 16) | (dataBuffer[4] << 24);
-    float_t scaleWeight = dataBuffer[5] | (dataBuffer[6] << 8) | (dataBuffer[7] << 16) | (dataBuffer[8] << 24);
+void TimemoreScales::handleFrame(const uint8_t* frame) {
+  // 10 78 08 00 00 78 08 00 00
+  //   |___________|___________|
+  // Dripper Weight|Scale Weight
+  // Both are little-endian 32-bit integer
+  // E.g. 78 08 00 00 = 2168 / 10 = 216.8g
 
-    RemoteScales::setWeight(scaleWeight / 10.0f); // Convert to floating point
-  }
-  else {
-    RemoteScales::log("Unknown message type %02X: %s\n", messageType, RemoteScales::byteArrayToHexString(dataBuffer.data(), dataBuffer.size()).c_str());
-  }
+  //int32_t dripperWeight = readInt32LE(frame + 1);
+  int32_t scaleWeight = readInt32LE(frame + 5);
 
-  // Remove processed message from the buffer
-  dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + RECEIVE_PROTOCOL_LENGTH);
-
-  // Return whether there's more data to process
-  return dataBuffer.size() >= RECEIVE_PROTOCOL_LENGTH;
+  countHealth(ScaleHealthCounter::FRAMES_OK);
+  RemoteScales::setWeight(scaleWeight / 10.0f); // Convert to floating point
 }
 
 bool TimemoreScales::performConnectionHandshake() {
@@ -139,22 +154,21 @@ bool TimemoreScales::performConnectionHandshake() {
   RemoteScales::log("Got notifyDescriptor\n");
   if (notifyDescriptor != nullptr) {
     uint8_t value[2] = { 0x01, 0x00 };
-    notifyDescriptor->writeValue(value, 2, true);
+    RemoteScales::sendCommand(ScaleCommand::SETUP, notifyDescriptor, value, sizeof(value));
   }
   else {
     clientCleanup();
     return false;
   }
 
-  sendNotificationRequest();
+  sendNotificationRequest(ScaleCommand::SETUP);
   RemoteScales::log("Sent notification request\n");
-  lastHeartbeat = millis();
   return true;
 }
 
-void TimemoreScales::sendNotificationRequest() {
+void TimemoreScales::sendNotificationRequest(ScaleCommand command) {
   uint8_t payload[] = { 0x02, 0x00 };
-  sendMessage(TimemoreMessageType::WEIGHT, payload, 2);
+  sendMessage(command, TimemoreMessageType::WEIGHT, payload, 2);
 }
 
 void TimemoreScales::sendHeartbeat() {
@@ -162,14 +176,8 @@ void TimemoreScales::sendHeartbeat() {
     return;
   }
 
-  uint32_t now = millis();
-  if (now - lastHeartbeat < 2000) {
-    return;
-  }
-
   uint8_t payload[] = { 0x00 };
-  sendMessage(TimemoreMessageType::WEIGHT, payload, 1);
-  lastHeartbeat = now;
+  sendMessage(ScaleCommand::HEARTBEAT, TimemoreMessageType::WEIGHT, payload, 1);
 }
 
 void TimemoreScales::subscribeToNotifications() {
@@ -180,14 +188,15 @@ void TimemoreScales::subscribeToNotifications() {
   };
 
   if (weightCharacteristic->canIndicate()) {
-    weightCharacteristic->subscribe(false, callback, true);
+    subscribe(weightCharacteristic, callback, false, true);
   }
 }
 
-void TimemoreScales::sendMessage(TimemoreMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse) {
+bool TimemoreScales::sendMessage(ScaleCommand command, TimemoreMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse) {
   if (msgType == TimemoreMessageType::TARE) {
-    commandCharacteristic->writeValue(payload, length, true);
+    return RemoteScales::sendCommand(command, commandCharacteristic, payload, length, true);
   } else if (msgType == TimemoreMessageType::WEIGHT) {
-    weightCharacteristic->writeValue(payload, length, true);
+    return RemoteScales::sendCommand(command, weightCharacteristic, payload, length, true);
   }
+  return false;
 }
\ No newline at end of file
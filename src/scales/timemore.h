@@ -1,7 +1,6 @@
 #pragma once
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
-#include <Arduino.h>
 #include <NimBLEDevice.h>
 #include <NimBLEUtils.h>
 #include <NimBLEScan.h>
@@ -24,7 +23,7 @@ public:
   bool tare() override;
 
 private:
-  uint32_t lastHeartbeat = 0;
+  static constexpr uint32_t HEARTBEAT_PERIOD_MS = 2000;
 
   bool markedForReconnection = false;
 
@@ -32,16 +31,16 @@ private:
   NimBLERemoteCharacteristic* weightCharacteristic;
   NimBLERemoteCharacteristic* commandCharacteristic;
 
-  std::vector<uint8_t> dataBuffer;
+  FrameReassembler<32> frames;
 
   bool performConnectionHandshake();
   void subscribeToNotifications();
 
-  void sendMessage(TimemoreMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
+  bool sendMessage(ScaleCommand command, TimemoreMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
   void sendHeartbeat();
-  void sendNotificationRequest();
+  void sendNotificationRequest(ScaleCommand command);
   void notifyCallback(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify);
-  bool decodeAndHandleNotification();
+  void handleFrame(const uint8_t* frame);
 };
 
 class TimemoreScalesPlugin {
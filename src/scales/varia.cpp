@@ -21,6 +21,7 @@ bool VariaScales::connect() {
     clientCleanup();
     return false;
   }
+  reassembler.reset();
 
   if (!fetchServices()) {
     return false;
@@ -46,8 +47,7 @@ bool VariaScales::tare() {
   log("Sending tare command\n");
   uint8_t cmd = static_cast<uint8_t>(VariaMessageType::TARE);
   uint8_t payload[] = { cmd, 0x01, 0x01 };
-  sendMessage(VariaMessageType::SYSTEM, payload, sizeof(payload));
-  return true;
+  return sendMessage(ScaleCommand::TARE, VariaMessageType::SYSTEM, payload, sizeof(payload));
 };
 
 //-----------------------------------------------------------------------------------/
@@ -84,11 +84,11 @@ void VariaScales::subscribeToNotifications() {
 
   if (weightCharacteristic->canNotify()) {
     log("Registering callback for weight characteristic\n");
-    weightCharacteristic->subscribe(true, callback);
+    subscribe(weightCharacteristic, callback);
   }
 }
 
-void VariaScales::sendMessage(VariaMessageType msgType, const uint8_t* payload, size_t payloadLen, bool waitResponse) {
+bool VariaScales::sendMessage(ScaleCommand command, VariaMessageType msgType, const uint8_t* payload, size_t payloadLen, bool waitResponse) {
   uint8_t checksum = payload[0];
   for (size_t i = 1; i < payloadLen; i++) {
     checksum ^= payload[i];
@@ -102,90 +102,91 @@ void VariaScales::sendMessage(VariaMessageType msgType, const uint8_t* payload,
   memcpy(bytes.get()+1, payload, payloadLen);
   bytes[msgLen - 1] = checksum;
 
-  commandCharacteristic->writeValue(bytes.get(), msgLen, waitResponse);
+  return sendCommand(command, commandCharacteristic, bytes.get(), msgLen, waitResponse);
 }
 
 void VariaScales::notifyCallback(NimBLERemoteCharacteristic* pRemoteCharacteristic, uint8_t* data, size_t length, bool isNotify) {
-  if(length < 2) {
-    log("notifyCallback: message too short, expected at least 2 bytes, got: %s\n", byteArrayToHexString(data, length).c_str());
-    return;
-  }
-  if(data[0] != static_cast<uint8_t>(VariaMessageType::SYSTEM)) {
-    log("notifyCallback: Only system type messages are supported: %s\n", byteArrayToHexString(data, length).c_str());
-    return;
-  }
-
-  while(length > 0) {
-    VariaMessageType messageType = static_cast<VariaMessageType>(data[1]);
-
-    switch(messageType) {
-    case VariaMessageType::WEIGHT:
-    {
-      // [FA 01] 03 10 02 CD {DD}
-      const size_t msgLen = 7;
-      if(! validNotifiedMessage(data, length, msgLen)) {
-        log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
-        return;
-      }
-      int sign = (data[3] & 0x10) == 0 ? 1 : -1;
-      int value = ((data[3] & 0x0f) << 16) + (data[4] << 8) + data[5];
-      setWeight(sign * value * 0.01f);
-      data += msgLen;
-      length -= msgLen;
-      break;
-    }
-    case VariaMessageType::TIMER:
-    {
-      // [FA 87] 02 00 02 {87}
-      const size_t msgLen = 6;
-      if(!validNotifiedMessage(data, length, msgLen)) {
-        log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
-        return;
-      }
-      timerSeconds = (data[3] << 8) + data[4];
-      data += msgLen;
-      length -= msgLen;
-      break;
+  size_t discarded = reassembler.feed(data, length,
+    [](const uint8_t* frame, size_t available) -> int32_t {
+      if (frame[0] != static_cast<uint8_t>(VariaMessageType::SYSTEM)) return -1;
+      if (available < 3) return 0;
+      // [FA type len] payload {xor}
+      return frame[2] + 4;
+    },
+    [this](const uint8_t* frame, size_t frameLength) { return handleMessage(frame, frameLength); });
+
+  if (discarded > 0) {
+    countHealth(ScaleHealthCounter::RESYNCS);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
+    log("notifyCallback: skipped %u bytes looking for a message start\n", (unsigned)discarded);
+  }
+}
+
+bool VariaScales::handleMessage(const uint8_t* data, size_t length) {
+  VariaMessageType messageType = static_cast<VariaMessageType>(data[1]);
+
+  switch(messageType) {
+  case VariaMessageType::WEIGHT:
+  {
+    // [FA 01] 03 10 02 CD {DD}
+    const size_t msgLen = 7;
+    if(! validNotifiedMessage(data, length, msgLen)) {
+      log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
+      return false;
     }
-    case VariaMessageType::TIMER_START:
-    case VariaMessageType::TIMER_STOP:
-    case VariaMessageType::TIMER_RESET:
-    {
-      // [FA 88] 01 01 {88}
-      // [FA 89] 01 02 {8A}
-      // [FA 8A] 01 03 {88}
-      const size_t msgLen = 5;
-      if(!validNotifiedMessage(data, length, msgLen)) {
-        log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
-        return;
-      }
-      log("Timer event: %02x\n", data[1]);
-      data += msgLen;
-      length -= msgLen;
-      break;
+    int sign = (data[3] & 0x10) == 0 ? 1 : -1;
+    int value = ((data[3] & 0x0f) << 16) + (data[4] << 8) + data[5];
+    setWeight(sign * value * 0.01f);
+    break;
+  }
+  case VariaMessageType::TIMER:
+  {
+    // [FA 87] 02 00 02 {87}
+    const size_t msgLen = 6;
+    if(!validNotifiedMessage(data, length, msgLen)) {
+      log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
+      return false;
     }
-    case VariaMessageType::BATTERY:
-    {
-      // [FA 85] 01 4B {CF}
-      const size_t msgLen = 5;
-      if(!validNotifiedMessage(data, length, msgLen)) {
-        log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
-        return;
-      }
-      batteryPercent = data[3];
-      data += msgLen;
-      length -= msgLen;
-      break;
+    timerSeconds = (data[3] << 8) + data[4];
+    break;
+  }
+  case VariaMessageType::TIMER_START:
+  case VariaMessageType::TIMER_STOP:
+  case VariaMessageType::TIMER_RESET:
+  {
+    // [FA 88] 01 01 {88}
+    // [FA 89] 01 02 {8A}
+    // [FA 8A] 01 03 {88}
+    const size_t msgLen = 5;
+    if(!validNotifiedMessage(data, length, msgLen)) {
+      log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
+      return false;
     }
-    default:
-      // log("Unknown message type %02X: %s\n", messageType, byteArrayToHexString(data, length).c_str());
-      return;
+    log("Timer event: %02x\n", data[1]);
+    break;
+  }
+  case VariaMessageType::BATTERY:
+  {
+    // [FA 85] 01 4B {CF}
+    const size_t msgLen = 5;
+    if(!validNotifiedMessage(data, length, msgLen)) {
+      log("Invalid message of type %02x: %s\n", messageType, byteArrayToHexString(data, length).c_str());
+      return false;
     }
+    batteryPercent = data[3];
+    break;
+  }
+  default:
+    countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
+    // log("Unknown message type %02X: %s\n", messageType, byteArrayToHexString(data, length).c_str());
+    break;
   }
+  return true;
 }
 
-bool VariaScales::validNotifiedMessage(uint8_t* data, size_t length, size_t expectedLength) {
+bool VariaScales::validNotifiedMessage(const uint8_t* data, size_t length, size_t expectedLength) {
   if(length < expectedLength) {
+    countHealth(ScaleHealthCounter::MALFORMED_FRAMES);
     return false;
   }
 
@@ -197,5 +198,10 @@ bool VariaScales::validNotifiedMessage(uint8_t* data, size_t length, size_t expe
   for(size_t idx = xorFirst+1; idx <= xorLast; idx++) {
     sum ^= data[idx];
   }
-  return sum == data[xorExpected];
+  if(sum != data[xorExpected]) {
+    countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
+    return false;
+  }
+  countHealth(ScaleHealthCounter::FRAMES_OK);
+  return true;
 }
\ No newline at end of file
@@ -17,7 +17,10 @@ class VariaScales : public RemoteScales {
 
 public:
   VariaScales(const DiscoveredDevice& device);
-  void update() override {};
+  void update() override {
+    serviceStaleWatchdog();
+    processCommandQueue();
+  };
   bool connect() override;
   void disconnect() override;
   bool isConnected() override;
@@ -28,16 +31,19 @@ private:
   NimBLERemoteCharacteristic* weightCharacteristic = nullptr;
   NimBLERemoteCharacteristic* commandCharacteristic = nullptr;
 
+  FrameReassembler<64> reassembler;
   int batteryPercent = 0;
   int timerSeconds = 0;
 
   bool fetchServices();
   void subscribeToNotifications();
 
-  void sendMessage(VariaMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
+  bool sendMessage(ScaleCommand command, VariaMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
   void notifyCallback(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify);
+  // False when the message fails validation, so the reassembler rescans it.
+  bool handleMessage(const uint8_t* data, size_t length);
 
-  bool validNotifiedMessage(uint8_t* data, size_t length, size_t expectedLength);
+  bool validNotifiedMessage(const uint8_t* data, size_t length, size_t expectedLength);
 };
 
 class VariaScalesPlugin {
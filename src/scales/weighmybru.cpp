@@ -13,7 +13,9 @@ const NimBLEUUID commandCharacteristicUUID("6E400003-B5A3-F393-E0A9-E50E24DCCA9E
 //-----------------------------------------------------------------------------------/
 //---------------------------        PUBLIC       -----------------------------------/
 //-----------------------------------------------------------------------------------/
-WeighMyBrewScales::WeighMyBrewScales(const DiscoveredDevice& device) : RemoteScales(device) {}
+WeighMyBrewScales::WeighMyBrewScales(const DiscoveredDevice& device) : RemoteScales(device) {
+  RemoteScales::schedulePeriodic(HEARTBEAT_PERIOD_MS, [this]() { sendHeartbeat(); });
+}
 
 bool WeighMyBrewScales::connect() {
   if (RemoteScales::clientIsConnected()) {
@@ -28,6 +30,8 @@ bool WeighMyBrewScales::connect() {
     return false;
   }
 
+  frames.reset();
+
   if (!performConnectionHandshake()) {
     return false;
   }
@@ -52,18 +56,17 @@ void WeighMyBrewScales::update() {
     markedForReconnection = false;
   }
   else {
-    sendHeartbeat();
-    RemoteScales::log("Heartbeat sent.\n");
+    RemoteScales::runPeriodicTasks();
   }
+  RemoteScales::serviceStaleWatchdog();
+  RemoteScales::processCommandQueue();
 }
 
 bool WeighMyBrewScales::tare() {
   if (!isConnected()) return false;
   RemoteScales::log("Tare sent");
   uint8_t payload[6] = { 0x03, 0x0a, 0x01, 0x01, 0x00, 0x08 };
-  sendMessage(WeighMyBrewMessageType::SYSTEM, payload, sizeof(payload));
-
-  return true;
+  return sendMessage(ScaleCommand::TARE, WeighMyBrewMessageType::SYSTEM, payload, sizeof(payload));
 };
 
 //-----------------------------------------------------------------------------------/
@@ -75,65 +78,62 @@ void WeighMyBrewScales::notifyCallback(
   size_t length,
   bool isNotify
 ) {
-  dataBuffer.insert(dataBuffer.end(), pData, pData + length);
-  bool result = true;
-  while (result) {
-    result = decodeAndHandleNotification();
+  // Messages are a fixed 20 bytes behind the 0x03 product number.
+  size_t discarded = frames.feed(pData, length,
+    [](const uint8_t* frame, size_t) -> int32_t {
+      return frame[0] == 0x03 ? static_cast<int32_t>(RECEIVE_PROTOCOL_LENGTH) : -1;
+    },
+    [this](const uint8_t* message, size_t messageLength) { handleMessage(message, messageLength); });
+
+  if (discarded > 0) {
+    countHealth(ScaleHealthCounter::RESYNCS);
+    countHealth(ScaleHealthCounter::BYTES_DISCARDED, discarded);
   }
 }
 
 /*
 Handle WeighMyBru protocol
 */
-bool WeighMyBrewScales::decodeAndHandleNotification() {
-  // Minimum message length check (20 bytes based on protocol definition)
-  if (dataBuffer.size() < RECEIVE_PROTOCOL_LENGTH) {
-    return false;
-  }
-
-  WeighMyBrewMessageType messageType = static_cast<WeighMyBrewMessageType>(dataBuffer[1]);
-  uint8_t productNumber = dataBuffer[0];
-
-  const size_t messageLength = RECEIVE_PROTOCOL_LENGTH;
+void WeighMyBrewScales::handleMessage(const uint8_t* message, size_t messageLength) {
+  WeighMyBrewMessageType messageType = static_cast<WeighMyBrewMessageType>(message[1]);
+  uint8_t productNumber = message[0];
 
   // Handle different message types
   if (productNumber == 0x03 && messageType == WeighMyBrewMessageType::WEIGHT) {
     // Checksum validation: XOR of Header1 ^ Header2 ^ Data0 ^ Data1 ^ ... ^ DataN should equal DataSUM
-    uint8_t checksum = dataBuffer[0];
+    uint8_t checksum = message[0];
     for (size_t i = 1; i < messageLength - 1; i++) {
-      checksum ^= dataBuffer[i];
+      checksum ^= message[i];
     }
 
     // The last byte in the message is DataSUM
-    uint8_t dataSUM = dataBuffer[messageLength - 1];
+    uint8_t dataSUM = message[messageLength - 1];
 
     if (checksum != dataSUM) {
       RemoteScales::log("Checksum failed: calc[%02X] but actual[%02X]. Discarding.\n",
         checksum, dataSUM);
-      dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + messageLength);
-      return false;
+      countHealth(ScaleHealthCounter::CHECKSUM_FAILURES);
+      countHealth(ScaleHealthCounter::BYTES_DISCARDED, messageLength);
+      return;
     }
+    countHealth(ScaleHealthCounter::FRAMES_OK);
 
-    float weight = (dataBuffer[7] << 16) | (dataBuffer[8] << 8) | dataBuffer[9];
+    float weight = (message[7] << 16) | (message[8] << 8) | message[9];
 
-    if (dataBuffer[6] == 45) { // Check if the value is negative
+    if (message[6] == 45) { // Check if the value is negative
       weight = -weight;
     }
 
     RemoteScales::setWeight(weight * 0.01f); // Convert to floating point
   }
   else if (productNumber == 0x03 && messageType == WeighMyBrewMessageType::SYSTEM) {
+    countHealth(ScaleHealthCounter::FRAMES_OK);
     WeighMyBrewScales::tare();
   }
   else {
-    RemoteScales::log("Unknown message type %02X: %s\n", messageType, RemoteScales::byteArrayToHexString(dataBuffer.data(), messageLength).c_str());
+    countHealth(ScaleHealthCounter::UNKNOWN_TYPES);
+    RemoteScales::log("Unknown message type %02X: %s\n", messageType, RemoteScales::byteArrayToHexString(message, messageLength).c_str());
   }
-
-    // Remove processed message from the buffer
-  dataBuffer.erase(dataBuffer.begin(), dataBuffer.begin() + messageLength);
-
-    // Return whether there's more data to process
-  return dataBuffer.size() >= RECEIVE_PROTOCOL_LENGTH;
 }
 
 bool WeighMyBrewScales::performConnectionHandshake() {
@@ -156,19 +156,18 @@ bool WeighMyBrewScales::performConnectionHandshake() {
   }
   RemoteScales::log("Got weightCharacteristic and commandCharacteristic\n");
 
-  sendNotificationRequest();
+  sendNotificationRequest(ScaleCommand::SETUP);
   RemoteScales::log("Sent notification request\n");
-  lastHeartbeat = millis();
   return true;
 }
 
-void WeighMyBrewScales::sendNotificationRequest() {
+void WeighMyBrewScales::sendNotificationRequest(ScaleCommand command) {
   uint8_t payload[] = { 0, 0, 0, 0, 0, 0 };
-  sendEvent(payload, 6);
+  sendEvent(command, payload, 6);
   RemoteScales::log("Sent event.\n");
 }
 
-void WeighMyBrewScales::sendEvent(const uint8_t* payload, size_t length) {
+bool WeighMyBrewScales::sendEvent(ScaleCommand command, const uint8_t* payload, size_t length) {
   auto bytes = std::make_unique<uint8_t[]>(length + 1);
   bytes[0] = static_cast<uint8_t>(length + 1);
 
@@ -176,7 +175,7 @@ void WeighMyBrewScales::sendEvent(const uint8_t* payload, size_t length) {
     bytes[i + 1] = payload[i] & 0xFF;
   }
 
-  sendMessage(WeighMyBrewMessageType::SYSTEM, bytes.get(), length + 1);
+  return sendMessage(command, WeighMyBrewMessageType::SYSTEM, bytes.get(), length + 1);
 }
 
 void WeighMyBrewScales::sendHeartbeat() {
@@ -184,17 +183,11 @@ void WeighMyBrewScales::sendHeartbeat() {
     return;
   }
 
-  uint32_t now = millis();
-  if (now - lastHeartbeat < 2000) {
-    return;
-  }
-
   uint8_t payload1[] = { 0x02,0x00 };
-  sendMessage(WeighMyBrewMessageType::SYSTEM, payload1, 2);
-  sendNotificationRequest();
+  sendMessage(ScaleCommand::HEARTBEAT, WeighMyBrewMessageType::SYSTEM, payload1, 2);
+  sendNotificationRequest(ScaleCommand::HEARTBEAT);
   uint8_t payload2[] = { 0x00 };
-  sendMessage(WeighMyBrewMessageType::SYSTEM, payload2, 1);
-  lastHeartbeat = now;
+  sendMessage(ScaleCommand::HEARTBEAT, WeighMyBrewMessageType::SYSTEM, payload2, 1);
 }
 
 void WeighMyBrewScales::subscribeToNotifications() {
@@ -206,16 +199,16 @@ void WeighMyBrewScales::subscribeToNotifications() {
 
   if (weightCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for weight characteristic\n");
-    weightCharacteristic->subscribe(true, callback);
+    subscribe(weightCharacteristic, callback);
   }
 
   if (commandCharacteristic->canNotify()) {
     RemoteScales::log("Registering callback for command characteristic\n");
-    commandCharacteristic->subscribe(true, callback);
+    subscribe(commandCharacteristic, callback);
   }
 }
 
-void WeighMyBrewScales::sendMessage(WeighMyBrewMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse) {
+bool WeighMyBrewScales::sendMessage(ScaleCommand command, WeighMyBrewMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse) {
 
   auto bytes = std::make_unique<uint8_t[]>(length);
 
@@ -228,5 +221,5 @@ void WeighMyBrewScales::sendMessage(WeighMyBrewMessageType msgType, const uint8_
   }
   bytes[length - 1] = checksum;
 
-  commandCharacteristic->writeValue(bytes.get(), length, waitResponse);
+  return RemoteScales::sendCommand(command, commandCharacteristic, bytes.get(), length, waitResponse);
 }
@@ -1,7 +1,6 @@
 #pragma once
 #include "remote_scales.h"
 #include "remote_scales_plugin_registry.h"
-#include <Arduino.h>
 #include <NimBLEDevice.h>
 #include <NimBLEUtils.h>
 #include <NimBLEScan.h>
@@ -28,7 +27,7 @@ private:
   float time;
   uint8_t battery;
 
-  uint32_t lastHeartbeat = 0;
+  static constexpr uint32_t HEARTBEAT_PERIOD_MS = 2000;
 
   bool markedForReconnection = false;
 
@@ -36,17 +35,17 @@ private:
   NimBLERemoteCharacteristic* weightCharacteristic;
   NimBLERemoteCharacteristic* commandCharacteristic;
 
-  std::vector<uint8_t> dataBuffer;
+  FrameReassembler<64> frames;
 
   bool performConnectionHandshake();
   void subscribeToNotifications();
 
-  void sendMessage(WeighMyBrewMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
-  void sendEvent(const uint8_t* payload, size_t length);
+  bool sendMessage(ScaleCommand command, WeighMyBrewMessageType msgType, const uint8_t* payload, size_t length, bool waitResponse = false);
+  bool sendEvent(ScaleCommand command, const uint8_t* payload, size_t length);
   void sendHeartbeat();
-  void sendNotificationRequest();
+  void sendNotificationRequest(ScaleCommand command);
   void notifyCallback(NimBLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify);
-  bool decodeAndHandleNotification();
+  void handleMessage(const uint8_t* message, size_t messageLength);
 };
 
 class WeighMyBrewScalePlugin {
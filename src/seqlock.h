@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock. The writer never waits and readers never take
+// a lock: they retry until they copy the value without a write in between,
+// so a reader on the other core always gets one whole value, never half of
+// an old one and half of a new one. The value is kept in atomic words so the
+// racing copy stays well defined.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+
+public:
+  // Only ever call from one task at a time.
+  void write(const T& value) {
+    uint32_t words[WORDS] = {};
+    memcpy(words, &value, sizeof(T));
+
+    uint32_t sequence = this->sequence.load(std::memory_order_relaxed);
+    this->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) {
+      storage[i].store(words[i], std::memory_order_relaxed);
+    }
+    this->sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  T read() const {
+    uint32_t words[WORDS];
+    uint32_t before, after;
+    do {
+      before = sequence.load(std::memory_order_acquire);
+      for (size_t i = 0; i < WORDS; i++) {
+        words[i] = storage[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  // Number of completed writes.
+  uint32_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+  static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> sequence{ 0 };
+  std::atomic<uint32_t> storage[WORDS] = {};
+};
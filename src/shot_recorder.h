@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+struct ShotSample {
+  uint32_t timestampMs = 0;
+  float weight = 0.f;   // g, to 0.01
+  float flowRate = 0.f; // g/s, to 0.01; 0 unless recorded
+};
+
+// Records a shot's sample stream into a fixed buffer, about 2 bytes per
+// sample for weight and time, 3 with flow. Each sample is stored as deltas from the one
+// before: time in ms as a varint, then weight (and optionally flow) in 0.01
+// units as zig-zag varints. Values are quantised against the running total,
+// so rounding never accumulates. Appends are O(1) and never allocate; once
+// the buffer is full further samples are refused and counted.
+//
+// At 20 Hz, 16 KiB holds about six and a half minutes of weight, or four
+// with flow as well.
+template <size_t CAPACITY>
+class ShotRecorder {
+public:
+  // Clears the recording. recordFlow adds a flow channel to every sample.
+  void begin(bool recordFlow = false) {
+    this->recordFlow = recordFlow;
+    used = 0;
+    samples = 0;
+    dropped = 0;
+    lastTimestampMs = 0;
+    lastWeight = 0;
+    lastFlow = 0;
+  }
+
+  bool append(uint32_t timestampMs, float weight, float flowRate = 0.f) {
+    int32_t quantisedWeight = quantise(weight);
+    int32_t quantisedFlow = recordFlow ? quantise(flowRate) : 0;
+
+    uint8_t encoded[3 * MAX_VARINT_LENGTH];
+    size_t length = writeVarint(encoded, timestampMs - lastTimestampMs);
+    length += writeVarint(encoded + length, zigzag(quantisedWeight - lastWeight));
+    if (recordFlow) {
+      length += writeVarint(encoded + length, zigzag(quantisedFlow - lastFlow));
+    }
+
+    if (CAPACITY - used < length) {
+      dropped++;
+      return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+      buffer[used + i] = encoded[i];
+    }
+    used += length;
+    samples++;
+    lastTimestampMs = timestampMs;
+    lastWeight = quantisedWeight;
+    lastFlow = quantisedFlow;
+    return true;
+  }
+
+  size_t size() const { return samples; }
+  size_t bytesUsed() const { return used; }
+  uint32_t droppedSamples() const { return dropped; }
+  bool recordsFlow() const { return recordFlow; }
+  const uint8_t* data() const { return buffer; }
+
+  // Streams the samples back in order without decoding the whole buffer.
+  class Reader {
+  public:
+    bool next(ShotSample& sample) {
+      uint32_t timeDelta, weightDelta, flowDelta = 0;
+      size_t position = this->position;
+      if (!readVarint(recorder.buffer, recorder.used, position, timeDelta)) return false;
+      if (!readVarint(recorder.buffer, recorder.used, position, weightDelta)) return false;
+      if (recorder.recordFlow && !readVarint(recorder.buffer, recorder.used, position, flowDelta)) return false;
+      this->position = position;
+
+      timestampMs += timeDelta;
+      weight += unzigzag(weightDelta);
+      flow += unzigzag(flowDelta);
+      sample.timestampMs = timestampMs;
+      sample.weight = weight / 100.f;
+      sample.flowRate = flow / 100.f;
+      return true;
+    }
+
+  private:
+    friend class ShotRecorder;
+    explicit Reader(const ShotRecorder& recorder) : recorder(recorder) {}
+
+    const ShotRecorder& recorder;
+    size_t position = 0;
+    uint32_t timestampMs = 0;
+    int32_t weight = 0;
+    int32_t flow = 0;
+  };
+
+  Reader reader() const { return Reader(*this); }
+
+private:
+  static constexpr size_t MAX_VARINT_LENGTH = 5;
+
+  uint8_t buffer[CAPACITY];
+  size_t used = 0;
+  size_t samples = 0;
+  uint32_t dropped = 0;
+  bool recordFlow = false;
+  uint32_t lastTimestampMs = 0;
+  int32_t lastWeight = 0;
+  int32_t lastFlow = 0;
+
+  // Clamped to +-200 kg so deltas can never overflow; NaN records as zero.
+  static constexpr float MAX_MAGNITUDE = 200000.f;
+
+  static int32_t quantise(float value) {
+    if (!(value > -MAX_MAGNITUDE)) value = value < 0.f ? -MAX_MAGNITUDE : 0.f;
+    if (value > MAX_MAGNITUDE) value = MAX_MAGNITUDE;
+    return static_cast<int32_t>(lroundf(value * 100.f));
+  }
+
+  static uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+  }
+  static int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+  }
+
+  static size_t writeVarint(uint8_t* out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+      out[length++] = static_cast<uint8_t>(value) | 0x80;
+      value >>= 7;
+    }
+    out[length++] = static_cast<uint8_t>(value);
+    return length;
+  }
+
+  static bool readVarint(const uint8_t* data, size_t length, size_t& position, uint32_t& value) {
+    value = 0;
+    for (size_t shift = 0; shift < 7 * MAX_VARINT_LENGTH; shift += 7) {
+      if (position >= length) return false;
+      uint8_t byte = data[position++];
+      value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+  }
+};
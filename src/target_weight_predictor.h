@@ -0,0 +1,98 @@
+#pragma once
+#include "remote_scales.h"
+
+// Fires a stop callback early enough that the shot lands on its target weight.
+//
+// Each sample is projected forward by the total lead time: the time since the
+// sample was taken, the part of its delivery the timestamp does not cover and
+// the machine's own stop delay. Once weight + flow * lead reaches the target the callback fires,
+// once per shot. What still ends up in the cup after that (drips, puck
+// drainage, scale filter lag) is learned from finish() as a residual overshoot
+// and subtracted from the target of later shots.
+class TargetWeightPredictor {
+public:
+  using StopCallback = void (*)(float predictedFinalWeight);
+
+  static constexpr float LEARNING_RATE = 0.3f;
+  static constexpr float MAX_RESIDUAL_GRAMS = 5.f;
+
+  void setStopCallback(StopCallback callback) { stopCallback = callback; }
+
+  // Time between deciding to stop and the machine actually stopping flow
+  // (pump/solenoid response). Known by the firmware, not measurable here.
+  void setMachineStopDelayMs(uint32_t ms) { machineStopDelayMs = ms; }
+
+  // Overrides the latency update(scale) derives from the link. Use it for a
+  // figure measured end to end on the scale model, which includes the time
+  // the scale itself takes to notify; nothing on this side can see that.
+  void setNotificationLatencyMs(uint32_t ms) { notificationLatencyOverrideMs = ms; hasLatencyOverride = true; }
+
+  void begin(float targetWeight) {
+    target = targetWeight;
+    fired = false;
+    active = true;
+  }
+
+  // Feed one sample. Returns true on the sample that triggers the stop.
+  bool update(float weight, float flowRate, uint32_t sampleAgeMs, uint32_t notificationLatencyMs) {
+    if (!active || fired) return false;
+
+    float leadSeconds = (sampleAgeMs + notificationLatencyMs + machineStopDelayMs) / 1000.f;
+    float projected = weight + (flowRate > 0.f ? flowRate * leadSeconds : 0.f);
+    if (projected + residual < target) return false;
+
+    fired = true;
+    lastPrediction = projected + residual;
+    if (stopCallback != nullptr) {
+      stopCallback(lastPrediction);
+    }
+    return true;
+  }
+
+  // Convenience for the latest sample of a connected scale. A timestamp from
+  // the synchronized scale clock (isSampleDatedByScale()) dates the sample to
+  // when it was weighed, so its age already covers the BLE delivery.
+  // Otherwise the sample is stamped when the driver decoded it, and what came
+  // before is the wait for the next connection event, half the negotiated
+  // interval on average, plus the measured decode latency (see
+  // setLatencyInstrumentation(), zero while that is off). Whatever the scale
+  // adds before notifying is left to the learned residual unless
+  // setNotificationLatencyMs() covers it.
+  bool update(const RemoteScales& scale, uint32_t nowMs) {
+    uint32_t latencyMs = hasLatencyOverride ? notificationLatencyOverrideMs : linkLatencyMs(scale);
+    uint32_t sampleAgeMs = nowMs - scale.getSampleTimestampMs();
+    return update(scale.getWeight(), scale.getFlowRate(), sampleAgeMs, latencyMs);
+  }
+
+  // Report where the shot actually ended once the weight has settled.
+  void finish(float finalWeight) {
+    if (!active) return;
+    active = false;
+    if (!fired) return; // stopped for another reason; nothing to learn
+
+    residual += LEARNING_RATE * (finalWeight - lastPrediction);
+    if (residual > MAX_RESIDUAL_GRAMS) residual = MAX_RESIDUAL_GRAMS;
+    if (residual < -MAX_RESIDUAL_GRAMS) residual = -MAX_RESIDUAL_GRAMS;
+  }
+
+  bool hasFired() const { return fired; }
+  float getResidualOvershoot() const { return residual; }
+  void setResidualOvershoot(float grams) { residual = grams; } // restore a persisted value
+
+private:
+  static uint32_t linkLatencyMs(const RemoteScales& scale) {
+    if (scale.isSampleDatedByScale()) return 0;
+    uint32_t linkWaitMs = scale.getConnectionParams().interval * 5u / 8u; // half of n * 1.25 ms
+    return linkWaitMs + (scale.getLatencyStats().decodeP50Us + 500) / 1000;
+  }
+
+  StopCallback stopCallback = nullptr;
+  uint32_t machineStopDelayMs = 0;
+  uint32_t notificationLatencyOverrideMs = 0;
+  bool hasLatencyOverride = false;
+  float target = 0.f;
+  float residual = 0.f;
+  float lastPrediction = 0.f;
+  bool fired = false;
+  bool active = false;
+};
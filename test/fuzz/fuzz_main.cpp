@@ -0,0 +1,51 @@
+// Runs a fuzz target over files or corpus directories, for toolchains
+// without libFuzzer (gcc) and for reproducing a crash:
+//   ./fuzz_acaia_replay corpus/acaia crash-1234
+#include <cstdint>
+#include <cstdio>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static bool runFile(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "cannot open %s\n", path.c_str());
+    return false;
+  }
+  std::vector<uint8_t> input;
+  uint8_t buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) input.insert(input.end(), buffer, buffer + read);
+  fclose(file);
+  LLVMFuzzerTestOneInput(input.data(), input.size());
+  return true;
+}
+
+int main(int argc, char** argv) {
+  size_t inputs = 0;
+  for (int i = 1; i < argc; i++) {
+    struct stat info;
+    if (stat(argv[i], &info) != 0) {
+      fprintf(stderr, "cannot stat %s\n", argv[i]);
+      return 1;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+      if (!runFile(argv[i])) return 1;
+      inputs++;
+      continue;
+    }
+    DIR* dir = opendir(argv[i]);
+    while (struct dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] == '.') continue;
+      if (!runFile(std::string(argv[i]) + "/" + entry->d_name)) return 1;
+      inputs++;
+    }
+    closedir(dir);
+  }
+  printf("%zu inputs ran cleanly\n", inputs);
+  return 0;
+}
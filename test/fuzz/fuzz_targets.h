@@ -0,0 +1,101 @@
+#pragma once
+#include <virtual_scales.h>
+#include <cmath>
+#include <cstdlib>
+
+// Fuzz entry points for every driver's notification path. Each input is
+// delivered to a freshly connected driver, through the stand-in, exactly as
+// the BLE stack would deliver notifications:
+//
+//   byte 0, bits 0-4: largest notification in bytes; 0 sends the rest at once
+//   byte 0, bit 7:    use the scale's second subscribed characteristic
+//   bytes 1..:        the notified stream
+//
+// The fuzz_<driver>.cpp files wrap these in LLVMFuzzerTestOneInput for
+// libFuzzer; the native corpus test calls them directly.
+
+inline void fuzzCheck(bool condition, const char* what) {
+  if (!condition) {
+    fprintf(stderr, "fuzz invariant violated: %s\n", what);
+    abort();
+  }
+}
+
+template <typename Scale>
+int fuzzNotifications(const uint8_t* data, size_t size) {
+  static bool pluginsApplied = false;
+  if (!pluginsApplied) {
+    applyAllScalePlugins();
+    pluginsApplied = true;
+  }
+  if (size == 0) return 0;
+
+  SimulatedRemoteScalesClock clock;
+  RemoteScalesClock::setInstance(&clock);
+  {
+    Scale scale;
+    std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+    fuzzCheck(driver != nullptr && driver->connect(), "driver connects to its virtual scale");
+
+    NimBLERemoteCharacteristic* target = nullptr;
+    bool second = (data[0] & 0x80) != 0;
+    for (auto& characteristic : scale.getPeripheral().getServices()[0]->getCharacteristics()) {
+      if (!characteristic->isSubscribed()) continue;
+      target = characteristic.get();
+      if (!second) break;
+      second = false;
+    }
+    fuzzCheck(target != nullptr, "driver subscribed to a characteristic");
+
+    size_t maxPiece = data[0] & 0x1F;
+    size_t offset = 1;
+    while (offset < size) {
+      size_t piece = maxPiece == 0 ? size - offset : std::min(maxPiece, size - offset);
+      target->notify(data + offset, piece);
+      offset += piece;
+      clock.advanceMs(10);
+      driver->update();
+    }
+
+    fuzzCheck(std::isfinite(driver->getWeight()), "decoded weight is finite");
+    ScaleHealthCounters health = driver->getHealthCounters();
+    fuzzCheck(health.bytesDiscarded <= size, "no more bytes discarded than received");
+    driver->disconnect();
+    fuzzCheck(NimBLEDevice::getClientListSize() == 0, "disconnect releases the client");
+  }
+  RemoteScalesClock::setInstance(nullptr);
+  return 0;
+}
+
+inline int fuzzAcaia(const uint8_t* data, size_t size) { return fuzzNotifications<AcaiaVirtualScale>(data, size); }
+inline int fuzzBookoo(const uint8_t* data, size_t size) { return fuzzNotifications<BookooVirtualScale>(data, size); }
+inline int fuzzDecent(const uint8_t* data, size_t size) { return fuzzNotifications<DecentVirtualScale>(data, size); }
+inline int fuzzDifluid(const uint8_t* data, size_t size) { return fuzzNotifications<DifluidVirtualScale>(data, size); }
+inline int fuzzDot(const uint8_t* data, size_t size) { return fuzzNotifications<DotVirtualScale>(data, size); }
+inline int fuzzEclair(const uint8_t* data, size_t size) { return fuzzNotifications<EclairVirtualScale>(data, size); }
+inline int fuzzEureka(const uint8_t* data, size_t size) { return fuzzNotifications<EurekaVirtualScale>(data, size); }
+inline int fuzzFelicita(const uint8_t* data, size_t size) { return fuzzNotifications<FelicitaVirtualScale>(data, size); }
+inline int fuzzMyScale(const uint8_t* data, size_t size) { return fuzzNotifications<MyScaleVirtualScale>(data, size); }
+inline int fuzzTimemore(const uint8_t* data, size_t size) { return fuzzNotifications<TimemoreVirtualScale>(data, size); }
+inline int fuzzVaria(const uint8_t* data, size_t size) { return fuzzNotifications<VariaVirtualScale>(data, size); }
+inline int fuzzWeighMyBru(const uint8_t* data, size_t size) { return fuzzNotifications<WeighMyBruVirtualScale>(data, size); }
+
+struct FuzzTarget {
+  const char* name; // also the corpus directory
+  int (*run)(const uint8_t* data, size_t size);
+};
+
+static const FuzzTarget FUZZ_TARGETS[] = {
+  { "acaia", fuzzAcaia },
+  { "bookoo", fuzzBookoo },
+  { "decent", fuzzDecent },
+  { "difluid", fuzzDifluid },
+  { "dot", fuzzDot },
+  { "eclair", fuzzEclair },
+  { "eureka", fuzzEureka },
+  { "felicita", fuzzFelicita },
+  { "myscale", fuzzMyScale },
+  { "timemore", fuzzTimemore },
+  { "varia", fuzzVaria },
+  { "weighmybru", fuzzWeighMyBru },
+};
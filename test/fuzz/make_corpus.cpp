@@ -0,0 +1,168 @@
+// Writes the seed corpora in corpus/<driver>/ from the virtual scales'
+// encoders plus the non-weight messages each protocol also sends. Rerun
+// after changing an encoder: make corpus
+#include <virtual_scales.h>
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+
+using Bytes = std::vector<uint8_t>;
+
+static void write(const std::string& dir, const char* name, uint8_t control, const Bytes& stream) {
+  mkdir(dir.c_str(), 0755);
+  std::string path = dir + "/" + name;
+  FILE* file = fopen(path.c_str(), "wb");
+  fputc(control, file);
+  fwrite(stream.data(), 1, stream.size(), file);
+  fclose(file);
+}
+
+static Bytes frame(const VirtualScale& scale, float grams, uint32_t timestampMs = 0) {
+  uint8_t out[VirtualScale::MAX_FRAME_LENGTH];
+  size_t length = scale.encode(grams, timestampMs, out);
+  return Bytes(out, out + length);
+}
+
+static Bytes concat(std::initializer_list<Bytes> parts) {
+  Bytes all;
+  for (const Bytes& part : parts) all.insert(all.end(), part.begin(), part.end());
+  return all;
+}
+
+// Seeds every protocol gets: the weight frame whole, split, signed, damaged,
+// after junk, and cut short.
+static void writeWeightSeeds(const std::string& dir, const VirtualScale& scale) {
+  write(dir, "weight", 0x00, frame(scale, 18.5f));
+  write(dir, "weight_negative", 0x00, frame(scale, -3.2f));
+  Bytes shot;
+  for (int i = 0; i < 5; i++) shot = concat({ shot, frame(scale, 10.f + i * 0.2f, i * 100) });
+  write(dir, "shot_fragmented", 0x03, shot);
+  write(dir, "shot_single_notification", 0x00, shot);
+  Bytes damaged = frame(scale, 18.5f);
+  damaged.back() ^= 0x5A;
+  write(dir, "weight_bad_checksum", 0x00, damaged);
+  write(dir, "junk_then_weight", 0x00, concat({ { 0x00, 0xFF, 0x13, 0x37 }, frame(scale, 18.5f) }));
+  Bytes truncated = frame(scale, 18.5f);
+  truncated.resize(truncated.size() / 2);
+  write(dir, "weight_truncated", 0x00, concat({ truncated, frame(scale, 18.5f) }));
+}
+
+static Bytes acaiaMessage(uint8_t type, const Bytes& payload) {
+  Bytes out = { 0xEF, 0xDD, type };
+  out.insert(out.end(), payload.begin(), payload.end());
+  uint8_t even = 0, odd = 0;
+  for (size_t i = 0; i < payload.size(); i++) (i % 2 == 0 ? even : odd) += payload[i];
+  out.push_back(even);
+  out.push_back(odd);
+  return out;
+}
+
+static Bytes withXor(Bytes message, size_t from) {
+  uint8_t sum = 0;
+  for (size_t i = from; i < message.size(); i++) sum ^= message[i];
+  message.push_back(sum);
+  return message;
+}
+
+static Bytes withSum(Bytes message) {
+  uint8_t sum = 0;
+  for (uint8_t byte : message) sum += byte;
+  message.push_back(sum);
+  return message;
+}
+
+int main(int argc, char** argv) {
+  std::string root = argc > 1 ? argv[1] : "corpus";
+  mkdir(root.c_str(), 0755);
+
+  {
+    AcaiaVirtualScale scale;
+    std::string dir = root + "/acaia";
+    writeWeightSeeds(dir, scale);
+    write(dir, "status", 0x00, acaiaMessage(0x08, { 0x04, 0x55, 0x02, 0x00 }));
+    write(dir, "timer", 0x00, acaiaMessage(0x0C, { 0x05, 0x07, 0x00, 0x1E, 0x05 }));
+    write(dir, "ack", 0x00, acaiaMessage(0x0C, { 0x03, 0x0B, 0x00 }));
+    write(dir, "info", 0x00, acaiaMessage(0x07, { 0x03, 0x00, 0x00 }));
+    write(dir, "bad_scaling", 0x00, acaiaMessage(0x0C, { 0x08, 0x05, 0xB9, 0x00, 0x00, 0x00, 0x09, 0x00 }));
+  }
+  {
+    BookooVirtualScale scale;
+    std::string dir = root + "/bookoo";
+    writeWeightSeeds(dir, scale);
+    Bytes system(19, 0x00);
+    system[0] = 0x03;
+    system[1] = 0x0A;
+    write(dir, "system", 0x00, withXor(system, 0));
+  }
+  {
+    DecentVirtualScale scale;
+    std::string dir = root + "/decent";
+    writeWeightSeeds(dir, scale);
+    write(dir, "weight_short_form", 0x00, { 0x03, 0xCA, 0x00, 0xB9, 0x00, 0x00, 0x70 });
+    write(dir, "weight_unchecked", 0x00, { 0x03, 0xCA, 0x00, 0xB9, 0x00, 0x00, 0x00 });
+  }
+  {
+    DifluidVirtualScale scale;
+    std::string dir = root + "/difluid";
+    writeWeightSeeds(dir, scale);
+    write(dir, "status", 0x00, withSum({ 0xDF, 0xDF, 0x03, 0x05, 0x01, 0x55 }));
+    write(dir, "short_sensor_data", 0x00, withSum({ 0xDF, 0xDF, 0x03, 0x00, 0x02, 0x00, 0xB9 }));
+  }
+  {
+    DotVirtualScale scale;
+    std::string dir = root + "/dot";
+    writeWeightSeeds(dir, scale);
+    write(dir, "other_class", 0x00, { 0xA5, 0x5A, 0x02, 0x04, 0x00, 0x01, 0x00, 0x00, 0x00 });
+    write(dir, "implausible_length", 0x00, concat({ { 0xA5, 0x5A, 0x01, 0x01, 0xFF, 0xFF }, frame(scale, 18.5f) }));
+  }
+  {
+    EclairVirtualScale scale;
+    std::string dir = root + "/eclair";
+    writeWeightSeeds(dir, scale);
+    write(dir, "flow", 0x00, withXor({ 0x46, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, 1));
+    write(dir, "config_battery", 0x80, withXor({ 0x42, 0x55 }, 1));
+    write(dir, "config_timer", 0x80, withXor({ 0x43, 0x01 }, 1));
+    write(dir, "config_fragmented", 0x81, concat({ withXor({ 0x42, 0x55 }, 1), withXor({ 0x43, 0x00 }, 1) }));
+  }
+  {
+    EurekaVirtualScale scale;
+    writeWeightSeeds(root + "/eureka", scale);
+  }
+  {
+    FelicitaVirtualScale scale;
+    std::string dir = root + "/felicita";
+    writeWeightSeeds(dir, scale);
+    Bytes bad = frame(scale, 18.5f);
+    bad[5] = 'x';
+    write(dir, "bad_digit", 0x00, bad);
+  }
+  {
+    MyScaleVirtualScale scale;
+    writeWeightSeeds(root + "/myscale", scale);
+  }
+  {
+    TimemoreVirtualScale scale;
+    std::string dir = root + "/timemore";
+    writeWeightSeeds(dir, scale);
+    write(dir, "implausible_weight", 0x00, concat({ { 0x10, 0xFF, 0xFF, 0xFF, 0x7F, 0x00, 0x00, 0x00, 0x00 }, frame(scale, 18.5f) }));
+  }
+  {
+    VariaVirtualScale scale;
+    std::string dir = root + "/varia";
+    writeWeightSeeds(dir, scale);
+    write(dir, "battery", 0x00, withXor({ 0xFA, 0x85, 0x01, 0x4B }, 1));
+    write(dir, "timer", 0x00, withXor({ 0xFA, 0x87, 0x02, 0x00, 0x02 }, 1));
+    write(dir, "timer_start", 0x00, withXor({ 0xFA, 0x88, 0x01, 0x01 }, 1));
+    write(dir, "unknown_type", 0x00, withXor({ 0xFA, 0x42, 0x01, 0x00 }, 1));
+  }
+  {
+    WeighMyBruVirtualScale scale;
+    std::string dir = root + "/weighmybru";
+    writeWeightSeeds(dir, scale);
+    Bytes system(19, 0x00);
+    system[0] = 0x03;
+    system[1] = 0x0A;
+    write(dir, "system", 0x00, withXor(system, 0));
+  }
+  return 0;
+}
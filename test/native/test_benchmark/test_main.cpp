@@ -0,0 +1,134 @@
+#include <unity.h>
+#include <virtual_scales.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+// gcc pairs the inlined malloc below with the sized deletes and warns.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// Decode cost of every driver's notification path: frames per second,
+// nanoseconds per frame and heap allocations per frame, over a recorded shot
+// delivered whole, split at arbitrary MTU-like boundaries, and with damaged
+// frames mixed in. Numbers are printed for comparison between changes; the
+// assertions only hold the allocation count, which does not depend on the host.
+
+static std::atomic<uint64_t> allocations{ 0 };
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* block = malloc(size == 0 ? 1 : size)) return block;
+  throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* block) noexcept { free(block); }
+void operator delete[](void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+void operator delete[](void* block, size_t) noexcept { free(block); }
+
+static const uint32_t SHOT_MS = 30000;
+static const uint32_t RATE_HZ = 50;
+static const int ROUNDS = 5;
+
+struct StreamKind {
+  const char* name;
+  VirtualScaleOptions options;
+};
+
+static const StreamKind STREAMS[] = {
+  { "valid", { .rateHz = RATE_HZ } },
+  { "fragmented", { .rateHz = RATE_HZ, .maxFragmentLength = 3, .seed = 7 } },
+  { "noisy", { .rateHz = RATE_HZ, .errorRate = 0.05f, .seed = 11 } },
+};
+
+struct Result {
+  double framesPerSecond;
+  double nsPerFrame;
+  double allocationsPerFrame;
+  uint64_t allocations;
+};
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+// Decent puts exactly one frame in each notification and does not
+// reassemble, so it is only measured on whole frames.
+static bool reassembles(const std::string& name) { return name != "Decent Scale"; }
+
+static Result measure(VirtualScale& scale, RemoteScales& driver, const VirtualScaleStream& stream) {
+  NimBLERemoteCharacteristic* weight = scale.getWeightCharacteristic();
+  auto deliver = [&]() {
+    size_t start = 0;
+    for (size_t end : stream.pieceEnds) {
+      weight->notify(stream.bytes.data() + start, end - start);
+      start = end;
+    }
+  };
+
+  // Allocations are counted from the first notification after connect, so a
+  // buffer that only grows once still shows up; the timing skips that pass.
+  uint64_t allocationsBefore = allocations.load();
+  deliver();
+  uint64_t allocated = allocations.load() - allocationsBefore;
+  driver.update();
+
+  allocationsBefore = allocations.load();
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; round++) deliver();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  allocated += allocations.load() - allocationsBefore;
+
+  double frames = double(stream.frames) * ROUNDS;
+  double framesDelivered = double(stream.frames) * (ROUNDS + 1);
+  double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  return { ns > 0 ? frames * 1e9 / ns : 0, ns / frames, allocated / framesDelivered, allocated };
+}
+
+static void benchmark(const StreamKind& kind) {
+  printf("\n%-16s %-10s %12s %10s %12s\n", "driver", "stream", "frames/s", "ns/frame", "allocs/frame");
+  for (std::unique_ptr<VirtualScale>& scale : makeAllVirtualScales()) {
+    std::unique_ptr<RemoteScales> driver = discoverDriver(*scale);
+    std::string name = scale->getPeripheral().advertisement().getName();
+    TEST_ASSERT_NOT_NULL_MESSAGE(driver.get(), name.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(driver->connect(), name.c_str());
+    driver->update();
+
+    if (kind.options.maxFragmentLength == 0 || reassembles(name)) {
+      ShotCurve shot;
+      shot.stopAt(SHOT_MS - 5000);
+      scale->setOptions(kind.options);
+      VirtualScaleStream stream = scale->record(shot, SHOT_MS);
+      Result result = measure(*scale, *driver, stream);
+      printf("%-16s %-10s %12.0f %10.1f %12.3f\n", name.c_str(), kind.name, result.framesPerSecond, result.nsPerFrame,
+        result.allocationsPerFrame);
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, uint32_t(result.allocations), name.c_str());
+    }
+
+    driver->disconnect();
+  }
+}
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_valid_stream() { benchmark(STREAMS[0]); }
+void test_fragmented_stream() { benchmark(STREAMS[1]); }
+void test_noisy_stream() { benchmark(STREAMS[2]); }
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_valid_stream);
+  RUN_TEST(test_fragmented_stream);
+  RUN_TEST(test_noisy_stream);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+#include <unity.h>
+#include <virtual_scales.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Deferred callbacks on the dispatcher task: per-scale lossless queues with
+// counted drops, latest-wins subscribers, and cancel() on a running callback.
+// The dispatcher runs on a real thread here, so consumers block on a gate.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+static std::atomic<bool> gateOpen{ true };
+static std::atomic<bool> insideCallback{ false };
+static std::atomic<uint32_t> firstCount{ 0 };
+static std::atomic<uint32_t> secondCount{ 0 };
+static std::atomic<uint32_t> lastSample{ 0 };
+static std::atomic<bool> inOrder{ true };
+static std::atomic<float> lastWeight{ 0.f };
+
+static void waitAtGate() {
+  insideCallback = true;
+  while (!gateOpen) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  insideCallback = false;
+}
+
+static void countFirst(const ScaleSnapshot& sample) {
+  waitAtGate();
+  if (lastSample != 0 && sample.sample != lastSample + 1) inOrder = false;
+  lastSample = sample.sample;
+  lastWeight = sample.weight;
+  firstCount++;
+}
+
+static void countSecond(const ScaleSnapshot&) { secondCount++; }
+
+static void countWeight(float weight) {
+  waitAtGate();
+  lastWeight = weight;
+  firstCount++;
+}
+
+template <typename Predicate>
+static bool eventually(Predicate predicate) {
+  for (int i = 0; i < 2000 && !predicate(); i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return predicate();
+}
+
+struct Connected {
+  std::unique_ptr<VirtualScale> scale;
+  std::unique_ptr<RemoteScales> driver;
+};
+
+static Connected connectVaria(const char* address = VIRTUAL_SCALE_ADDRESS) {
+  Connected connected{ std::make_unique<VariaVirtualScale>(address), nullptr };
+  connected.driver = discoverDriver(*connected.scale);
+  TEST_ASSERT_NOT_NULL(connected.driver.get());
+  TEST_ASSERT_TRUE(connected.driver->connect());
+  return connected;
+}
+
+static void send(Connected& connected, int samples) {
+  for (int i = 0; i < samples; i++) {
+    clock_->advanceMs(100);
+    connected.scale->send(10.f + i * 0.1f, remoteScalesMillis());
+  }
+}
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+  gateOpen = true;
+  insideCallback = false;
+  firstCount = 0;
+  secondCount = 0;
+  lastSample = 0;
+  inOrder = true;
+  lastWeight = 0.f;
+}
+
+void tearDown() {
+  gateOpen = true;
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_lossless_subscriber_gets_every_sample_in_order() {
+  Connected connected = connectVaria();
+  TEST_ASSERT_TRUE(connected.driver->subscribeSamples(countFirst, { .dispatch = CallbackDispatch::LOSSLESS }));
+  gateOpen = false;
+  send(connected, 12);
+  gateOpen = true;
+
+  TEST_ASSERT_TRUE(eventually([]() { return firstCount == 12; }));
+  TEST_ASSERT_TRUE(inOrder);
+  TEST_ASSERT_EQUAL_UINT32(0, connected.driver->getHealthCounters().dispatchDrops);
+  connected.driver->disconnect();
+}
+
+void test_lossless_overflow_is_counted_per_scale() {
+  Connected flooded = connectVaria();
+  Connected quiet = connectVaria("c8:2e:18:00:00:02");
+  TEST_ASSERT_TRUE(flooded.driver->subscribeSamples(countFirst, { .dispatch = CallbackDispatch::LOSSLESS }));
+  TEST_ASSERT_TRUE(quiet.driver->subscribeSamples(countSecond, { .dispatch = CallbackDispatch::LOSSLESS }));
+
+  gateOpen = false;
+  send(flooded, 1);
+  TEST_ASSERT_TRUE(eventually([]() { return insideCallback.load(); }));
+  const int total = 1 + RemoteScales::DISPATCH_QUEUE_CAPACITY + 10;
+  send(flooded, total - 1);
+  send(quiet, 10);
+  gateOpen = true;
+
+  TEST_ASSERT_TRUE(eventually([]() { return secondCount == 10; }));
+  uint32_t drops = flooded.driver->getHealthCounters().dispatchDrops;
+  TEST_ASSERT_EQUAL_UINT32(10, drops);
+  TEST_ASSERT_TRUE(eventually([&]() { return firstCount + drops == total; }));
+  TEST_ASSERT_EQUAL_UINT32(0, quiet.driver->getHealthCounters().dispatchDrops);
+  flooded.driver->disconnect();
+  quiet.driver->disconnect();
+}
+
+void test_latest_wins_subscriber_sees_newest_sample() {
+  Connected connected = connectVaria();
+  TEST_ASSERT_TRUE(connected.driver->subscribeSamples(countFirst, { .dispatch = CallbackDispatch::LATEST_WINS }));
+  TEST_ASSERT_TRUE(connected.driver->subscribeSamples(countSecond));
+  gateOpen = false;
+  send(connected, 1);
+  TEST_ASSERT_TRUE(eventually([]() { return insideCallback.load(); }));
+  send(connected, 20);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(21, secondCount.load(), "inline subscriber runs on the decoding task");
+  gateOpen = true;
+
+  TEST_ASSERT_TRUE(eventually([]() { return firstCount == 2; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  TEST_ASSERT_EQUAL_UINT32(2, firstCount.load());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 11.9f, lastWeight.load());
+  TEST_ASSERT_EQUAL_UINT32(0, connected.driver->getHealthCounters().dispatchDrops);
+  connected.driver->disconnect();
+}
+
+void test_weight_callback_follows_dispatch_policy() {
+  Connected connected = connectVaria();
+  connected.driver->setWeightUpdatedCallback(countWeight);
+  connected.driver->setCallbackDispatch(CallbackDispatch::LOSSLESS);
+  send(connected, 5);
+  TEST_ASSERT_TRUE(eventually([]() { return firstCount == 5; }));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.4f, lastWeight.load());
+  connected.driver->disconnect();
+}
+
+void test_unsubscribed_consumer_gets_no_queued_samples() {
+  Connected connected = connectVaria();
+  TEST_ASSERT_TRUE(connected.driver->subscribeSamples(countFirst, { .dispatch = CallbackDispatch::LOSSLESS }));
+  gateOpen = false;
+  send(connected, 1);
+  TEST_ASSERT_TRUE(eventually([]() { return insideCallback.load(); }));
+  send(connected, 5);
+  connected.driver->unsubscribeSamples(countFirst);
+  gateOpen = true;
+
+  TEST_ASSERT_TRUE(eventually([]() { return firstCount == 1; }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  TEST_ASSERT_EQUAL_UINT32(1, firstCount.load());
+  connected.driver->disconnect();
+}
+
+void test_destroying_scale_waits_for_running_callback() {
+  Connected connected = connectVaria();
+  TEST_ASSERT_TRUE(connected.driver->subscribeSamples(countFirst, { .dispatch = CallbackDispatch::LOSSLESS }));
+  gateOpen = false;
+  send(connected, 3);
+  TEST_ASSERT_TRUE(eventually([]() { return insideCallback.load(); }));
+
+  std::thread opener([]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    gateOpen = true;
+  });
+  connected.driver.reset();
+  TEST_ASSERT_FALSE(insideCallback.load());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, firstCount.load(), "queued samples are cancelled with the scale");
+  opener.join();
+}
+
+// Feeds the scale from inside its own callback, so the dispatcher job never
+// runs dry and ends each batch by posting its successor. The last callback of
+// the first batch gets another scale's job queued ahead of that successor,
+// which lets cancel() return before the successor is reached, then waits at
+// the gate.
+static VirtualScale* burstScale = nullptr;
+static VirtualScale* otherScale = nullptr;
+static const uint32_t BATCH = RemoteScales::DISPATCH_QUEUE_CAPACITY + 1 + RemoteScales::MAX_SAMPLE_SUBSCRIBERS;
+
+static void countSecondSlowly(const ScaleSnapshot&) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  secondCount++;
+}
+
+static void keepBursting(const ScaleSnapshot&) {
+  uint32_t call = ++firstCount;
+  if (call == BATCH) {
+    otherScale->send(5.f, remoteScalesMillis());
+    waitAtGate();
+    return;
+  }
+  clock_->advanceMs(1);
+  burstScale->send(20.f, remoteScalesMillis());
+}
+
+void test_destroying_scale_during_burst_leaves_no_job() {
+  Connected connected = connectVaria();
+  Connected other = connectVaria("c8:2e:18:00:00:02");
+  burstScale = connected.scale.get();
+  otherScale = other.scale.get();
+  TEST_ASSERT_TRUE(connected.driver->subscribeSamples(keepBursting, { .dispatch = CallbackDispatch::LOSSLESS }));
+  TEST_ASSERT_TRUE(other.driver->subscribeSamples(countSecondSlowly, { .dispatch = CallbackDispatch::LOSSLESS }));
+  gateOpen = false;
+  send(connected, 1);
+  TEST_ASSERT_TRUE(eventually([]() { return insideCallback.load(); }));
+
+  std::thread opener([]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    gateOpen = true;
+  });
+  connected.driver.reset();
+  opener.join();
+  // A successor posted by the last callback would now run on the freed scale.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  TEST_ASSERT_EQUAL_UINT32(BATCH, firstCount.load());
+  TEST_ASSERT_TRUE(eventually([]() { return secondCount == 1; }));
+  other.driver->disconnect();
+  burstScale = nullptr;
+  otherScale = nullptr;
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_lossless_subscriber_gets_every_sample_in_order);
+  RUN_TEST(test_lossless_overflow_is_counted_per_scale);
+  RUN_TEST(test_latest_wins_subscriber_sees_newest_sample);
+  RUN_TEST(test_weight_callback_follows_dispatch_policy);
+  RUN_TEST(test_unsubscribed_consumer_gets_no_queued_samples);
+  RUN_TEST(test_destroying_scale_waits_for_running_callback);
+  RUN_TEST(test_destroying_scale_during_burst_leaves_no_job);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <virtual_scales.h>
+
+// Connection parameter negotiation against the NimBLE stand-in: the central's
+// initial request, the post-connect update for peripherals that pick their
+// own interval, and what getConnectionParams() reports in each case.
+
+class NoPreferenceVaria : public VariaScales {
+public:
+  using VariaScales::VariaScales;
+
+protected:
+  BLEConnectionParams getPreferredConnectionParams() const override { return {}; }
+};
+
+static std::unique_ptr<VariaVirtualScale> scale;
+
+static NimBLEClient* linkOf(RemoteScales& driver) {
+  return NimBLEDevice::getClientByPeerAddress(NimBLEAddress(driver.getDeviceAddress()));
+}
+
+void setUp() { scale = std::make_unique<VariaVirtualScale>(); }
+void tearDown() { scale.reset(); }
+
+void test_initial_request_in_range_needs_no_update() {
+  std::unique_ptr<RemoteScales> driver = discoverDriver(*scale);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  BLEConnectionParamsReport report = driver->getConnectionParams();
+  TEST_ASSERT_FALSE(report.requested);
+  TEST_ASSERT_TRUE(report.accepted);
+  TEST_ASSERT_EQUAL_UINT16(24, report.interval);
+  TEST_ASSERT_EQUAL_UINT16(256, report.supervisionTimeout);
+  TEST_ASSERT_EQUAL_UINT32(0, linkOf(*driver)->paramUpdateRequests);
+  driver->disconnect();
+}
+
+void test_peripheral_override_is_renegotiated() {
+  scale->getPeripheral().connInterval = 40;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(*scale);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  BLEConnectionParamsReport report = driver->getConnectionParams();
+  TEST_ASSERT_TRUE(report.requested);
+  TEST_ASSERT_TRUE(report.accepted);
+  TEST_ASSERT_EQUAL_UINT16(24, report.interval);
+  TEST_ASSERT_EQUAL_UINT32(1, linkOf(*driver)->paramUpdateRequests);
+  driver->disconnect();
+}
+
+void test_refused_update_keeps_the_link() {
+  scale->getPeripheral().connInterval = 40;
+  scale->getPeripheral().acceptsParamUpdates = false;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(*scale);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  BLEConnectionParamsReport report = driver->getConnectionParams();
+  TEST_ASSERT_TRUE(report.requested);
+  TEST_ASSERT_FALSE(report.accepted);
+  TEST_ASSERT_EQUAL_UINT16(40, report.interval);
+  TEST_ASSERT_TRUE(driver->isConnected());
+  TEST_ASSERT_TRUE(scale->send(18.5f, 0));
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 18.5f, driver->getWeight());
+  driver->disconnect();
+}
+
+void test_reconnect_starts_a_fresh_negotiation() {
+  scale->getPeripheral().connInterval = 40;
+  scale->getPeripheral().acceptsParamUpdates = false;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(*scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_TRUE(driver->getConnectionParams().requested);
+  driver->disconnect();
+
+  scale->getPeripheral().connInterval = 0;
+  TEST_ASSERT_TRUE(driver->connect());
+  BLEConnectionParamsReport report = driver->getConnectionParams();
+  TEST_ASSERT_FALSE(report.requested);
+  TEST_ASSERT_TRUE(report.accepted);
+  TEST_ASSERT_EQUAL_UINT16(24, report.interval);
+  driver->disconnect();
+}
+
+void test_no_preference_keeps_stack_defaults() {
+  scale->getPeripheral().connInterval = 40;
+  NimBLEAdvertisedDevice advertised = scale->advertisement();
+  NoPreferenceVaria driver{ DiscoveredDevice(&advertised) };
+  TEST_ASSERT_TRUE(driver.connect());
+
+  BLEConnectionParamsReport report = driver.getConnectionParams();
+  TEST_ASSERT_FALSE(report.requested);
+  TEST_ASSERT_TRUE(report.accepted);
+  TEST_ASSERT_EQUAL_UINT16(40, report.interval);
+  TEST_ASSERT_EQUAL_UINT32(0, linkOf(driver)->paramUpdateRequests);
+  driver.disconnect();
+}
+
+void test_report_is_empty_when_disconnected() {
+  std::unique_ptr<RemoteScales> driver = discoverDriver(*scale);
+  BLEConnectionParamsReport report = driver->getConnectionParams();
+  TEST_ASSERT_FALSE(report.requested);
+  TEST_ASSERT_FALSE(report.accepted);
+  TEST_ASSERT_EQUAL_UINT16(0, report.interval);
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_initial_request_in_range_needs_no_update);
+  RUN_TEST(test_peripheral_override_is_renegotiated);
+  RUN_TEST(test_refused_update_keeps_the_link);
+  RUN_TEST(test_reconnect_starts_a_fresh_negotiation);
+  RUN_TEST(test_no_preference_keeps_stack_defaults);
+  RUN_TEST(test_report_is_empty_when_disconnected);
+  return UNITY_END();
+}
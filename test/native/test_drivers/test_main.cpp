@@ -0,0 +1,326 @@
+#include <unity.h>
+#include <remote_scales.h>
+#include <remote_scales_plugin_registry.h>
+#include <acaia.h>
+#include <bookoo.h>
+#include <decent.h>
+#include <difluid.h>
+#include <dot.h>
+#include <eclair.h>
+#include <eureka.h>
+#include <felicitaScale.h>
+#include <myscale.h>
+#include <timemore.h>
+#include <varia.h>
+#include <weighmybru.h>
+
+// Every driver against the NimBLE stand-in: found by its advertised name,
+// connected through its real handshake, fed one captured weight frame of
+// 18.5 g, then disconnected without leaking the client.
+
+static const char* ADDRESS = "c8:2e:18:00:00:01";
+static const uint16_t CCCD = 0x2902;
+
+struct CharacteristicSpec {
+  const char* uuid;
+  bool notify;
+  bool indicate;
+  bool cccd;
+};
+
+struct DriverCase {
+  const char* name;
+  const char* service;
+  CharacteristicSpec characteristics[2];
+  std::vector<uint8_t> weightFrame;
+};
+
+static const DriverCase ACAIA{ "LUNAR-1234", "49535343-fe7d-4ae5-8fa9-9fafd205e455",
+  { { "49535343-1e4d-4bd9-ba61-23c647249616", true, false, true }, { "49535343-8841-43f4-a8d4-ecbe34729bb3", false, false, false } },
+  { 0xEF, 0xDD, 0x0C, 0x08, 0x05, 0xB9, 0x00, 0x00, 0x00, 0x01, 0x00, 0xC2, 0x05 } };
+static const DriverCase BOOKOO{ "BOOKOO_SC 1234", "0FFE",
+  { { "FF11", true, false, false }, { "FF12", false, false, false } },
+  { 0x03, 0x0B, 0x00, 0x10, 0x00, 0x02, 0x2B, 0x00, 0x07, 0x3A, 0x2B, 0x00, 0x64, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x13 } };
+static const DriverCase DECENT{ "Decent Scale", "FFF0",
+  { { "FFF4", true, false, false }, { "36F5", false, false, false } },
+  { 0x03, 0xCA, 0x00, 0xB9, 0x00, 0x00, 0x70 } };
+static const DriverCase DIFLUID{ "Microbalance", "00EE",
+  { { "AA01", true, false, false } },
+  { 0xDF, 0xDF, 0x03, 0x00, 0x0D, 0x00, 0x00, 0x00, 0xB9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x87 } };
+static const DriverCase DOT{ "TIMEMORE_Dot", "FFF0",
+  { { "FFF1", true, false, false }, { "FFF2", false, false, false } },
+  { 0xA5, 0x5A, 0x01, 0x01, 0x00, 0x09, 0x00, 0x00, 0x00, 0xB9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+static const DriverCase ECLAIR{ "ECLAIR-1234", "B905EAEA-2E63-0E04-7582-7913F10D8F81",
+  { { "AD736C5F-BBC9-1F96-D304-CB5D5F41E160", true, false, false }, { "4F9A45BA-8E1B-4E07-E157-0814D393B968", true, false, false } },
+  { 0x57, 0x44, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C } };
+static const DriverCase EUREKA{ "CFS-9002", "FFF0",
+  { { "FFF1", true, false, false }, { "FFF2", false, false, false } },
+  { 0xAA, 0x02, 0x41, 0x0C, 0x00, 0x00, 0x00, 0xB9, 0x00, 0x00, 0x00 } };
+static const DriverCase FELICITA{ "FELICITA", "FFE0",
+  { { "FFE1", true, false, false } },
+  { 0x01, 0x02, 0x2B, 0x30, 0x30, 0x31, 0x38, 0x35, 0x30, 0x20, 0x67, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+static const DriverCase MYSCALE{ "my_scale", "0000FFB0-0000-1000-8000-00805F9B34FB",
+  { { "0000FFB2-0000-1000-8000-00805F9B34FB", true, false, true }, { "0000FFB1-0000-1000-8000-00805F9B34FB", false, false, false } },
+  { 0xAC, 0x40, 0x00, 0x00, 0x00, 0x48, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x78 } };
+static const DriverCase TIMEMORE{ "Timemore Scale", "181D",
+  { { "2A9D", false, true, true }, { "553f4e49-bf21-4468-9c6c-0e4fb5b17697", false, false, false } },
+  { 0x10, 0xB9, 0x00, 0x00, 0x00, 0xB9, 0x00, 0x00, 0x00 } };
+static const DriverCase VARIA{ "AKU MINI SCALE", "FFF0",
+  { { "FFF1", true, false, false }, { "FFF2", false, false, false } },
+  { 0xFA, 0x01, 0x03, 0x00, 0x07, 0x3A, 0x3F } };
+static const DriverCase WEIGHMYBRU{ "WeighMyBru", "6E400001-B5A3-F393-E0A9-E50E24DCCA9E",
+  { { "6E400002-B5A3-F393-E0A9-E50E24DCCA9E", true, false, false }, { "6E400003-B5A3-F393-E0A9-E50E24DCCA9E", false, false, false } },
+  { 0x03, 0x0B, 0x00, 0x00, 0x00, 0x02, 0x2B, 0x00, 0x07, 0x3A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1C } };
+
+static void buildPeripheral(NimBLEFakePeripheral& peripheral, const DriverCase& scale) {
+  NimBLERemoteService* service = peripheral.addService(NimBLEUUID(scale.service));
+  for (const CharacteristicSpec& spec : scale.characteristics) {
+    if (spec.uuid == nullptr) continue;
+    NimBLERemoteCharacteristic* characteristic = service->addCharacteristic(NimBLEUUID(spec.uuid), spec.notify, spec.indicate);
+    if (spec.cccd) characteristic->addDescriptor(NimBLEUUID(CCCD));
+  }
+}
+
+static std::unique_ptr<RemoteScales> discover(NimBLEFakePeripheral& peripheral) {
+  NimBLEAdvertisedDevice advertised = peripheral.advertisement();
+  return RemoteScalesFactory::getInstance()->create(DiscoveredDevice(&advertised));
+}
+
+static void connectAndDecode(const DriverCase& scale) {
+  NimBLEFakePeripheral peripheral(ADDRESS, scale.name);
+  buildPeripheral(peripheral, scale);
+  NimBLEDevice::addPeripheral(&peripheral);
+  NimBLERemoteCharacteristic* weight = peripheral.getServices()[0]->getCharacteristics()[0].get();
+
+  std::unique_ptr<RemoteScales> driver = discover(peripheral);
+  TEST_ASSERT_NOT_NULL_MESSAGE(driver.get(), scale.name);
+  TEST_ASSERT_TRUE_MESSAGE(driver->connect(), scale.name);
+  TEST_ASSERT_TRUE_MESSAGE(driver->isConnected(), scale.name);
+  TEST_ASSERT_TRUE_MESSAGE(weight->isSubscribed(), scale.name);
+
+  driver->update();
+  TEST_ASSERT_TRUE_MESSAGE(weight->notify(scale.weightFrame.data(), scale.weightFrame.size()), scale.name);
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.001f, 18.5f, driver->getWeight(), scale.name);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, driver->getHealthCounters().framesOk, scale.name);
+
+  driver->disconnect();
+  TEST_ASSERT_FALSE_MESSAGE(driver->isConnected(), scale.name);
+  TEST_ASSERT_FALSE_MESSAGE(weight->isSubscribed(), scale.name);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, NimBLEDevice::getClientListSize(), scale.name);
+  NimBLEDevice::removePeripheral(&peripheral);
+}
+
+// The first half of a frame, cut off, then the whole frame in the same
+// notification. The cut-off start claims bytes of the whole frame and fails
+// its checksum; the driver must reject it so the whole frame is still found.
+static void rescanAfterBadChecksum(const DriverCase& scale) {
+  NimBLEFakePeripheral peripheral(ADDRESS, scale.name);
+  buildPeripheral(peripheral, scale);
+  NimBLEDevice::addPeripheral(&peripheral);
+  NimBLERemoteCharacteristic* weight = peripheral.getServices()[0]->getCharacteristics()[0].get();
+
+  std::unique_ptr<RemoteScales> driver = discover(peripheral);
+  TEST_ASSERT_TRUE_MESSAGE(driver->connect(), scale.name);
+  std::vector<uint8_t> stream(scale.weightFrame.begin(), scale.weightFrame.begin() + scale.weightFrame.size() / 2);
+  stream.insert(stream.end(), scale.weightFrame.begin(), scale.weightFrame.end());
+  TEST_ASSERT_TRUE_MESSAGE(weight->notify(stream.data(), stream.size()), scale.name);
+
+  TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.001f, 18.5f, driver->getWeight(), scale.name);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, driver->getHealthCounters().framesOk, scale.name);
+  TEST_ASSERT_TRUE_MESSAGE(driver->getHealthCounters().checksumFailures > 0, scale.name);
+  driver->disconnect();
+  NimBLEDevice::removePeripheral(&peripheral);
+}
+
+void test_bad_checksum_is_rescanned() {
+  rescanAfterBadChecksum(DIFLUID);
+  rescanAfterBadChecksum(ECLAIR);
+  rescanAfterBadChecksum(MYSCALE);
+  rescanAfterBadChecksum(VARIA);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_acaia() { connectAndDecode(ACAIA); }
+void test_bookoo() { connectAndDecode(BOOKOO); }
+void test_decent() { connectAndDecode(DECENT); }
+void test_difluid() { connectAndDecode(DIFLUID); }
+void test_dot() { connectAndDecode(DOT); }
+void test_eclair() { connectAndDecode(ECLAIR); }
+void test_eureka() { connectAndDecode(EUREKA); }
+void test_felicita() { connectAndDecode(FELICITA); }
+void test_myscale() { connectAndDecode(MYSCALE); }
+void test_timemore() { connectAndDecode(TIMEMORE); }
+void test_varia() { connectAndDecode(VARIA); }
+void test_weighmybru() { connectAndDecode(WEIGHMYBRU); }
+
+void test_missing_service_fails_cleanly() {
+  NimBLEFakePeripheral peripheral(ADDRESS, BOOKOO.name);
+  peripheral.addService(NimBLEUUID("FFF0"));
+  NimBLEDevice::addPeripheral(&peripheral);
+
+  std::unique_ptr<RemoteScales> driver = discover(peripheral);
+  TEST_ASSERT_FALSE(driver->connect());
+  TEST_ASSERT_FALSE(driver->isConnected());
+  TEST_ASSERT_EQUAL_UINT32(0, NimBLEDevice::getClientListSize());
+  NimBLEDevice::removePeripheral(&peripheral);
+}
+
+void test_dot_retries_link_on_simulated_clock() {
+  // The Dot waits 500 ms between attempts; the simulated clock makes that free.
+  SimulatedRemoteScalesClock clock;
+  RemoteScalesClock::setInstance(&clock);
+  NimBLEFakePeripheral peripheral(ADDRESS, DOT.name);
+  buildPeripheral(peripheral, DOT);
+  peripheral.connectable = false;
+  NimBLEDevice::addPeripheral(&peripheral);
+
+  std::unique_ptr<RemoteScales> driver = discover(peripheral);
+  TEST_ASSERT_FALSE(driver->connect());
+  TEST_ASSERT_EQUAL_UINT32(1500, remoteScalesMillis());
+
+  NimBLEDevice::removePeripheral(&peripheral);
+  RemoteScalesClock::setInstance(nullptr);
+}
+
+static std::vector<std::vector<uint8_t>> commandWrites(NimBLEFakePeripheral& peripheral, std::unique_ptr<RemoteScales>& driver) {
+  for (int i = 0; i < 4; i++) driver->update();
+  return peripheral.getServices()[0]->getCharacteristics()[1]->writes;
+}
+
+void test_tare_keeps_its_place_behind_queued_writes() {
+  // The Dot's handshake from connect() is still queued when the tare asks for
+  // the same bytes as its follow-up poll; the poll must still go out last.
+  NimBLEFakePeripheral peripheral(ADDRESS, DOT.name);
+  buildPeripheral(peripheral, DOT);
+  NimBLEDevice::addPeripheral(&peripheral);
+  std::unique_ptr<RemoteScales> driver = discover(peripheral);
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_TRUE(driver->tare());
+
+  std::vector<std::vector<uint8_t>> writes = commandWrites(peripheral, driver);
+  TEST_ASSERT_EQUAL_UINT32(3, writes.size());
+  TEST_ASSERT_EQUAL_UINT8(0x0D, writes[0][3]);
+  TEST_ASSERT_EQUAL_UINT8(0x04, writes[1][3]);
+  TEST_ASSERT_EQUAL_UINT8(0x0D, writes[2][3]);
+
+  driver->disconnect();
+  NimBLEDevice::removePeripheral(&peripheral);
+}
+
+void test_repeated_command_collapses_into_queue_tail() {
+  NimBLEFakePeripheral peripheral(ADDRESS, VARIA.name);
+  buildPeripheral(peripheral, VARIA);
+  NimBLEDevice::addPeripheral(&peripheral);
+  std::unique_ptr<RemoteScales> driver = discover(peripheral);
+  TEST_ASSERT_TRUE(driver->connect());
+  driver->update();
+  TEST_ASSERT_TRUE(driver->tare());
+  TEST_ASSERT_TRUE(driver->tare());
+
+  TEST_ASSERT_EQUAL_UINT32(1, commandWrites(peripheral, driver).size());
+
+  driver->disconnect();
+  NimBLEDevice::removePeripheral(&peripheral);
+}
+
+// A driver with one more notifying characteristic than there are
+// subscription slots, subscribing to each in turn.
+class CrowdedScale : public RemoteScales {
+public:
+  explicit CrowdedScale(const DiscoveredDevice& device) : RemoteScales(device) {}
+  using RemoteScales::MAX_SUBSCRIPTIONS;
+
+  std::vector<bool> subscribed;
+
+  bool connect() override {
+    if (!clientConnect()) return false;
+    NimBLERemoteService* service = clientGetService(NimBLEUUID("FFF0"));
+    for (int i = 0; i <= MAX_SUBSCRIPTIONS; i++) {
+      NimBLERemoteCharacteristic* characteristic = service->getCharacteristic(NimBLEUUID(static_cast<uint16_t>(0xFFF1 + i)));
+      subscribed.push_back(subscribe(characteristic, [](NimBLERemoteCharacteristic*, uint8_t*, size_t, bool) {}));
+    }
+    return true;
+  }
+  void disconnect() override { clientCleanup(); }
+  bool isConnected() override { return clientIsConnected(); }
+  bool tare() override { return false; }
+  void update() override {}
+};
+
+void test_subscription_beyond_table_is_refused() {
+  NimBLEFakePeripheral peripheral(ADDRESS, "Crowded");
+  NimBLERemoteService* service = peripheral.addService(NimBLEUUID("FFF0"));
+  for (int i = 0; i <= CrowdedScale::MAX_SUBSCRIPTIONS; i++) service->addCharacteristic(NimBLEUUID(static_cast<uint16_t>(0xFFF1 + i)));
+  NimBLEDevice::addPeripheral(&peripheral);
+
+  NimBLEAdvertisedDevice advertised = peripheral.advertisement();
+  CrowdedScale scale{ DiscoveredDevice(&advertised) };
+  TEST_ASSERT_TRUE(scale.connect());
+  TEST_ASSERT_EQUAL_UINT32(CrowdedScale::MAX_SUBSCRIPTIONS + 1, scale.subscribed.size());
+  for (int i = 0; i < CrowdedScale::MAX_SUBSCRIPTIONS; i++) {
+    TEST_ASSERT_TRUE(scale.subscribed[i]);
+    TEST_ASSERT_TRUE(service->getCharacteristics()[i]->isSubscribed());
+  }
+  // The caller hears about it, and the characteristic is not half set up.
+  TEST_ASSERT_FALSE(scale.subscribed.back());
+  TEST_ASSERT_FALSE(service->getCharacteristics().back()->isSubscribed());
+
+  scale.disconnect();
+  NimBLEDevice::removePeripheral(&peripheral);
+}
+
+void test_scanner_reports_supported_scales() {
+  NimBLEFakePeripheral supported(ADDRESS, VARIA.name);
+  NimBLEFakePeripheral unsupported("c8:2e:18:00:00:02", "Headphones");
+  NimBLEAdvertisedDevice first = supported.advertisement();
+  NimBLEAdvertisedDevice second = unsupported.advertisement();
+
+  RemoteScalesScanner scanner;
+  scanner.initializeAsyncScan();
+  NimBLEDevice::getScan()->advertise(first);
+  NimBLEDevice::getScan()->advertise(second);
+  std::vector<DiscoveredDevice> found = scanner.getDiscoveredScales();
+  scanner.stopAsyncScan();
+
+  TEST_ASSERT_EQUAL(1, found.size());
+  TEST_ASSERT_EQUAL_STRING(VARIA.name, found[0].getName().c_str());
+}
+
+int main(int argc, char** argv) {
+  AcaiaScalesPlugin::apply();
+  BookooScalesPlugin::apply();
+  DecentScalesPlugin::apply();
+  DifluidScalesPlugin::apply();
+  TimemoreDotScalesPlugin::apply();
+  EclairScalesPlugin::apply();
+  EurekaScalesPlugin::apply();
+  FelicitaScalePlugin::apply();
+  myscalePlugin::apply();
+  TimemoreScalesPlugin::apply();
+  VariaScalesPlugin::apply();
+  WeighMyBrewScalePlugin::apply();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_acaia);
+  RUN_TEST(test_bookoo);
+  RUN_TEST(test_decent);
+  RUN_TEST(test_difluid);
+  RUN_TEST(test_dot);
+  RUN_TEST(test_eclair);
+  RUN_TEST(test_eureka);
+  RUN_TEST(test_felicita);
+  RUN_TEST(test_myscale);
+  RUN_TEST(test_timemore);
+  RUN_TEST(test_varia);
+  RUN_TEST(test_weighmybru);
+  RUN_TEST(test_bad_checksum_is_rescanned);
+  RUN_TEST(test_missing_service_fails_cleanly);
+  RUN_TEST(test_dot_retries_link_on_simulated_clock);
+  RUN_TEST(test_tare_keeps_its_place_behind_queued_writes);
+  RUN_TEST(test_repeated_command_collapses_into_queue_tail);
+  RUN_TEST(test_subscription_beyond_table_is_refused);
+  RUN_TEST(test_scanner_reports_supported_scales);
+  return UNITY_END();
+}
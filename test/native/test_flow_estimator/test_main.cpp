@@ -0,0 +1,166 @@
+#include <unity.h>
+#include <flow_estimator.h>
+#include <cmath>
+#include <cstdio>
+
+// FlowEstimator on synthetic weight streams: how long it lags a step in
+// flow and how much sensor noise reaches the estimate, per window length,
+// printed for comparison between changes; and the fixed-point edges of the
+// window, the epoch rebase and millis() wraparound, which must stay exact.
+
+static const uint32_t INTERVAL_MS = 100;
+static const float FLOW = 2.f;
+static const size_t WINDOWS[] = { 5, 10, 20 };
+
+// Deterministic uniform noise in [-amplitude, amplitude].
+struct Noise {
+  uint32_t state;
+  float next(float amplitude) {
+    state = state * 1664525u + 1013904223u;
+    return ((state >> 8) / float(1u << 24) * 2.f - 1.f) * amplitude;
+  }
+};
+
+// Feeds a still scale, then FLOW g/s from the knee sample on; returns how
+// many samples past the knee the estimate first reaches 90 % of FLOW.
+static int samplesToReachNinetyPercent(FlowEstimator& estimator, uint32_t startMs) {
+  const int still = 40;
+  for (int i = 0; i <= still; i++) estimator.addSample(10.f, startMs + i * INTERVAL_MS);
+  for (int i = 1; i < 100; i++) {
+    estimator.addSample(10.f + FLOW * i * INTERVAL_MS / 1000.f, startMs + (still + i) * INTERVAL_MS);
+    if (estimator.getFlowRate() >= 0.9f * FLOW) return i;
+  }
+  return -1;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_ramp_lag() {
+  printf("\n%-8s %10s %10s\n", "window", "lag90 ms", "exact ms");
+  int previousLag = 0;
+  for (size_t window : WINDOWS) {
+    FlowEstimator lag(window);
+    int toNinety = samplesToReachNinetyPercent(lag, 0);
+    TEST_ASSERT_TRUE(toNinety > previousLag);
+    previousLag = toNinety;
+
+    // Exact once the window holds only ramp samples, the knee included.
+    FlowEstimator exact(window);
+    for (int i = 0; i <= 40; i++) exact.addSample(10.f, i * INTERVAL_MS);
+    int i = 1;
+    for (; i < static_cast<int>(window) - 1; i++) {
+      exact.addSample(10.f + FLOW * i * INTERVAL_MS / 1000.f, (40 + i) * INTERVAL_MS);
+    }
+    TEST_ASSERT_TRUE(exact.getFlowRate() < FLOW - 0.01f);
+    exact.addSample(10.f + FLOW * i * INTERVAL_MS / 1000.f, (40 + i) * INTERVAL_MS);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, FLOW, exact.getFlowRate());
+
+    printf("%-8u %10u %10u\n", (unsigned)window, toNinety * INTERVAL_MS, i * INTERVAL_MS);
+    // A least-squares slope crosses 90 % within the window.
+    TEST_ASSERT_TRUE(toNinety < static_cast<int>(window));
+  }
+}
+
+void test_steady_state_noise() {
+  // A load cell jittering by +-0.05 g under a steady 2 g/s pour.
+  const float amplitude = 0.05f;
+  const int samples = 2000;
+  printf("\n%-8s %10s %10s\n", "window", "mean g/s", "sd g/s");
+  float previousSd = INFINITY;
+  for (size_t window : WINDOWS) {
+    FlowEstimator estimator(window);
+    Noise noise{ 1 };
+    double sum = 0, sumSquares = 0;
+    int counted = 0;
+    for (int i = 0; i < samples; i++) {
+      estimator.addSample(FLOW * i * INTERVAL_MS / 1000.f + noise.next(amplitude), i * INTERVAL_MS);
+      if (i < static_cast<int>(window)) continue;
+      double rate = estimator.getFlowRate();
+      sum += rate;
+      sumSquares += rate * rate;
+      counted++;
+    }
+    float mean = sum / counted;
+    float sd = sqrt(sumSquares / counted - (sum / counted) * (sum / counted));
+    printf("%-8u %10.3f %10.3f\n", (unsigned)window, mean, sd);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, FLOW, mean);
+    TEST_ASSERT_TRUE(sd < previousSd);
+    previousSd = sd;
+  }
+  // Window 20 over 2 s: the slope of +-0.05 g noise stays well under 0.05 g/s.
+  TEST_ASSERT_TRUE(previousSd < 0.05f);
+}
+
+void test_window_is_clamped() {
+  FlowEstimator smallest(0);
+  smallest.addSample(0.f, 0);
+  smallest.addSample(0.2f, 100);
+  TEST_ASSERT_FALSE(smallest.isReady());
+  smallest.addSample(0.4f, 200);
+  TEST_ASSERT_TRUE(smallest.isReady());
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, FLOW, smallest.getFlowRate());
+
+  // Window 100 is MAX_WINDOW: exact after MAX_WINDOW - 1 ramp samples, not before.
+  FlowEstimator largest(100);
+  for (int i = 0; i <= 40; i++) largest.addSample(10.f, i * INTERVAL_MS);
+  int i = 1;
+  for (; i < static_cast<int>(FlowEstimator::MAX_WINDOW) - 1; i++) {
+    largest.addSample(10.f + FLOW * i * INTERVAL_MS / 1000.f, (40 + i) * INTERVAL_MS);
+  }
+  TEST_ASSERT_TRUE(largest.getFlowRate() < FLOW - 0.01f);
+  largest.addSample(10.f + FLOW * i * INTERVAL_MS / 1000.f, (40 + i) * INTERVAL_MS);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, FLOW, largest.getFlowRate());
+}
+
+void test_samples_at_one_instant_have_no_slope() {
+  FlowEstimator estimator(5);
+  for (int i = 0; i < 5; i++) estimator.addSample(10.f + i, 1000);
+  TEST_ASSERT_FALSE(estimator.isReady());
+  TEST_ASSERT_EQUAL_FLOAT(0.f, estimator.getFlowRate());
+  TEST_ASSERT_EQUAL_INT32(0, estimator.getFlowRateCentigrams());
+}
+
+void test_negative_and_uneven_samples_are_exact() {
+  // Draining below zero after a tare, on a link that delivers unevenly.
+  static const uint32_t GAPS_MS[] = { 80, 130, 95, 160, 40, 110, 100, 75, 125, 90 };
+  FlowEstimator estimator(10);
+  uint32_t t = 0;
+  for (int i = 0; i < 30; i++) {
+    t += GAPS_MS[i % 10];
+    estimator.addSample(0.5f - 1.5f * t / 1000.f, t);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, -1.5f, estimator.getFlowRate());
+  TEST_ASSERT_INT32_WITHIN(1, -150, estimator.getFlowRateCentigrams());
+}
+
+void test_rebase_and_millis_wraparound_stay_exact() {
+  // Starts just short of the uint32 wrap and runs past several rebases.
+  const uint32_t startMs = 0xFFFFFFFFu - 5000;
+  const uint32_t runMs = 3u * FlowEstimator::REBASE_AFTER_MS;
+  FlowEstimator estimator(10);
+  int checked = 0;
+  for (uint32_t elapsed = 0; elapsed < runMs; elapsed += INTERVAL_MS) {
+    // Weight goes round a 100 g sawtooth so it stays in range; only whole
+    // windows on one tooth are checked.
+    float weight = FLOW * (elapsed % 50000) / 1000.f;
+    estimator.addSample(weight, startMs + elapsed);
+    if (elapsed % 50000 >= 10 * INTERVAL_MS) {
+      TEST_ASSERT_FLOAT_WITHIN(0.001f, FLOW, estimator.getFlowRate());
+      TEST_ASSERT_EQUAL_INT32(200, estimator.getFlowRateCentigrams());
+      checked++;
+    }
+  }
+  TEST_ASSERT_TRUE(checked > 30000);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_ramp_lag);
+  RUN_TEST(test_steady_state_noise);
+  RUN_TEST(test_window_is_clamped);
+  RUN_TEST(test_samples_at_one_instant_have_no_slope);
+  RUN_TEST(test_negative_and_uneven_samples_are_exact);
+  RUN_TEST(test_rebase_and_millis_wraparound_stay_exact);
+  return UNITY_END();
+}
@@ -0,0 +1,64 @@
+#include <unity.h>
+#include <frame_reassembler.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// FrameReassembler on a line protocol whose length is only known once the
+// terminator arrives: "<payload\n". A stray start byte makes measure() ask
+// for more until the buffer is full, which must not cost the frames behind it.
+
+static const size_t CAPACITY = 64;
+
+static std::vector<std::string> frames;
+
+static int32_t measureLine(const uint8_t* data, size_t available) {
+  if (data[0] != '<') return -1;
+  for (size_t i = 1; i < available; i++) {
+    if (data[i] == '\n') return static_cast<int32_t>(i + 1);
+  }
+  return 0;
+}
+
+static void collectLine(const uint8_t* frame, size_t length) { frames.emplace_back(frame + 1, frame + length - 1); }
+
+static size_t feedInPieces(FrameReassembler<CAPACITY>& reassembler, const std::string& stream, size_t piece) {
+  size_t discarded = 0;
+  for (size_t offset = 0; offset < stream.size(); offset += piece) {
+    size_t length = std::min(piece, stream.size() - offset);
+    discarded += reassembler.feed(reinterpret_cast<const uint8_t*>(stream.data()) + offset, length, measureLine, collectLine);
+  }
+  return discarded;
+}
+
+void setUp() { frames.clear(); }
+void tearDown() {}
+
+void test_frames_split_across_notifications() {
+  FrameReassembler<CAPACITY> reassembler;
+  size_t discarded = feedInPieces(reassembler, "<one\n<two\n<three\n", 3);
+  TEST_ASSERT_EQUAL_UINT32(0, discarded);
+  TEST_ASSERT_EQUAL_UINT32(3, frames.size());
+  TEST_ASSERT_EQUAL_STRING("three", frames[2].c_str());
+}
+
+void test_full_buffer_drops_only_the_stray_start() {
+  // The stray '<' and the frame behind it do not fit the buffer together,
+  // but the frame alone does.
+  std::string frame = "<" + std::string(CAPACITY - 10, 'y') + "\n";
+  std::string stream = "<" + std::string(8, 'x') + frame;
+  TEST_ASSERT_TRUE(stream.size() > CAPACITY);
+
+  FrameReassembler<CAPACITY> reassembler;
+  size_t discarded = feedInPieces(reassembler, stream, 20);
+  TEST_ASSERT_EQUAL_UINT32(1, frames.size());
+  TEST_ASSERT_EQUAL_STRING(frame.substr(1, frame.size() - 2).c_str(), frames[0].c_str());
+  TEST_ASSERT_EQUAL_UINT32(9, discarded);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_split_across_notifications);
+  RUN_TEST(test_full_buffer_drops_only_the_stray_start);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+#include "../../fuzz/fuzz_targets.h"
+#include <dirent.h>
+#include <string>
+
+// Replays every fuzz seed corpus through its target, then a fixed set of
+// mutations of each seed, so the notification paths get fuzz coverage on
+// every native run even where libFuzzer is not available. A violated
+// invariant or a sanitizer report aborts the run.
+
+static const int MUTATIONS_PER_SEED = 200;
+
+using Bytes = std::vector<uint8_t>;
+
+static std::string corpusRoot() {
+  std::string fromProject = "test/fuzz/corpus";
+  if (DIR* dir = opendir(fromProject.c_str())) {
+    closedir(dir);
+    return fromProject;
+  }
+  std::string file = __FILE__;
+  return file.substr(0, file.rfind('/')) + "/../../fuzz/corpus";
+}
+
+static std::vector<Bytes> readCorpus(const char* name) {
+  std::vector<Bytes> seeds;
+  std::string path = corpusRoot() + "/" + name;
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) return seeds;
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] == '.') continue;
+    FILE* file = fopen((path + "/" + entry->d_name).c_str(), "rb");
+    if (file == nullptr) continue;
+    Bytes seed;
+    int byte;
+    while ((byte = fgetc(file)) != EOF) seed.push_back(static_cast<uint8_t>(byte));
+    fclose(file);
+    seeds.push_back(seed);
+  }
+  closedir(dir);
+  return seeds;
+}
+
+static uint32_t nextRandom(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// libFuzzer-style edits: flip a bit, set a byte, insert or erase a run, or
+// splice in part of another seed.
+static Bytes mutate(const Bytes& seed, const std::vector<Bytes>& corpus, uint32_t& random) {
+  Bytes input = seed;
+  int edits = 1 + nextRandom(random) % 4;
+  for (int i = 0; i < edits && !input.empty(); i++) {
+    size_t at = nextRandom(random) % input.size();
+    switch (nextRandom(random) % 5) {
+    case 0: input[at] ^= 1 << (nextRandom(random) % 8); break;
+    case 1: input[at] = static_cast<uint8_t>(nextRandom(random)); break;
+    case 2: input.insert(input.begin() + at, 1 + nextRandom(random) % 8, static_cast<uint8_t>(nextRandom(random))); break;
+    case 3: input.erase(input.begin() + at, input.begin() + std::min(input.size(), at + 1 + nextRandom(random) % 8)); break;
+    default: {
+      const Bytes& other = corpus[nextRandom(random) % corpus.size()];
+      if (other.size() > 1) input.insert(input.begin() + at, other.begin() + 1, other.end());
+    }
+    }
+  }
+  return input;
+}
+
+static void replayTarget(const FuzzTarget& target) {
+  std::vector<Bytes> corpus = readCorpus(target.name);
+  TEST_ASSERT_TRUE_MESSAGE(!corpus.empty(), target.name);
+  uint32_t random = 0x9E3779B9;
+  for (const Bytes& seed : corpus) {
+    target.run(seed.data(), seed.size());
+    for (int i = 0; i < MUTATIONS_PER_SEED; i++) {
+      Bytes input = mutate(seed, corpus, random);
+      target.run(input.data(), input.size());
+    }
+  }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_acaia() { replayTarget(FUZZ_TARGETS[0]); }
+void test_bookoo() { replayTarget(FUZZ_TARGETS[1]); }
+void test_decent() { replayTarget(FUZZ_TARGETS[2]); }
+void test_difluid() { replayTarget(FUZZ_TARGETS[3]); }
+void test_dot() { replayTarget(FUZZ_TARGETS[4]); }
+void test_eclair() { replayTarget(FUZZ_TARGETS[5]); }
+void test_eureka() { replayTarget(FUZZ_TARGETS[6]); }
+void test_felicita() { replayTarget(FUZZ_TARGETS[7]); }
+void test_myscale() { replayTarget(FUZZ_TARGETS[8]); }
+void test_timemore() { replayTarget(FUZZ_TARGETS[9]); }
+void test_varia() { replayTarget(FUZZ_TARGETS[10]); }
+void test_weighmybru() { replayTarget(FUZZ_TARGETS[11]); }
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_acaia);
+  RUN_TEST(test_bookoo);
+  RUN_TEST(test_decent);
+  RUN_TEST(test_difluid);
+  RUN_TEST(test_dot);
+  RUN_TEST(test_eclair);
+  RUN_TEST(test_eureka);
+  RUN_TEST(test_felicita);
+  RUN_TEST(test_myscale);
+  RUN_TEST(test_timemore);
+  RUN_TEST(test_varia);
+  RUN_TEST(test_weighmybru);
+  return UNITY_END();
+}
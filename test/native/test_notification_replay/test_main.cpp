@@ -0,0 +1,121 @@
+#include <unity.h>
+#include <virtual_scales.h>
+#include <notification_replay.h>
+
+// NotificationReplay through a connected driver: every decoded sample reaches
+// onSample, timing is real even under a simulated clock, and records no ATT
+// payload could carry are skipped and counted.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+static std::vector<uint32_t> sampleTimes;
+static std::vector<float> sampleWeights;
+
+static void collect(uint32_t recordedMs, float weight) {
+  sampleTimes.push_back(recordedMs);
+  sampleWeights.push_back(weight);
+}
+
+struct Trace {
+  std::vector<std::vector<uint8_t>> payloads;
+  std::vector<ReplayRecord> records;
+
+  void add(uint32_t timestampMs, std::vector<uint8_t> payload) {
+    payloads.push_back(std::move(payload));
+    records.push_back({ timestampMs, NimBLEUUID("FFF1"), nullptr, payloads.back().size() });
+  }
+
+  const ReplayRecord* data() {
+    for (size_t i = 0; i < records.size(); i++) records[i].data = payloads[i].data();
+    return records.data();
+  }
+};
+
+static std::vector<uint8_t> frames(const VirtualScale& scale, std::initializer_list<float> grams) {
+  std::vector<uint8_t> bytes;
+  for (float value : grams) {
+    uint8_t frame[VirtualScale::MAX_FRAME_LENGTH];
+    size_t length = scale.encode(value, 0, frame);
+    bytes.insert(bytes.end(), frame, frame + length);
+  }
+  return bytes;
+}
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+  sampleTimes.clear();
+  sampleWeights.clear();
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_every_decoded_sample_reaches_on_sample() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  Trace trace;
+  trace.add(100, frames(scale, { 1.f, 2.f, 3.f }));
+  trace.add(200, frames(scale, { 4.f }));
+  ReplayResult result = NotificationReplay(*driver).run(trace.data(), trace.records.size(), NotificationReplay::Pace::FAST, collect);
+
+  TEST_ASSERT_EQUAL_UINT32(2, result.frames);
+  TEST_ASSERT_EQUAL_UINT32(4, result.samples);
+  TEST_ASSERT_EQUAL_UINT32(4, sampleWeights.size());
+  for (size_t i = 0; i < 4; i++) TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.f + i, sampleWeights[i]);
+  TEST_ASSERT_EQUAL_UINT32(100, sampleTimes[2]);
+  TEST_ASSERT_EQUAL_UINT32(200, sampleTimes[3]);
+
+  // The subscriber slot is handed back.
+  sampleWeights.clear();
+  scale.send(5.f, 0);
+  TEST_ASSERT_EQUAL_UINT32(0, sampleWeights.size());
+  driver->disconnect();
+}
+
+void test_timing_is_real_under_simulated_clock() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  Trace trace;
+  for (uint32_t i = 0; i < 500; i++) trace.add(i * 100, frames(scale, { i * 0.1f }));
+  ReplayResult result = NotificationReplay(*driver).run(trace.data(), trace.records.size(), NotificationReplay::Pace::RECORDED);
+
+  TEST_ASSERT_EQUAL_UINT32(500, result.samples);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, result.nsPerFrame);
+  // The simulated clock moved through the trace; none of that counts as decode time.
+  TEST_ASSERT_EQUAL_UINT32(1000 + 49900, remoteScalesMillis());
+  TEST_ASSERT_LESS_THAN_UINT32(1000000, result.decodeUs);
+  driver->disconnect();
+}
+
+void test_oversized_records_are_skipped_and_counted() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  Trace trace;
+  trace.add(0, std::vector<uint8_t>(600, 0xFA));
+  trace.add(100, frames(scale, { 18.5f }));
+  ReplayResult result = NotificationReplay(*driver).run(trace.data(), trace.records.size(), NotificationReplay::Pace::FAST);
+
+  TEST_ASSERT_EQUAL_UINT32(1, result.oversized);
+  TEST_ASSERT_EQUAL_UINT32(1, result.frames);
+  TEST_ASSERT_EQUAL_UINT32(1, result.samples);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 18.5f, driver->getWeight());
+  driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_every_decoded_sample_reaches_on_sample);
+  RUN_TEST(test_timing_is_real_under_simulated_clock);
+  RUN_TEST(test_oversized_records_are_skipped_and_counted);
+  return UNITY_END();
+}
@@ -0,0 +1,178 @@
+#include <unity.h>
+#include <virtual_scales.h>
+#include <periodic_scheduler.h>
+
+// PeriodicScheduler and RemoteScales::getMsUntilNextUpdate() on the
+// simulated clock: a loop that sleeps for untilNext() and wakes late keeps
+// its cadence without drift, a stall costs one run rather than a burst, and
+// none of it notices millis() wrapping.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+// Bookoo's heartbeat period.
+static const uint32_t HEARTBEAT_MS = 2000;
+
+// millis() this far short of wrapping at the start of a test.
+static uint64_t startUsBeforeWrap(uint32_t ms) { return (uint64_t(UINT32_MAX) + 1 - ms) * 1000; }
+
+static void useClock(uint64_t startUs) {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+  clock_ = new SimulatedRemoteScalesClock(startUs);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void setUp() { useClock(1000000); }
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+  clock_ = nullptr;
+}
+
+// Sleeps for untilNext() plus up to 9 ms of wake-up lateness, `cycles` times.
+static void runLate(PeriodicScheduler<2>& scheduler, int cycles) {
+  for (int i = 0; i < cycles; i++) {
+    clock_->advanceMs(scheduler.untilNext(remoteScalesMillis()) + (i * 7) % 10);
+    scheduler.run(remoteScalesMillis());
+  }
+}
+
+// The n-th run is late by its own wake-up only, never by the ones before it.
+static void assertOnCadence(const std::vector<uint32_t>& runs, uint32_t startMs, uint32_t periodMs) {
+  for (size_t n = 0; n < runs.size(); n++) {
+    uint32_t lateMs = runs[n] - startMs - (n + 1) * periodMs;
+    TEST_ASSERT_LESS_OR_EQUAL(9, lateMs);
+  }
+}
+
+void test_late_wake_ups_do_not_drift() {
+  PeriodicScheduler<2> scheduler;
+  std::vector<uint32_t> runs;
+  uint32_t startMs = remoteScalesMillis();
+  TEST_ASSERT_TRUE(scheduler.add(100, [&] { runs.push_back(remoteScalesMillis()); }, startMs));
+  TEST_ASSERT_EQUAL_UINT32(100, scheduler.untilNext(startMs));
+
+  runLate(scheduler, 200);
+  TEST_ASSERT_EQUAL_UINT32(200, runs.size());
+  assertOnCadence(runs, startMs, 100);
+}
+
+void test_stall_runs_once_then_resumes_from_now() {
+  PeriodicScheduler<2> scheduler;
+  uint32_t fast = 0, slow = 0;
+  uint32_t startMs = remoteScalesMillis();
+  scheduler.add(100, [&] { fast++; }, startMs);
+  scheduler.add(1000, [&] { slow++; }, startMs);
+  TEST_ASSERT_EQUAL_UINT32(100, scheduler.untilNext(startMs));
+
+  // The loop stalls for 2.5 s: each task runs once, not once per missed period.
+  clock_->advanceMs(2500);
+  scheduler.run(remoteScalesMillis());
+  TEST_ASSERT_EQUAL_UINT32(1, fast);
+  TEST_ASSERT_EQUAL_UINT32(1, slow);
+  TEST_ASSERT_EQUAL_UINT32(100, scheduler.untilNext(remoteScalesMillis()));
+  scheduler.run(remoteScalesMillis());
+  TEST_ASSERT_EQUAL_UINT32(1, fast);
+
+  // A task less than a period behind keeps its cadence instead.
+  clock_->advanceMs(150);
+  scheduler.run(remoteScalesMillis());
+  TEST_ASSERT_EQUAL_UINT32(2, fast);
+  TEST_ASSERT_EQUAL_UINT32(50, scheduler.untilNext(remoteScalesMillis()));
+}
+
+void test_table_limits_and_restart() {
+  PeriodicScheduler<2> scheduler;
+  uint32_t now = remoteScalesMillis();
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, scheduler.untilNext(now));
+  TEST_ASSERT_FALSE(scheduler.add(0, [] {}, now));
+  TEST_ASSERT_TRUE(scheduler.add(300, [] {}, now));
+  TEST_ASSERT_TRUE(scheduler.add(200, [] {}, now));
+  TEST_ASSERT_FALSE(scheduler.add(100, [] {}, now));
+  TEST_ASSERT_EQUAL_UINT32(200, scheduler.untilNext(now));
+
+  clock_->advanceMs(150);
+  scheduler.restart(remoteScalesMillis());
+  TEST_ASSERT_EQUAL_UINT32(200, scheduler.untilNext(remoteScalesMillis()));
+  // Past due reads as 0, not as a wrapped wait.
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.untilNext(remoteScalesMillis() + 500));
+
+  scheduler.clear();
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, scheduler.untilNext(remoteScalesMillis()));
+}
+
+void test_cadence_across_millis_wraparound() {
+  useClock(startUsBeforeWrap(450));
+  PeriodicScheduler<2> scheduler;
+  std::vector<uint32_t> runs;
+  uint32_t startMs = remoteScalesMillis();
+  scheduler.add(100, [&] { runs.push_back(remoteScalesMillis()); }, startMs);
+
+  runLate(scheduler, 10);
+  TEST_ASSERT_TRUE(remoteScalesMillis() < startMs);
+  TEST_ASSERT_EQUAL_UINT32(10, runs.size());
+  assertOnCadence(runs, startMs, 100);
+}
+
+static std::vector<std::vector<uint8_t>>& commandWrites(BookooVirtualScale& scale) {
+  return scale.getPeripheral().getServices()[0]->getCharacteristics()[1]->writes;
+}
+
+// Sleeps as getMsUntilNextUpdate() says for up to forMs; returns how many
+// wake-ups there were, each of which must have had a heartbeat to write.
+static uint32_t sleepThroughHeartbeats(BookooVirtualScale& scale, RemoteScales& driver, uint32_t forMs) {
+  uint32_t startMs = remoteScalesMillis();
+  uint32_t wakeUps = 0;
+  for (;;) {
+    uint32_t wait = driver.getMsUntilNextUpdate();
+    TEST_ASSERT_TRUE(wait <= HEARTBEAT_MS);
+    if (remoteScalesMillis() - startMs + wait > forMs) return wakeUps;
+    clock_->advanceMs(wait);
+    size_t writesBefore = commandWrites(scale).size();
+    driver.update();
+    if (wait > 0) {
+      TEST_ASSERT_GREATER_THAN_UINT32(writesBefore, commandWrites(scale).size());
+      wakeUps++;
+    }
+  }
+}
+
+void test_update_wait_follows_heartbeat() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  driver->update();
+  TEST_ASSERT_EQUAL_UINT32(HEARTBEAT_MS, driver->getMsUntilNextUpdate());
+
+  clock_->advanceMs(500);
+  TEST_ASSERT_EQUAL_UINT32(HEARTBEAT_MS - 500, driver->getMsUntilNextUpdate());
+  TEST_ASSERT_EQUAL_UINT32(10, sleepThroughHeartbeats(scale, *driver, 10 * HEARTBEAT_MS));
+  driver->disconnect();
+}
+
+void test_update_wait_across_millis_wraparound() {
+  useClock(startUsBeforeWrap(3 * HEARTBEAT_MS + 100));
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  driver->update();
+  uint32_t connectedMs = remoteScalesMillis();
+
+  TEST_ASSERT_EQUAL_UINT32(6, sleepThroughHeartbeats(scale, *driver, 6 * HEARTBEAT_MS));
+  TEST_ASSERT_TRUE(remoteScalesMillis() < connectedMs);
+  TEST_ASSERT_EQUAL_UINT32(HEARTBEAT_MS, driver->getMsUntilNextUpdate());
+  driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_late_wake_ups_do_not_drift);
+  RUN_TEST(test_stall_runs_once_then_resumes_from_now);
+  RUN_TEST(test_table_limits_and_restart);
+  RUN_TEST(test_cadence_across_millis_wraparound);
+  RUN_TEST(test_update_wait_follows_heartbeat);
+  RUN_TEST(test_update_wait_across_millis_wraparound);
+  return UNITY_END();
+}
@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <virtual_scales.h>
+
+// Which samples a subscriber gets for its channel mask and deadband, on a
+// virtual scale whose battery and unit never change.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+static std::vector<float> received;
+
+static void collect(const ScaleSnapshot& sample) { received.push_back(sample.weight); }
+
+static void sendAll(VirtualScale& scale, std::initializer_list<float> grams) {
+  for (float value : grams) {
+    clock_->advanceMs(100);
+    scale.send(value, remoteScalesMillis());
+  }
+}
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+  received.clear();
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_defaults_deliver_every_sample() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_TRUE(driver->subscribeSamples(collect));
+  sendAll(scale, { 1.f, 1.f, 1.f, 2.f });
+  TEST_ASSERT_EQUAL_UINT32(4, received.size());
+  driver->disconnect();
+}
+
+void test_channel_mask_applies_without_deadband() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  // Battery only: the first sample, then nothing while the weight moves.
+  TEST_ASSERT_TRUE(driver->subscribeSamples(collect, { .channels = SCALE_CHANNEL_BATTERY }));
+  sendAll(scale, { 1.f, 2.f, 3.f });
+  TEST_ASSERT_EQUAL_UINT32(1, received.size());
+  driver->unsubscribeSamples(collect);
+
+  // Weight only: any change passes, a repeat does not.
+  received.clear();
+  TEST_ASSERT_TRUE(driver->subscribeSamples(collect, { .channels = SCALE_CHANNEL_WEIGHT }));
+  sendAll(scale, { 4.f, 4.f, 4.1f, 4.1f, 4.f });
+  TEST_ASSERT_EQUAL_UINT32(3, received.size());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 4.1f, received[1]);
+  driver->disconnect();
+}
+
+void test_deadband_filters_small_moves() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_TRUE(driver->subscribeSamples(collect, { .deadband = 0.5f, .channels = SCALE_CHANNEL_WEIGHT }));
+  sendAll(scale, { 1.f, 1.2f, 1.4f, 1.6f, 1.7f, 2.2f });
+  TEST_ASSERT_EQUAL_UINT32(3, received.size());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.6f, received[1]);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.2f, received[2]);
+  driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_defaults_deliver_every_sample);
+  RUN_TEST(test_channel_mask_applies_without_deadband);
+  RUN_TEST(test_deadband_filters_small_moves);
+  return UNITY_END();
+}
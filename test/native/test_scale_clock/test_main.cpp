@@ -0,0 +1,72 @@
+#include <unity.h>
+#include <virtual_scales.h>
+
+// Sample timestamps from a scale that stamps its frames with its stopwatch:
+// mapped from the scale clock while the stopwatch runs, arrival time once it
+// stops.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+// Samples every 100 ms, each carrying the running stopwatch.
+static uint32_t runStopwatch(BookooVirtualScale& scale, RemoteScales& driver, uint32_t startMs, int samples) {
+  uint32_t timerMs = startMs;
+  for (int i = 0; i < samples; i++) {
+    clock_->advanceMs(100);
+    timerMs += 100;
+    scale.send(10.f + i * 0.1f, timerMs);
+    driver.update();
+  }
+  return timerMs;
+}
+
+void test_running_timer_dates_samples() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  runStopwatch(scale, *driver, 0, 30);
+
+  TEST_ASSERT_TRUE(driver->isScaleClockSynchronized());
+  TEST_ASSERT_UINT32_WITHIN(2, 0, remoteScalesMillis() - driver->getSampleTimestampMs());
+  driver->disconnect();
+}
+
+void test_stopped_timer_falls_back_to_arrival_time() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  uint32_t stoppedAtMs = runStopwatch(scale, *driver, 0, 30);
+  TEST_ASSERT_TRUE(driver->isScaleClockSynchronized());
+
+  // The stopwatch stops but the scale keeps weighing.
+  for (int i = 0; i < 30; i++) {
+    clock_->advanceMs(100);
+    scale.send(20.f + i * 0.1f, stoppedAtMs);
+    driver->update();
+    TEST_ASSERT_EQUAL_UINT32(remoteScalesMillis(), driver->getSampleTimestampMs());
+  }
+  TEST_ASSERT_EQUAL_UINT32(stoppedAtMs, driver->getScaleTimerMs());
+
+  // Restarted, it dates samples again once the sync has relocked.
+  runStopwatch(scale, *driver, stoppedAtMs, 30);
+  TEST_ASSERT_TRUE(driver->isScaleClockSynchronized());
+  TEST_ASSERT_UINT32_WITHIN(2, 0, remoteScalesMillis() - driver->getSampleTimestampMs());
+  driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_running_timer_dates_samples);
+  RUN_TEST(test_stopped_timer_falls_back_to_arrival_time);
+  return UNITY_END();
+}
@@ -0,0 +1,195 @@
+#include <unity.h>
+#include <virtual_scales.h>
+
+// What consumers hear about their commands on a connected Bookoo: one
+// completion per queued write in queue order, with coalesced repeats folded
+// into a single completion, and one tare result per tare with its latency.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+// RemoteScales::COMMAND_BURST_LIMIT and COMMAND_TIMEOUT_MS.
+static const size_t BURST_LIMIT = 4;
+static const uint32_t COMMAND_TIMEOUT_MS = 1000;
+// RemoteScales::TARE_TIMEOUT_MS.
+static const uint32_t TARE_TIMEOUT_MS = 3000;
+
+struct Completion {
+  ScaleCommand command;
+  ScaleCommandStatus status;
+};
+
+static std::vector<Completion> completions;
+
+struct TareResult {
+  TareState state;
+  uint32_t latencyMs;
+};
+
+static std::vector<TareResult> tareResults;
+
+static void recordTare(TareState state, uint32_t latencyMs) { tareResults.push_back({ state, latencyMs }); }
+
+static void recordCompletion(ScaleCommand command, ScaleCommandStatus status) { completions.push_back({ command, status }); }
+
+static std::vector<std::vector<uint8_t>>& commandWrites(VirtualScale& scale) {
+  return scale.getPeripheral().getServices()[0]->getCharacteristics()[1]->writes;
+}
+
+static void assertCompletions(std::initializer_list<Completion> expected) {
+  TEST_ASSERT_EQUAL_UINT32(expected.size(), completions.size());
+  size_t i = 0;
+  for (const Completion& completion : expected) {
+    TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(completion.command), static_cast<uint8_t>(completions[i].command));
+    TEST_ASSERT_EQUAL_UINT8(static_cast<uint8_t>(completion.status), static_cast<uint8_t>(completions[i].status));
+    i++;
+  }
+  completions.clear();
+}
+
+// Connected, with the handshake's writes already sent and forgotten.
+static std::unique_ptr<RemoteScales> connectQuietly(VirtualScale& scale) {
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  driver->setCommandCallback(recordCompletion);
+  TEST_ASSERT_TRUE(driver->connect());
+  for (int i = 0; i < 4; i++) driver->update();
+  TEST_ASSERT_TRUE(driver->getMsUntilNextUpdate() > 0);
+  completions.clear();
+  commandWrites(scale).clear();
+  return driver;
+}
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+  completions.clear();
+  tareResults.clear();
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_completions_follow_queue_order_with_coalescing() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = connectQuietly(scale);
+
+  // The second tare is identical to the queue tail and folds into it; the
+  // last one follows other writes and is queued on its own.
+  TEST_ASSERT_TRUE(driver->tare());
+  TEST_ASSERT_TRUE(driver->tare());
+  driver->startTimer();
+  driver->stopTimer();
+  driver->resetTimer();
+  TEST_ASSERT_TRUE(driver->tare());
+  TEST_ASSERT_EQUAL_UINT32(0, completions.size());
+
+  // At most BURST_LIMIT per update().
+  driver->update();
+  TEST_ASSERT_EQUAL_UINT32(BURST_LIMIT, commandWrites(scale).size());
+  assertCompletions({
+    { ScaleCommand::TARE, ScaleCommandStatus::SENT },
+    { ScaleCommand::START_TIMER, ScaleCommandStatus::SENT },
+    { ScaleCommand::STOP_TIMER, ScaleCommandStatus::SENT },
+    { ScaleCommand::RESET_TIMER, ScaleCommandStatus::SENT },
+  });
+  driver->update();
+  TEST_ASSERT_EQUAL_UINT32(5, commandWrites(scale).size());
+  assertCompletions({ { ScaleCommand::TARE, ScaleCommandStatus::SENT } });
+  driver->disconnect();
+}
+
+void test_expired_and_dropped_commands_complete_in_order() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = connectQuietly(scale);
+
+  driver->startTimer();
+  driver->stopTimer();
+  clock_->advanceMs(COMMAND_TIMEOUT_MS + 1);
+  driver->update();
+  TEST_ASSERT_EQUAL_UINT32(0, commandWrites(scale).size());
+  assertCompletions({
+    { ScaleCommand::START_TIMER, ScaleCommandStatus::TIMED_OUT },
+    { ScaleCommand::STOP_TIMER, ScaleCommandStatus::TIMED_OUT },
+  });
+
+  // Writes still queued when the link goes are reported dropped.
+  driver->resetTimer();
+  driver->startTimer();
+  driver->disconnect();
+  assertCompletions({
+    { ScaleCommand::RESET_TIMER, ScaleCommandStatus::DROPPED },
+    { ScaleCommand::START_TIMER, ScaleCommandStatus::DROPPED },
+  });
+}
+
+void test_tare_confirms_on_zero_after_the_write() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = connectQuietly(scale);
+  driver->setTareCallback(recordTare);
+  scale.send(0.1f, 0);
+
+  TEST_ASSERT_TRUE(driver->tare());
+  TEST_ASSERT_EQUAL(TareState::PENDING, driver->getTareState());
+  // Already near zero, but from before the tare went out: not a confirmation.
+  clock_->advanceMs(20);
+  scale.send(0.1f, 0);
+  TEST_ASSERT_EQUAL(TareState::PENDING, driver->getTareState());
+
+  clock_->advanceMs(20);
+  driver->update();
+  clock_->advanceMs(60);
+  scale.send(0.1f, 0);
+  TEST_ASSERT_EQUAL(TareState::CONFIRMED, driver->getTareState());
+  TEST_ASSERT_EQUAL_UINT32(1, tareResults.size());
+  TEST_ASSERT_EQUAL(TareState::CONFIRMED, tareResults[0].state);
+  TEST_ASSERT_EQUAL_UINT32(100, tareResults[0].latencyMs);
+
+  TareLatencyStats stats = driver->getTareLatencyStats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.confirmed);
+  TEST_ASSERT_EQUAL_UINT32(100, stats.lastMs);
+  TEST_ASSERT_EQUAL_UINT32(100, stats.p50Ms);
+  TEST_ASSERT_EQUAL_UINT32(100, stats.maxMs);
+
+  // Later samples do not report it again.
+  scale.send(0.f, 0);
+  TEST_ASSERT_EQUAL_UINT32(1, tareResults.size());
+  driver->disconnect();
+}
+
+void test_tare_times_out_without_zero() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = connectQuietly(scale);
+  driver->setTareCallback(recordTare);
+
+  TEST_ASSERT_TRUE(driver->tare());
+  driver->update();
+  // A cup lands as the tare goes out, so the scale never reads zero.
+  uint32_t elapsedMs = 0;
+  while (tareResults.empty() && elapsedMs < 2 * TARE_TIMEOUT_MS) {
+    clock_->advanceMs(100);
+    elapsedMs += 100;
+    scale.send(250.f, 0);
+    driver->update();
+  }
+
+  TEST_ASSERT_EQUAL_UINT32(1, tareResults.size());
+  TEST_ASSERT_EQUAL(TareState::TIMED_OUT, tareResults[0].state);
+  TEST_ASSERT_EQUAL_UINT32(TARE_TIMEOUT_MS + 100, tareResults[0].latencyMs);
+  TEST_ASSERT_EQUAL(TareState::TIMED_OUT, driver->getTareState());
+  TareLatencyStats stats = driver->getTareLatencyStats();
+  TEST_ASSERT_EQUAL_UINT32(0, stats.confirmed);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.timedOut);
+  TEST_ASSERT_EQUAL_UINT32(TARE_TIMEOUT_MS + 100, stats.lastMs);
+  driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_completions_follow_queue_order_with_coalescing);
+  RUN_TEST(test_expired_and_dropped_commands_complete_in_order);
+  RUN_TEST(test_tare_confirms_on_zero_after_the_write);
+  RUN_TEST(test_tare_times_out_without_zero);
+  return UNITY_END();
+}
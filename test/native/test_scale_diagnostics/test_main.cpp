@@ -0,0 +1,123 @@
+#include <unity.h>
+#include <virtual_scales.h>
+
+// The diagnostics a connected driver reports about its own stream, read back
+// after a known sequence of notifications on the simulated clock.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+static void sendEvery(VirtualScale& scale, uint32_t gapMs, int samples) {
+  for (int i = 0; i < samples; i++) {
+    clock_->advanceMs(gapMs);
+    scale.send(1.f + i * 0.1f, remoteScalesMillis());
+  }
+}
+
+void test_sample_rate_stats() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  // Some drivers publish a zero on connect; start from nothing.
+  uint32_t atConnect = driver->getSampleRateStats().samples;
+  driver->resetSampleRateStats();
+  TEST_ASSERT_EQUAL_UINT32(0, driver->getSampleRateStats().samples);
+
+  // 10 Hz with a 300 ms hiccup every 20 samples, 100 samples in all.
+  scale.send(1.f, remoteScalesMillis());
+  for (int i = 0; i < 4; i++) {
+    sendEvery(scale, 100, 19);
+    sendEvery(scale, 300, 1);
+  }
+  sendEvery(scale, 100, 19);
+
+  SampleRateStats stats = driver->getSampleRateStats();
+  TEST_ASSERT_EQUAL_UINT32(100, stats.samples);
+  // 99 gaps over 95 * 100 + 4 * 300 ms.
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 99 * 1000.f / 10700, stats.effectiveHz);
+  TEST_ASSERT_FLOAT_WITHIN(1.f, 10.f, stats.recentHz);
+  // Histogram bins are at most 25 % wide and clamped to the observed range.
+  TEST_ASSERT_TRUE(stats.p50GapMs >= 100 && stats.p50GapMs <= 125);
+  TEST_ASSERT_EQUAL_UINT32(300, stats.p99GapMs);
+  TEST_ASSERT_EQUAL_UINT32(300, stats.maxGapMs);
+
+  // A reconnect starts over.
+  driver->disconnect();
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_EQUAL_UINT32(atConnect, driver->getSampleRateStats().samples);
+  driver->disconnect();
+}
+
+// A consumer that takes 250 us of simulated time per weight.
+static void slowConsumer(float) { clock_->advanceUs(250); }
+
+void test_latency_stats() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  driver->setWeightUpdatedCallback(slowConsumer);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  // Off by default.
+  sendEvery(scale, 100, 5);
+  TEST_ASSERT_EQUAL_UINT32(0, driver->getLatencyStats().notifications);
+
+  driver->setLatencyInstrumentation(true);
+  sendEvery(scale, 100, 20);
+  NotificationLatencyStats stats = driver->getLatencyStats();
+  TEST_ASSERT_EQUAL_UINT32(20, stats.notifications);
+  // Decoding takes no simulated time; the consumer all of it.
+  TEST_ASSERT_EQUAL_UINT32(0, stats.decodeMaxUs);
+  TEST_ASSERT_TRUE(stats.consumerP50Us >= 250 && stats.consumerP50Us <= 250 * 5 / 4);
+  TEST_ASSERT_EQUAL_UINT32(250, stats.consumerMaxUs);
+  TEST_ASSERT_EQUAL_UINT32(stats.consumerP99Us, stats.totalP99Us);
+  TEST_ASSERT_EQUAL_UINT32(250, stats.totalMaxUs);
+
+  driver->resetLatencyStats();
+  TEST_ASSERT_EQUAL_UINT32(0, driver->getLatencyStats().notifications);
+  driver->disconnect();
+}
+
+static void notifyRaw(VirtualScale& scale, std::vector<uint8_t> bytes) {
+  TEST_ASSERT_TRUE(scale.getWeightCharacteristic()->notify(bytes.data(), bytes.size()));
+}
+
+void test_health_counters_format() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  TEST_ASSERT_TRUE(driver->connect());
+  driver->resetHealthCounters();
+  TEST_ASSERT_EQUAL_STRING("ok=0 crc=0 drop=0 resync=0 unknown=0 malformed=0 reconnect=0 wfail=0 ddrop=0",
+    driver->formatHealthCounters().c_str());
+
+  notifyRaw(scale, { 0xFA, 0x01, 0x03, 0x00, 0x07, 0x3A, 0x3F });  // 18.5 g
+  notifyRaw(scale, { 0xFA, 0x01, 0x03, 0x00, 0x07, 0x3A, 0x00 });  // bad checksum, all 7 bytes dropped
+  notifyRaw(scale, { 0xFA, 0x55, 0x01, 0x00, 0x54 });              // type the driver does not know
+  notifyRaw(scale, { 0x00, 0x11, 0x22 });                          // no frame start at all
+
+  // The tare write fails.
+  scale.getPeripheral().getServices()[0]->getCharacteristics()[1]->failWrites = true;
+  TEST_ASSERT_TRUE(driver->tare());
+  driver->update();
+
+  TEST_ASSERT_EQUAL_STRING("ok=1 crc=1 drop=10 resync=2 unknown=1 malformed=0 reconnect=0 wfail=1 ddrop=0",
+    driver->formatHealthCounters().c_str());
+  driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_sample_rate_stats);
+  RUN_TEST(test_latency_stats);
+  RUN_TEST(test_health_counters_format);
+  return UNITY_END();
+}
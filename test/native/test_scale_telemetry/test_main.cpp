@@ -0,0 +1,70 @@
+#include <unity.h>
+#include <scale_telemetry.h>
+#include <vector>
+
+// ScaleTelemetryExporter to ScaleTelemetryDecoder over a byte stream, and
+// the decoder finding its way back after a damaged or truncated packet.
+
+struct ByteSink {
+  std::vector<uint8_t> bytes;
+  void write(const uint8_t* data, size_t length) { bytes.insert(bytes.end(), data, data + length); }
+};
+
+static std::vector<TelemetrySample> decoded;
+
+static void collect(const TelemetrySample& sample, void*) { decoded.push_back(sample); }
+
+// One packet of `count` samples from scale `scale`, starting at weight `grams`.
+static std::vector<uint8_t> packetOf(uint8_t scale, uint8_t count, float grams) {
+  ByteSink sink;
+  ScaleTelemetryExporter<ByteSink> exporter(sink);
+  for (uint8_t i = 0; i < count; i++) {
+    exporter.add({ scale, 1000u + i * 10u, grams + i, 1.5f });
+  }
+  exporter.poll(1000);
+  exporter.flush();
+  return sink.bytes;
+}
+
+void setUp() { decoded.clear(); }
+void tearDown() {}
+
+void test_samples_survive_any_split() {
+  std::vector<uint8_t> stream = packetOf(1, 3, 10.f);
+  ScaleTelemetryDecoder decoder(collect);
+  for (uint8_t byte : stream) decoder.feed(&byte, 1);
+
+  TEST_ASSERT_EQUAL_UINT32(3, decoded.size());
+  TEST_ASSERT_EQUAL_UINT8(1, decoded[2].scale);
+  TEST_ASSERT_EQUAL_UINT32(1020, decoded[2].timestampMs);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 12.f, decoded[2].weight);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.5f, decoded[2].flowRate);
+  TEST_ASSERT_EQUAL_UINT32(0, decoder.getBytesDiscarded());
+}
+
+void test_packet_inside_truncated_one_is_found() {
+  // The first packet is cut off after its header; the length it declares
+  // runs into the second, whole one.
+  std::vector<uint8_t> truncated = packetOf(1, 3, 10.f);
+  truncated.resize(scale_telemetry::HEADER_LENGTH + 3);
+  std::vector<uint8_t> whole = packetOf(2, 2, 20.f);
+  std::vector<uint8_t> stream = truncated;
+  stream.insert(stream.end(), whole.begin(), whole.end());
+
+  ScaleTelemetryDecoder decoder(collect);
+  decoder.feed(stream.data(), stream.size());
+
+  TEST_ASSERT_EQUAL_UINT32(1, decoder.getCrcErrors());
+  TEST_ASSERT_EQUAL_UINT32(1, decoder.getPackets());
+  TEST_ASSERT_EQUAL_UINT32(truncated.size(), decoder.getBytesDiscarded());
+  TEST_ASSERT_EQUAL_UINT32(2, decoded.size());
+  TEST_ASSERT_EQUAL_UINT8(2, decoded[0].scale);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 21.f, decoded[1].weight);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_samples_survive_any_split);
+  RUN_TEST(test_packet_inside_truncated_one_is_found);
+  return UNITY_END();
+}
@@ -0,0 +1,150 @@
+#include <unity.h>
+#include <shot_recorder.h>
+#include <virtual_scale.h>
+#include <cstdio>
+#include <vector>
+
+// ShotRecorder round trips: a replayed shot encoded and read back within
+// the 0.01 g quantisation, at the size the header promises; deltas that go
+// negative or wrap; and a full buffer refusing samples without corrupting
+// what it already holds.
+
+static const uint32_t START_MS = 1000000;
+static const float QUANTUM_ERROR = 0.005f + 1e-4f;
+
+// One sample every intervalMs of a 30 s shot, stopped at 26 s.
+static std::vector<ShotSample> replayShot(uint32_t intervalMs) {
+  ShotCurve shot(ShotProfile{}, 3);
+  shot.stopAt(26000);
+  std::vector<ShotSample> samples;
+  for (uint32_t ms = 0; ms <= 30000; ms += intervalMs) {
+    ShotSample sample;
+    sample.timestampMs = START_MS + ms;
+    sample.weight = shot.readingAt(ms);
+    sample.flowRate = shot.flowAt(ms);
+    samples.push_back(sample);
+  }
+  return samples;
+}
+
+template <size_t CAPACITY>
+static std::vector<ShotSample> readAll(const ShotRecorder<CAPACITY>& recorder) {
+  std::vector<ShotSample> samples;
+  auto reader = recorder.reader();
+  ShotSample sample;
+  while (reader.next(sample)) samples.push_back(sample);
+  return samples;
+}
+
+template <size_t CAPACITY>
+static float recordAndCompare(ShotRecorder<CAPACITY>& recorder, const std::vector<ShotSample>& played, bool flow) {
+  recorder.begin(flow);
+  for (const ShotSample& sample : played) TEST_ASSERT_TRUE(recorder.append(sample.timestampMs, sample.weight, sample.flowRate));
+  TEST_ASSERT_EQUAL_UINT32(played.size(), recorder.size());
+
+  std::vector<ShotSample> decoded = readAll(recorder);
+  TEST_ASSERT_EQUAL_UINT32(played.size(), decoded.size());
+  for (size_t i = 0; i < played.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT32(played[i].timestampMs, decoded[i].timestampMs);
+    TEST_ASSERT_FLOAT_WITHIN(QUANTUM_ERROR, played[i].weight, decoded[i].weight);
+    TEST_ASSERT_FLOAT_WITHIN(QUANTUM_ERROR, flow ? played[i].flowRate : 0.f, decoded[i].flowRate);
+  }
+  return float(recorder.bytesUsed()) / recorder.size();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_replayed_shot_round_trips_at_two_bytes_per_sample() {
+  static ShotRecorder<16384> recorder;
+  printf("\nbytes per sample\n%-8s %8s %8s\n", "rate", "weight", "+flow");
+  for (uint32_t intervalMs : { 100u, 50u }) {
+    std::vector<ShotSample> played = replayShot(intervalMs);
+    float weightOnly = recordAndCompare(recorder, played, false);
+    float withFlow = recordAndCompare(recorder, played, true);
+    printf("%-5u Hz %8.3f %8.3f\n", 1000 / intervalMs, weightOnly, withFlow);
+
+    // One byte of time, one of weight, one of flow; the first sample's
+    // absolute time is the only thing above that.
+    TEST_ASSERT_TRUE(weightOnly < 2.02f);
+    TEST_ASSERT_TRUE(withFlow < 3.02f);
+  }
+}
+
+void test_negative_and_wrapping_deltas_round_trip() {
+  static const ShotSample SAMPLES[] = {
+    { 0xFFFFFF00u, 250.f, 0.f },
+    { 0xFFFFFF80u, -0.01f, -3.5f },    // cup lifted off
+    { 0xFFFFFFF0u, -120.37f, 0.f },
+    { 0x00000010u, 0.f, 1.25f },       // millis() wrapped
+    { 0x00000020u, -199999.99f, 0.f },
+    { 0x00000030u, 199999.99f, -2.f },
+    { 0x00000028u, 18.5f, 0.f },       // out of order
+  };
+  ShotRecorder<256> recorder;
+  recorder.begin(true);
+  for (const ShotSample& sample : SAMPLES) TEST_ASSERT_TRUE(recorder.append(sample.timestampMs, sample.weight, sample.flowRate));
+
+  std::vector<ShotSample> decoded = readAll(recorder);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(SAMPLES) / sizeof(SAMPLES[0]), decoded.size());
+  for (size_t i = 0; i < decoded.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES[i].timestampMs, decoded[i].timestampMs);
+    // A float only holds 200 kg to about 0.02 g.
+    TEST_ASSERT_FLOAT_WITHIN(QUANTUM_ERROR + fabsf(SAMPLES[i].weight) * 1e-7f, SAMPLES[i].weight, decoded[i].weight);
+    TEST_ASSERT_FLOAT_WITHIN(QUANTUM_ERROR, SAMPLES[i].flowRate, decoded[i].flowRate);
+  }
+}
+
+void test_out_of_range_values_are_clamped() {
+  ShotRecorder<64> recorder;
+  recorder.begin();
+  TEST_ASSERT_TRUE(recorder.append(100, NAN));
+  TEST_ASSERT_TRUE(recorder.append(200, -INFINITY));
+  TEST_ASSERT_TRUE(recorder.append(300, 1e9f));
+
+  std::vector<ShotSample> decoded = readAll(recorder);
+  TEST_ASSERT_EQUAL_UINT32(3, decoded.size());
+  TEST_ASSERT_FLOAT_WITHIN(QUANTUM_ERROR, 0.f, decoded[0].weight);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, -200000.f, decoded[1].weight);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 200000.f, decoded[2].weight);
+}
+
+void test_full_buffer_refuses_and_counts() {
+  ShotRecorder<16> recorder;
+  recorder.begin();
+  // First sample: 3 bytes of time, 1 of weight; then 2 bytes each.
+  TEST_ASSERT_TRUE(recorder.append(START_MS, 0.f));
+  uint32_t accepted = 1, refused = 0;
+  for (uint32_t i = 1; i < 20; i++) {
+    if (recorder.append(START_MS + i * 100, i * 0.1f)) {
+      accepted++;
+    } else {
+      refused++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(7, accepted);
+  TEST_ASSERT_EQUAL_UINT32(16, recorder.bytesUsed());
+  TEST_ASSERT_EQUAL_UINT32(refused, recorder.droppedSamples());
+
+  // A refused sample leaves no trace: the recording still ends cleanly on
+  // the last accepted one.
+  std::vector<ShotSample> decoded = readAll(recorder);
+  TEST_ASSERT_EQUAL_UINT32(accepted, decoded.size());
+  TEST_ASSERT_EQUAL_UINT32(START_MS + 600, decoded.back().timestampMs);
+  TEST_ASSERT_FLOAT_WITHIN(QUANTUM_ERROR, 0.6f, decoded.back().weight);
+
+  // begin() starts over with an empty buffer.
+  recorder.begin();
+  TEST_ASSERT_EQUAL_UINT32(0, recorder.bytesUsed());
+  TEST_ASSERT_EQUAL_UINT32(0, recorder.droppedSamples());
+  TEST_ASSERT_EQUAL_UINT32(0, readAll(recorder).size());
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_replayed_shot_round_trips_at_two_bytes_per_sample);
+  RUN_TEST(test_negative_and_wrapping_deltas_round_trip);
+  RUN_TEST(test_out_of_range_values_are_clamped);
+  RUN_TEST(test_full_buffer_refuses_and_counts);
+  return UNITY_END();
+}
@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <virtual_scales.h>
+#include <seqlock.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Readers racing a writer through SeqLock and RemoteScales::getSnapshot():
+// every value read must be one whole write, never a mix of two. The writer
+// runs on its own thread; readers are the test thread and a deferred
+// subscriber on the dispatcher thread. SeqLock reads that raced a write are
+// counted to show the retry path was taken.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+// Wide enough that a copy takes a while; every word holds the same value.
+struct Wide {
+  uint32_t words[16];
+};
+
+void test_seqlock_reads_are_never_torn() {
+  SeqLock<Wide> lock;
+  std::atomic<bool> stop{ false };
+  std::thread writer([&] {
+    for (uint32_t value = 1; !stop; value++) {
+      Wide wide;
+      for (uint32_t& word : wide.words) word = value;
+      lock.write(wide);
+    }
+  });
+
+  // On one core a read only races a write when it is preempted, so read
+  // until enough have, or give up after a few seconds.
+  uint32_t reads = 0, raced = 0, torn = 0, last = 0;
+  bool monotonic = true;
+  auto end = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+  while (raced < 10 && std::chrono::steady_clock::now() < end) {
+    uint32_t versionBefore = lock.version();
+    Wide wide = lock.read();
+    if (lock.version() != versionBefore) raced++;
+    for (uint32_t word : wide.words) {
+      if (word != wide.words[0]) torn++;
+    }
+    if (wide.words[0] < last) monotonic = false;
+    last = wide.words[0];
+    reads++;
+  }
+  stop = true;
+  writer.join();
+
+  printf("\nseqlock: %u reads, %u raced a write, %u writes\n", reads, raced, lock.version());
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_TRUE(monotonic);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, raced);
+  TEST_ASSERT_EQUAL_UINT32(lock.version(), lock.read().words[0]);
+}
+
+// The writer sends weight k * 0.01 g at clock start + k ms for its k-th
+// sample, so a snapshot is whole exactly when its fields agree on k.
+static RemoteScales* driver_ = nullptr;
+static uint32_t firstSample = 0;
+static uint32_t startMs = 0;
+static std::atomic<uint32_t> deferredReads{ 0 };
+static std::atomic<uint32_t> deferredMismatches{ 0 };
+
+static bool isWhole(const ScaleSnapshot& snapshot) {
+  if (snapshot.sample <= firstSample) return true;
+  uint32_t k = snapshot.sample - firstSample;
+  return fabsf(snapshot.weight - k * 0.01f) < 0.005f && snapshot.sampleTimestampMs == startMs + k;
+}
+
+static void readOnDispatcher(const ScaleSnapshot& sample) {
+  if (!isWhole(sample) || !isWhole(driver_->getSnapshot())) deferredMismatches++;
+  deferredReads++;
+}
+
+void test_snapshot_fields_agree_under_concurrent_writes() {
+  const uint32_t SAMPLES = 20000;
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  driver_ = driver.get();
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_TRUE(driver->subscribeSamples(readOnDispatcher, { .dispatch = CallbackDispatch::LATEST_WINS }));
+  firstSample = driver->getSnapshot().sample;
+  startMs = remoteScalesMillis();
+
+  std::atomic<bool> done{ false };
+  std::thread writer([&] {
+    for (uint32_t k = 1; k <= SAMPLES; k++) {
+      clock_->advanceMs(1);
+      scale.send(k * 0.01f, remoteScalesMillis());
+    }
+    done = true;
+  });
+
+  uint32_t reads = 0, mismatches = 0;
+  while (!done) {
+    if (!isWhole(driver->getSnapshot())) mismatches++;
+    reads++;
+  }
+  writer.join();
+
+  ScaleSnapshot last = driver->getSnapshot();
+  TEST_ASSERT_EQUAL_UINT32(firstSample + SAMPLES, last.sample);
+  TEST_ASSERT_TRUE(isWhole(last));
+  for (int i = 0; i < 2000 && deferredReads == 0; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  printf("\nsnapshot: %u reads, %u on the dispatcher\n", reads, deferredReads.load());
+  TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+  TEST_ASSERT_EQUAL_UINT32(0, deferredMismatches.load());
+  TEST_ASSERT_GREATER_THAN_UINT32(0, deferredReads.load());
+  driver->disconnect();
+  driver_ = nullptr;
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_seqlock_reads_are_never_torn);
+  RUN_TEST(test_snapshot_fields_agree_under_concurrent_writes);
+  return UNITY_END();
+}
@@ -0,0 +1,121 @@
+#include <unity.h>
+#include <virtual_scales.h>
+
+// The stale-stream watchdog against a virtual scale that goes quiet without
+// dropping the link, plus the tare state it must not leave behind on reconnect.
+
+static const uint32_t FIRST_SAMPLE_GRACE_MS = 3000;
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+struct Connected {
+  std::unique_ptr<VirtualScale> scale;
+  std::unique_ptr<RemoteScales> driver;
+};
+
+template <typename Scale>
+static Connected connectTo(uint8_t missedIntervals, bool reconnect) {
+  Connected connected{ std::make_unique<Scale>(), nullptr };
+  connected.driver = discoverDriver(*connected.scale);
+  TEST_ASSERT_NOT_NULL(connected.driver.get());
+  connected.driver->setStaleWatchdog(missedIntervals, reconnect);
+  TEST_ASSERT_TRUE(connected.driver->connect());
+  connected.driver->update();
+  return connected;
+}
+
+static void stream(Connected& connected, int samples) {
+  for (int i = 0; i < samples; i++) {
+    clock_->advanceMs(100);
+    connected.scale->send(18.5f, remoteScalesMillis());
+    connected.driver->update();
+  }
+}
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_placeholder_zero_does_not_end_first_sample_grace() {
+  Connected connected = connectTo<VariaVirtualScale>(3, false);
+  clock_->advanceMs(1000);
+  connected.driver->update();
+  TEST_ASSERT_FALSE(connected.driver->isStale());
+
+  clock_->advanceMs(FIRST_SAMPLE_GRACE_MS);
+  connected.driver->update();
+  TEST_ASSERT_TRUE(connected.driver->isStale());
+  connected.driver->disconnect();
+}
+
+void test_stream_goes_stale_after_missed_intervals() {
+  Connected connected = connectTo<VariaVirtualScale>(3, false);
+  stream(connected, 10);
+  TEST_ASSERT_FALSE(connected.driver->isStale());
+
+  // Other tasks see it go stale from the published threshold, between updates.
+  clock_->advanceMs(400);
+  TEST_ASSERT_TRUE(connected.driver->isStale());
+  connected.driver->update();
+  TEST_ASSERT_TRUE(connected.driver->isStale());
+  TEST_ASSERT_EQUAL_UINT32(400, connected.driver->getStreamAgeMs());
+
+  stream(connected, 1);
+  TEST_ASSERT_FALSE(connected.driver->isStale());
+  connected.driver->disconnect();
+  TEST_ASSERT_FALSE(connected.driver->isStale());
+}
+
+void test_stale_stream_reconnects_from_update() {
+  Connected connected = connectTo<VariaVirtualScale>(3, true);
+  stream(connected, 10);
+  clock_->advanceMs(400);
+  connected.driver->update();
+  TEST_ASSERT_EQUAL_UINT32(1, connected.driver->getHealthCounters().reconnects);
+  TEST_ASSERT_TRUE(connected.driver->isConnected());
+  TEST_ASSERT_FALSE(connected.driver->isStale());
+  connected.driver->disconnect();
+}
+
+void test_disconnect_does_not_run_watchdog() {
+  // Decent flushes its display-off write from disconnect() through the
+  // command queue, which must not turn into a watchdog reconnect.
+  Connected connected = connectTo<DecentVirtualScale>(3, true);
+  clock_->advanceMs(FIRST_SAMPLE_GRACE_MS + 1);
+  connected.driver->disconnect();
+  TEST_ASSERT_EQUAL_UINT32(0, connected.driver->getHealthCounters().reconnects);
+  TEST_ASSERT_EQUAL_UINT32(0, NimBLEDevice::getClientListSize());
+}
+
+void test_pending_tare_fails_with_connection() {
+  Connected connected = connectTo<VariaVirtualScale>(0, false);
+  // The tare goes out but no sample follows to confirm it.
+  TEST_ASSERT_TRUE(connected.driver->tare());
+  connected.driver->update();
+  TEST_ASSERT_EQUAL(TareState::PENDING, connected.driver->getTareState());
+
+  connected.driver->disconnect();
+  TEST_ASSERT_EQUAL(TareState::FAILED, connected.driver->getTareState());
+  TEST_ASSERT_TRUE(connected.driver->connect());
+  connected.driver->update();
+  TEST_ASSERT_EQUAL(TareState::FAILED, connected.driver->getTareState());
+  TEST_ASSERT_EQUAL_UINT32(1, connected.driver->getTareLatencyStats().failed);
+  connected.driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_placeholder_zero_does_not_end_first_sample_grace);
+  RUN_TEST(test_stream_goes_stale_after_missed_intervals);
+  RUN_TEST(test_stale_stream_reconnects_from_update);
+  RUN_TEST(test_disconnect_does_not_run_watchdog);
+  RUN_TEST(test_pending_tare_fails_with_connection);
+  return UNITY_END();
+}
@@ -0,0 +1,200 @@
+#include <unity.h>
+#include <virtual_scales.h>
+#include <target_weight_predictor.h>
+#include <algorithm>
+
+// Final-weight error of TargetWeightPredictor over replayed shots: a virtual
+// scale plays a ShotCurve, the predictor decides from the connected driver,
+// and the curve stops the pump after the machine's delay so its analytic
+// final weight is where the shot really ends. The distribution is printed for
+// comparison between changes; the assertions hold loose bounds on it.
+
+static const float TARGET_GRAMS = 36.f;
+static const uint32_t MACHINE_STOP_DELAY_MS = 200;
+static const uint32_t SHOT_LIMIT_MS = 60000;
+static const int SHOTS_PER_PROFILE = 20;
+static const int LEARNING_SHOTS = 5;
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+struct ErrorDistribution {
+  float mean;
+  float p50;
+  float p90;
+  float max;
+};
+
+// Percentiles are of the absolute error; the mean keeps the sign, so a
+// systematic overshoot shows there.
+static ErrorDistribution distributionOf(std::vector<float> errors) {
+  float sum = 0.f;
+  for (float& error : errors) {
+    sum += error;
+    error = fabsf(error);
+  }
+  std::sort(errors.begin(), errors.end());
+  auto at = [&](float quantile) { return errors[static_cast<size_t>(quantile * (errors.size() - 1) + 0.5f)]; };
+  return { sum / errors.size(), at(0.5f), at(0.9f), errors.back() };
+}
+
+// Plays one shot against the predictor; returns final weight minus target.
+static float playOne(VirtualScale& scale, RemoteScales& driver, TargetWeightPredictor& predictor, const ShotProfile& profile,
+  uint32_t seed) {
+  ShotCurve shot(profile, seed);
+  predictor.begin(TARGET_GRAMS);
+  uint32_t settledAtMs = SHOT_LIMIT_MS;
+  scale.playShot(shot, SHOT_LIMIT_MS, *clock_, [&](uint32_t elapsedMs) {
+    driver.update();
+    if (predictor.update(driver, remoteScalesMillis())) {
+      shot.stopAt(elapsedMs + MACHINE_STOP_DELAY_MS);
+      settledAtMs = elapsedMs + MACHINE_STOP_DELAY_MS + 5 * profile.dripMs;
+    }
+    return elapsedMs < settledAtMs;
+  });
+  TEST_ASSERT_TRUE_MESSAGE(predictor.hasFired(), "shot never reached its target");
+  predictor.finish(shot.finalWeight());
+  return shot.finalWeight() - TARGET_GRAMS;
+}
+
+static ErrorDistribution replayShots(VirtualScale& scale, RemoteScales& driver, const char* name) {
+  static const ShotProfile PROFILES[] = {
+    { .peakFlow = 1.2f },
+    { .peakFlow = 2.0f },
+    { .preinfusionMs = 2000, .peakFlow = 3.0f, .rampMs = 1500, .dripMs = 1800, .noise = 0.08f },
+  };
+
+  TargetWeightPredictor predictor;
+  predictor.setMachineStopDelayMs(MACHINE_STOP_DELAY_MS);
+  std::vector<float> learned;
+  printf("\n%-8s %-6s %8s %8s %8s %8s\n", name, "flow", "mean", "p50", "p90", "max");
+  for (const ShotProfile& profile : PROFILES) {
+    std::vector<float> errors;
+    for (int shot = 0; shot < SHOTS_PER_PROFILE; shot++) {
+      float error = playOne(scale, driver, predictor, profile, 1 + shot);
+      errors.push_back(error);
+      if (shot >= LEARNING_SHOTS) learned.push_back(error);
+    }
+    ErrorDistribution all = distributionOf(errors);
+    printf("%-8s %-6.1f %8.3f %8.3f %8.3f %8.3f\n", "", profile.peakFlow, all.mean, all.p50, all.p90, all.max);
+  }
+  ErrorDistribution result = distributionOf(learned);
+  printf("%-8s %-6s %8.3f %8.3f %8.3f %8.3f  (after %d learning shots)\n", "", "all", result.mean, result.p50, result.p90,
+    result.max, LEARNING_SHOTS);
+  return result;
+}
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_final_weight_error_with_decode_timestamps() {
+  VariaVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  driver->setFlowEstimation(true);
+  driver->setLatencyInstrumentation(true);
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_FALSE(driver->hasScaleTimer());
+
+  ErrorDistribution errors = replayShots(scale, *driver, "varia");
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 0.f, errors.mean);
+  TEST_ASSERT_TRUE(errors.p90 < 1.f);
+  driver->disconnect();
+}
+
+void test_final_weight_error_with_scale_clock() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  driver->setFlowEstimation(true);
+  driver->setLatencyInstrumentation(true);
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_TRUE(driver->hasScaleTimer());
+
+  ErrorDistribution errors = replayShots(scale, *driver, "bookoo");
+  TEST_ASSERT_TRUE(driver->isScaleClockSynchronized());
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 0.f, errors.mean);
+  TEST_ASSERT_TRUE(errors.p90 < 1.f);
+  driver->disconnect();
+}
+
+void test_link_delay_is_compensated_without_scale_clock() {
+  // A slow link: 300 ms connection interval, so notifications wait 150 ms on
+  // average for their connection event.
+  VariaVirtualScale scale;
+  scale.getPeripheral().connInterval = 240;
+  scale.getPeripheral().acceptsParamUpdates = false;
+  VirtualScaleOptions options;
+  options.deliveryDelayMs = 150;
+  scale.setOptions(options);
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  driver->setFlowEstimation(true);
+  TEST_ASSERT_TRUE(driver->connect());
+  TEST_ASSERT_EQUAL_UINT16(240, driver->getConnectionParams().interval);
+
+  // No drip and no noise, so a first shot with nothing learned lands on the
+  // target only if the delay is accounted for.
+  const ShotProfile steady{ .peakFlow = 2.f, .dripMs = 1, .noise = 0.f };
+  TargetWeightPredictor compensated;
+  compensated.setMachineStopDelayMs(MACHINE_STOP_DELAY_MS);
+  float error = playOne(scale, *driver, compensated, steady, 1);
+  printf("\nlink delay 150 ms: compensated %+.3f g", error);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.f, error);
+
+  TargetWeightPredictor uncompensated;
+  uncompensated.setMachineStopDelayMs(MACHINE_STOP_DELAY_MS);
+  uncompensated.setNotificationLatencyMs(0);
+  error = playOne(scale, *driver, uncompensated, steady, 1);
+  printf(", uncompensated %+.3f g\n", error);
+  TEST_ASSERT_TRUE(error > 0.2f);
+  driver->disconnect();
+}
+
+static float predicted = 0.f;
+static void recordPrediction(float weight) { predicted = weight; }
+
+void test_scale_clock_age_is_not_counted_twice() {
+  BookooVirtualScale scale;
+  std::unique_ptr<RemoteScales> driver = discoverDriver(scale);
+  driver->setLatencyInstrumentation(true);
+  TEST_ASSERT_TRUE(driver->connect());
+
+  // Every frame reaches us 100 ms after the scale weighed it, except the
+  // first few, which set the clock offset at the minimum delay of 30 ms.
+  uint32_t scaleStartMs = remoteScalesMillis();
+  scale.setFlow(2.f);
+  for (uint32_t i = 0; i < 40; i++) {
+    clock_->advanceMs(100);
+    uint32_t delayMs = i < 5 ? 30 : 100;
+    scale.send(10.f + i * 0.2f, remoteScalesMillis() - scaleStartMs - delayMs);
+    driver->update();
+  }
+  TEST_ASSERT_TRUE(driver->isScaleClockSynchronized());
+  uint32_t ageMs = remoteScalesMillis() - driver->getSampleTimestampMs();
+  TEST_ASSERT_UINT32_WITHIN(5, 70, ageMs);
+
+  // The projection leads by the sample's age and the stop delay, nothing on top.
+  TargetWeightPredictor predictor;
+  predictor.setStopCallback(recordPrediction);
+  predictor.setMachineStopDelayMs(MACHINE_STOP_DELAY_MS);
+  predictor.begin(5.f);
+  TEST_ASSERT_TRUE(predictor.update(*driver, remoteScalesMillis()));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.f, driver->getFlowRate());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, driver->getWeight() + driver->getFlowRate() * (ageMs + MACHINE_STOP_DELAY_MS) / 1000.f,
+    predicted);
+  driver->disconnect();
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+  UNITY_BEGIN();
+  RUN_TEST(test_final_weight_error_with_decode_timestamps);
+  RUN_TEST(test_final_weight_error_with_scale_clock);
+  RUN_TEST(test_link_delay_is_compensated_without_scale_clock);
+  RUN_TEST(test_scale_clock_age_is_not_counted_twice);
+  return UNITY_END();
+}
@@ -0,0 +1,180 @@
+#include <unity.h>
+#include <virtual_scales.h>
+
+// Every driver against its virtual scale: values across the range and sign,
+// a whole shot at the scale's rate and at ten times that, fragmented and
+// damaged streams, and the tare round trip.
+
+static SimulatedRemoteScalesClock* clock_ = nullptr;
+
+struct Connected {
+  std::unique_ptr<VirtualScale> scale;
+  std::unique_ptr<RemoteScales> driver;
+};
+
+static std::vector<Connected> connectAll() {
+  std::vector<Connected> all;
+  for (std::unique_ptr<VirtualScale>& scale : makeAllVirtualScales()) {
+    std::unique_ptr<RemoteScales> driver = discoverDriver(*scale);
+    std::string name = scale->getPeripheral().advertisement().getName();
+    TEST_ASSERT_NOT_NULL_MESSAGE(driver.get(), name.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(driver->connect(), name.c_str());
+    driver->update();
+    all.push_back({ std::move(scale), std::move(driver) });
+  }
+  return all;
+}
+
+static std::string nameOf(const Connected& connected) { return connected.driver->getDeviceName(); }
+
+// Weight resolution of each protocol, in grams.
+static float resolutionOf(const Connected& connected) {
+  std::string name = nameOf(connected);
+  if (name == "ECLAIR-1234" || name == "my_scale") return 0.001f;
+  if (name == "LUNAR-1234" || name == "BOOKOO_SC 1234" || name == "FELICITA" || name == "AKU MINI SCALE" || name == "WeighMyBru") return 0.01f;
+  return 0.1f;
+}
+
+// Decent puts exactly one frame in each notification and does not
+// reassemble; splitting its frames is not something the scale does.
+static bool reassembles(const Connected& connected) { return nameOf(connected) != "Decent Scale"; }
+
+void setUp() {
+  clock_ = new SimulatedRemoteScalesClock(1000000);
+  RemoteScalesClock::setInstance(clock_);
+}
+
+void tearDown() {
+  RemoteScalesClock::setInstance(nullptr);
+  delete clock_;
+}
+
+void test_frames_decode_across_range_and_sign() {
+  const float values[] = { 0.f, 18.5f, -3.2f, 123.4f, 2.f };
+  for (Connected& connected : connectAll()) {
+    for (float grams : values) {
+      TEST_ASSERT_TRUE_MESSAGE(connected.scale->send(grams, 0), nameOf(connected).c_str());
+      TEST_ASSERT_FLOAT_WITHIN_MESSAGE(resolutionOf(connected) / 2 + 1e-4f, grams, connected.driver->getWeight(), nameOf(connected).c_str());
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(5, connected.driver->getHealthCounters().framesOk, nameOf(connected).c_str());
+    connected.driver->disconnect();
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, NimBLEDevice::getClientListSize());
+}
+
+static void playShotAt(uint32_t rateHz) {
+  for (Connected& connected : connectAll()) {
+    ShotCurve shot;
+    shot.stopAt(25000);
+    connected.scale->setOptions({ .rateHz = rateHz });
+    uint32_t startMs = remoteScalesMillis();
+    float maxError = 0.f;
+    uint32_t frames = connected.scale->playShot(shot, 30000, *clock_, [&](uint32_t elapsedMs) {
+      connected.driver->update();
+      maxError = std::max(maxError, std::abs(connected.driver->getWeight() - shot.trueWeightAt(elapsedMs)));
+      return true;
+    });
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(30 * rateHz + 1, frames, nameOf(connected).c_str());
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(frames, connected.driver->getHealthCounters().framesOk, nameOf(connected).c_str());
+    TEST_ASSERT_TRUE_MESSAGE(maxError < shot.getProfile().noise + resolutionOf(connected), nameOf(connected).c_str());
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(shot.getProfile().noise + resolutionOf(connected), shot.trueWeightAt(30000), connected.driver->getWeight(), nameOf(connected).c_str());
+    TEST_ASSERT_UINT32_WITHIN_MESSAGE(1000 / rateHz, 30000, remoteScalesMillis() - startMs, nameOf(connected).c_str());
+    connected.driver->disconnect();
+  }
+}
+
+void test_shot_at_scale_rate() { playShotAt(10); }
+void test_shot_at_ten_times_scale_rate() { playShotAt(100); }
+
+void test_fragmented_stream_reassembles() {
+  for (Connected& connected : connectAll()) {
+    if (!reassembles(connected)) {
+      connected.driver->disconnect();
+      continue;
+    }
+    ShotCurve shot;
+    connected.scale->setOptions({ .rateHz = 10, .maxFragmentLength = 3, .seed = 7 });
+    uint32_t frames = connected.scale->playShot(shot, 20000, *clock_);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(frames, connected.driver->getHealthCounters().framesOk, nameOf(connected).c_str());
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(shot.getProfile().noise + resolutionOf(connected), shot.trueWeightAt(20000), connected.driver->getWeight(), nameOf(connected).c_str());
+    connected.driver->disconnect();
+  }
+}
+
+void test_damaged_frames_are_not_decoded_as_valid() {
+  // Protocols whose frames carry a checksum the driver verifies.
+  const char* checked[] = { "LUNAR-1234", "BOOKOO_SC 1234", "Microbalance", "ECLAIR-1234", "AKU MINI SCALE", "WeighMyBru" };
+  for (Connected& connected : connectAll()) {
+    bool verifies = false;
+    for (const char* name : checked) verifies |= nameOf(connected) == name;
+    if (!verifies) {
+      connected.driver->disconnect();
+      continue;
+    }
+    ShotCurve shot;
+    connected.scale->setOptions({ .rateHz = 10, .errorRate = 0.5f, .seed = 3 });
+    uint32_t frames = connected.scale->playShot(shot, 20000, *clock_);
+    ScaleHealthCounters health = connected.driver->getHealthCounters();
+    TEST_ASSERT_TRUE_MESSAGE(health.framesOk < frames, nameOf(connected).c_str());
+    TEST_ASSERT_TRUE_MESSAGE(health.framesOk > frames / 4, nameOf(connected).c_str());
+    TEST_ASSERT_TRUE_MESSAGE(health.checksumFailures + health.resyncs > 0, nameOf(connected).c_str());
+    connected.driver->disconnect();
+  }
+}
+
+void test_tare_zeroes_the_scale() {
+  for (Connected& connected : connectAll()) {
+    connected.scale->send(250.f, 0);
+    TEST_ASSERT_TRUE_MESSAGE(connected.driver->tare(), nameOf(connected).c_str());
+    for (int i = 0; i < 10; i++) {
+      connected.driver->update();
+      clock_->advanceMs(100);
+    }
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, connected.scale->getTares(), nameOf(connected).c_str());
+    connected.scale->send(250.f, 1000);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(resolutionOf(connected), 0.f, connected.driver->getWeight(), nameOf(connected).c_str());
+    connected.driver->disconnect();
+  }
+}
+
+void test_shot_curve_shape() {
+  ShotCurve shot(ShotProfile{ .noise = 0.f });
+  TEST_ASSERT_EQUAL_FLOAT(0.f, shot.trueWeightAt(4000));
+  float previous = 0.f;
+  for (uint32_t ms = 0; ms <= 30000; ms += 100) {
+    TEST_ASSERT_TRUE(shot.trueWeightAt(ms) >= previous);
+    previous = shot.trueWeightAt(ms);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 2.f, shot.flowAt(25000));
+
+  shot.stopAt(28000);
+  float atStop = shot.trueWeightAt(28000);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, atStop + shot.flowAt(28000) * 1.2f, shot.finalWeight());
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, shot.finalWeight(), shot.trueWeightAt(40000));
+}
+
+void test_recorded_stream_matches_played_frames() {
+  AcaiaVirtualScale scale;
+  ShotCurve shot;
+  scale.setOptions({ .rateHz = 10, .maxFragmentLength = 4, .seed = 5 });
+  VirtualScaleStream stream = scale.record(shot, 10000);
+  TEST_ASSERT_EQUAL(101, stream.frames);
+  TEST_ASSERT_EQUAL(101 * 13, stream.bytes.size());
+  TEST_ASSERT_TRUE(stream.pieceEnds.size() > stream.frames);
+  TEST_ASSERT_EQUAL(stream.bytes.size(), stream.pieceEnds.back());
+}
+
+int main(int argc, char** argv) {
+  applyAllScalePlugins();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_decode_across_range_and_sign);
+  RUN_TEST(test_shot_at_scale_rate);
+  RUN_TEST(test_shot_at_ten_times_scale_rate);
+  RUN_TEST(test_fragmented_stream_reassembles);
+  RUN_TEST(test_damaged_frames_are_not_decoded_as_valid);
+  RUN_TEST(test_tare_zeroes_the_scale);
+  RUN_TEST(test_shot_curve_shape);
+  RUN_TEST(test_recorded_stream_matches_played_frames);
+  return UNITY_END();
+}
@@ -0,0 +1,439 @@
+#pragma once
+#include <cctype>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+// Host stand-in for the parts of NimBLE-Arduino 1.4 this library uses, so the
+// core and every driver build and run natively. The remote-side classes keep
+// the real signatures; on top of them a NimBLEFakePeripheral describes the
+// scale at the other end of the link: its GATT table, how it answers
+// connection parameter requests, and the notifications it sends.
+//
+//   NimBLEFakePeripheral scale("aa:bb:cc:dd:ee:01", "BOOKOO_SC 1234");
+//   auto* weight = scale.addService(NimBLEUUID("0FFE"))->addCharacteristic(NimBLEUUID("FF11"));
+//   NimBLEDevice::addPeripheral(&scale);
+//   ... connect a driver ...
+//   weight->notify(frame, sizeof(frame));
+//
+// Everything runs on the calling thread: notify() calls the subscriber before
+// it returns, much as the NimBLE host task would.
+
+class NimBLEUUID {
+public:
+  NimBLEUUID() {}
+  NimBLEUUID(const std::string& uuid) : value(normalise(uuid)) {}
+  NimBLEUUID(const char* uuid) : NimBLEUUID(std::string(uuid)) {}
+  NimBLEUUID(uint16_t uuid) : value(expand(uuid)) {}
+
+  // Like NimBLE, 16-bit and 128-bit forms of the same UUID compare equal.
+  bool equals(const NimBLEUUID& other) const { return value == other.value; }
+  bool operator==(const NimBLEUUID& other) const { return equals(other); }
+  bool operator!=(const NimBLEUUID& other) const { return !equals(other); }
+  std::string toString() const { return value; }
+
+private:
+  std::string value;
+
+  static std::string expand(uint32_t shortUuid) {
+    char text[37];
+    snprintf(text, sizeof(text), "%08x-0000-1000-8000-00805f9b34fb", (unsigned)shortUuid);
+    return text;
+  }
+
+  static std::string normalise(const std::string& uuid) {
+    std::string lower;
+    for (char c : uuid) lower += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    if (lower.rfind("0x", 0) == 0) lower = lower.substr(2);
+    if (lower.size() == 4 || lower.size() == 8) return expand(static_cast<uint32_t>(strtoul(lower.c_str(), nullptr, 16)));
+    return lower;
+  }
+};
+
+class NimBLEAddress {
+public:
+  NimBLEAddress() {}
+  NimBLEAddress(const std::string& address) {
+    unsigned bytes[6] = {};
+    sscanf(address.c_str(), "%x:%x:%x:%x:%x:%x", &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5]);
+    // NimBLE keeps the native form least significant byte first.
+    for (int i = 0; i < 6; i++) native[i] = static_cast<uint8_t>(bytes[5 - i]);
+  }
+
+  const uint8_t* getNative() const { return native; }
+  std::string toString() const {
+    char text[18];
+    snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x", native[5], native[4], native[3], native[2], native[1], native[0]);
+    return text;
+  }
+  bool operator==(const NimBLEAddress& other) const { return memcmp(native, other.native, sizeof(native)) == 0; }
+  bool operator!=(const NimBLEAddress& other) const { return !(*this == other); }
+
+private:
+  uint8_t native[6] = {};
+};
+
+class NimBLEAdvertisedDevice {
+public:
+  NimBLEAdvertisedDevice(const std::string& name, const NimBLEAddress& address, const std::string& manufacturerData = "", int rssi = -60)
+    : name(name), address(address), manufacturerData(manufacturerData), rssi(rssi) {}
+
+  std::string getName() { return name; }
+  NimBLEAddress getAddress() { return address; }
+  std::string getManufacturerData() { return manufacturerData; }
+  int getRSSI() { return rssi; }
+
+private:
+  std::string name;
+  NimBLEAddress address;
+  std::string manufacturerData;
+  int rssi;
+};
+
+class NimBLERemoteDescriptor {
+public:
+  explicit NimBLERemoteDescriptor(const NimBLEUUID& uuid) : uuid(uuid) {}
+
+  NimBLEUUID getUUID() const { return uuid; }
+  bool writeValue(const uint8_t* data, size_t length, bool response = false) {
+    if (failWrites) return false;
+    writes.emplace_back(data, data + length);
+    return true;
+  }
+
+  // Stand-in only.
+  std::vector<std::vector<uint8_t>> writes;
+  bool failWrites = false;
+
+private:
+  NimBLEUUID uuid;
+};
+
+class NimBLERemoteCharacteristic {
+public:
+  using notify_callback = std::function<void(NimBLERemoteCharacteristic*, uint8_t*, size_t, bool)>;
+
+  NimBLERemoteCharacteristic(const NimBLEUUID& uuid, bool notify, bool indicate)
+    : uuid(uuid), notifiable(notify), indicatable(indicate) {
+    // Sized for the largest ATT payload, so notify() itself never allocates.
+    received.reserve(512);
+  }
+
+  NimBLEUUID getUUID() const { return uuid; }
+  bool canNotify() const { return notifiable; }
+  bool canIndicate() const { return indicatable; }
+
+  NimBLERemoteDescriptor* getDescriptor(const NimBLEUUID& descriptorUuid) {
+    for (auto& descriptor : descriptors) {
+      if (descriptor->getUUID() == descriptorUuid) return descriptor.get();
+    }
+    return nullptr;
+  }
+
+  bool writeValue(const uint8_t* data, size_t length, bool response = false) {
+    if (failWrites) return false;
+    writes.emplace_back(data, data + length);
+    if (onWrite) onWrite(data, length);
+    return true;
+  }
+
+  bool subscribe(bool notifications = true, notify_callback callback = nullptr, bool response = false) {
+    if (notifications ? !notifiable : !indicatable) return false;
+    subscriber = callback;
+    return true;
+  }
+
+  bool unsubscribe(bool response = false) {
+    subscriber = nullptr;
+    return true;
+  }
+
+  // Stand-in only: the peripheral side.
+
+  NimBLERemoteDescriptor* addDescriptor(const NimBLEUUID& descriptorUuid) {
+    descriptors.push_back(std::make_unique<NimBLERemoteDescriptor>(descriptorUuid));
+    return descriptors.back().get();
+  }
+
+  bool isSubscribed() const { return subscriber != nullptr; }
+
+  // Delivers one notification to the subscriber, on a private copy since
+  // drivers are allowed to decode in place. False when nobody is subscribed.
+  bool notify(const uint8_t* data, size_t length) {
+    if (!subscriber) return false;
+    received.assign(data, data + length);
+    subscriber(this, received.data(), length, notifiable);
+    return true;
+  }
+
+  std::vector<std::vector<uint8_t>> writes;
+  bool failWrites = false;
+  // Lets a simulated scale react to commands, e.g. zero itself on a tare.
+  std::function<void(const uint8_t* data, size_t length)> onWrite;
+
+private:
+  NimBLEUUID uuid;
+  bool notifiable;
+  bool indicatable;
+  std::vector<std::unique_ptr<NimBLERemoteDescriptor>> descriptors;
+  notify_callback subscriber;
+  std::vector<uint8_t> received;
+};
+
+class NimBLERemoteService {
+public:
+  explicit NimBLERemoteService(const NimBLEUUID& uuid) : uuid(uuid) {}
+
+  NimBLEUUID getUUID() const { return uuid; }
+  NimBLERemoteCharacteristic* getCharacteristic(const NimBLEUUID& characteristicUuid) {
+    for (auto& characteristic : characteristics) {
+      if (characteristic->getUUID() == characteristicUuid) return characteristic.get();
+    }
+    return nullptr;
+  }
+
+  // Stand-in only.
+  NimBLERemoteCharacteristic* addCharacteristic(const NimBLEUUID& characteristicUuid, bool notify = true, bool indicate = false) {
+    characteristics.push_back(std::make_unique<NimBLERemoteCharacteristic>(characteristicUuid, notify, indicate));
+    return characteristics.back().get();
+  }
+  std::vector<std::unique_ptr<NimBLERemoteCharacteristic>>& getCharacteristics() { return characteristics; }
+
+private:
+  NimBLEUUID uuid;
+  std::vector<std::unique_ptr<NimBLERemoteCharacteristic>> characteristics;
+};
+
+class NimBLEConnInfo {
+public:
+  NimBLEConnInfo(uint16_t interval = 0, uint16_t latency = 0, uint16_t timeout = 0, uint16_t mtu = 23)
+    : interval(interval), latency(latency), timeout(timeout), mtu(mtu) {}
+
+  uint16_t getConnInterval() const { return interval; }
+  uint16_t getConnLatency() const { return latency; }
+  uint16_t getConnTimeout() const { return timeout; }
+  uint16_t getMTU() const { return mtu; }
+
+private:
+  uint16_t interval;
+  uint16_t latency;
+  uint16_t timeout;
+  uint16_t mtu;
+};
+
+// The scale at the other end of the link. Owns its GATT table; register it
+// with NimBLEDevice::addPeripheral() before a client connects to its address.
+class NimBLEFakePeripheral {
+public:
+  NimBLEFakePeripheral(const std::string& address, const std::string& name, const std::string& manufacturerData = "")
+    : address(address), name(name), manufacturerData(manufacturerData) {}
+
+  NimBLERemoteService* addService(const NimBLEUUID& uuid) {
+    services.push_back(std::make_unique<NimBLERemoteService>(uuid));
+    return services.back().get();
+  }
+  NimBLERemoteService* getService(const NimBLEUUID& uuid) {
+    for (auto& service : services) {
+      if (service->getUUID() == uuid) return service.get();
+    }
+    return nullptr;
+  }
+  std::vector<std::unique_ptr<NimBLERemoteService>>& getServices() { return services; }
+
+  NimBLEAdvertisedDevice advertisement() const { return NimBLEAdvertisedDevice(name, address, manufacturerData, rssi); }
+  const NimBLEAddress& getAddress() const { return address; }
+
+  // Drops every subscription, as the link going away would.
+  void clearSubscriptions() {
+    for (auto& service : services) {
+      for (auto& characteristic : service->getCharacteristics()) characteristic->unsubscribe();
+    }
+  }
+
+  bool connectable = true;
+  bool secureConnections = true;
+  int rssi = -60;
+  // Connection parameters, in NimBLE units. A non-zero interval is what this
+  // peripheral insists on after connecting, whatever the central asked for;
+  // zero takes the central's choice. acceptsParamUpdates decides whether a
+  // later updateConnParams() is honoured.
+  uint16_t connInterval = 0;
+  bool acceptsParamUpdates = true;
+  // Cleared to simulate the link dying without a disconnect event.
+  bool linkUp = true;
+
+private:
+  NimBLEAddress address;
+  std::string name;
+  std::string manufacturerData;
+  std::vector<std::unique_ptr<NimBLERemoteService>> services;
+};
+
+class NimBLEClient {
+public:
+  explicit NimBLEClient(const NimBLEAddress& peerAddress) : peerAddress(peerAddress) {}
+
+  // As in NimBLE: the initial parameters used by the next connect().
+  void setConnectionParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout,
+    uint16_t scanInterval = 16, uint16_t scanWindow = 16) {
+    requestedMaxInterval = maxInterval;
+    connLatency = latency;
+    connTimeout = timeout;
+  }
+
+  bool connect(bool deleteAttributes = true);
+
+  bool isConnected() const { return peripheral != nullptr && peripheral->linkUp; }
+  bool disconnect(uint8_t reason = 0x13) {
+    if (peripheral != nullptr) peripheral->clearSubscriptions();
+    peripheral = nullptr;
+    return true;
+  }
+
+  NimBLERemoteService* getService(const NimBLEUUID& uuid) {
+    return isConnected() ? peripheral->getService(uuid) : nullptr;
+  }
+
+  void updateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+    paramUpdateRequests++;
+    if (!isConnected() || !peripheral->acceptsParamUpdates) return;
+    connInterval = maxInterval;
+    connLatency = latency;
+    connTimeout = timeout;
+  }
+
+  NimBLEConnInfo getConnInfo() const { return NimBLEConnInfo(connInterval, connLatency, connTimeout); }
+  int getRssi() const { return isConnected() ? peripheral->rssi : 0; }
+  bool secureConnection() const { return isConnected() && peripheral->secureConnections; }
+  NimBLEAddress getPeerAddress() const { return peerAddress; }
+
+  // Stand-in only.
+  uint32_t paramUpdateRequests = 0;
+
+private:
+  NimBLEAddress peerAddress;
+  NimBLEFakePeripheral* peripheral = nullptr;
+  uint16_t requestedMaxInterval = 0;
+  uint16_t connInterval = 0;
+  uint16_t connLatency = 0;
+  uint16_t connTimeout = 0;
+};
+
+class NimBLEAdvertisedDeviceCallbacks {
+public:
+  virtual ~NimBLEAdvertisedDeviceCallbacks() {}
+  virtual void onResult(NimBLEAdvertisedDevice* advertisedDevice) = 0;
+};
+
+class NimBLEScan {
+public:
+  void setAdvertisedDeviceCallbacks(NimBLEAdvertisedDeviceCallbacks* callbacks, bool wantDuplicates = false) { this->callbacks = callbacks; }
+  void setInterval(uint16_t intervalMs) {}
+  void setWindow(uint16_t windowMs) {}
+  void setMaxResults(uint8_t maxResults) {}
+  void setDuplicateFilter(bool enabled) {}
+  void setActiveScan(bool active) {}
+  bool start(uint32_t duration, void (*scanCompleteCallback)(int) = nullptr, bool isContinue = false) {
+    running = true;
+    return true;
+  }
+  bool stop() {
+    running = false;
+    return true;
+  }
+  void clearResults() {}
+  bool isScanning() const { return running; }
+
+  // Stand-in only: hands an advertisement to the registered callbacks.
+  void advertise(NimBLEAdvertisedDevice& device) {
+    if (running && callbacks != nullptr) callbacks->onResult(&device);
+  }
+
+private:
+  NimBLEAdvertisedDeviceCallbacks* callbacks = nullptr;
+  bool running = false;
+};
+
+class NimBLEDevice {
+public:
+  static NimBLEClient* createClient(NimBLEAddress peerAddress) {
+    clients().push_back(std::make_unique<NimBLEClient>(peerAddress));
+    return clients().back().get();
+  }
+
+  static bool deleteClient(NimBLEClient* client) {
+    auto& list = clients();
+    auto found = std::find_if(list.begin(), list.end(), [client](const std::unique_ptr<NimBLEClient>& entry) { return entry.get() == client; });
+    if (found == list.end()) return false;
+    client->disconnect();
+    list.erase(found);
+    return true;
+  }
+
+  static NimBLEClient* getClientByPeerAddress(const NimBLEAddress& address) {
+    for (auto& client : clients()) {
+      if (client->getPeerAddress() == address) return client.get();
+    }
+    return nullptr;
+  }
+
+  static size_t getClientListSize() { return clients().size(); }
+
+  static NimBLEScan* getScan() {
+    static NimBLEScan scan;
+    return &scan;
+  }
+
+  // Stand-in only: the peripherals a client can reach, by address.
+  static void addPeripheral(NimBLEFakePeripheral* peripheral) { peripherals().push_back(peripheral); }
+  static void removePeripheral(NimBLEFakePeripheral* peripheral) {
+    auto& list = peripherals();
+    list.erase(std::remove(list.begin(), list.end(), peripheral), list.end());
+  }
+  static NimBLEFakePeripheral* findPeripheral(const NimBLEAddress& address) {
+    for (auto* peripheral : peripherals()) {
+      if (peripheral->getAddress() == address) return peripheral;
+    }
+    return nullptr;
+  }
+
+private:
+  static std::vector<std::unique_ptr<NimBLEClient>>& clients() {
+    static std::vector<std::unique_ptr<NimBLEClient>> list;
+    return list;
+  }
+  static std::vector<NimBLEFakePeripheral*>& peripherals() {
+    static std::vector<NimBLEFakePeripheral*> list;
+    return list;
+  }
+};
+
+inline bool NimBLEClient::connect(bool deleteAttributes) {
+  NimBLEFakePeripheral* target = NimBLEDevice::findPeripheral(peerAddress);
+  if (target == nullptr || !target->connectable) return false;
+  peripheral = target;
+  peripheral->linkUp = true;
+  // Without setConnectionParams() the stack asks for 30-50 ms and gets the top.
+  connInterval = target->connInterval != 0 ? target->connInterval : (requestedMaxInterval != 0 ? requestedMaxInterval : 40);
+  return true;
+}
+
+class NimBLEUtils {
+public:
+  // As in NimBLE: lower-case hex; with a null target the result is malloc'd
+  // and owned by the caller.
+  static char* buildHexData(uint8_t* target, const uint8_t* source, uint8_t length) {
+    char* out = target != nullptr ? reinterpret_cast<char*>(target) : static_cast<char*>(malloc(length * 2 + 1));
+    if (out == nullptr) return nullptr;
+    for (uint8_t i = 0; i < length; i++) snprintf(out + i * 2, 3, "%02x", source[i]);
+    out[length * 2] = '\0';
+    return out;
+  }
+};
@@ -0,0 +1,290 @@
+#pragma once
+#include <NimBLEDevice.h>
+#include <remote_scales_platform.h>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Shape of a simulated shot; see ShotCurve.
+struct ShotProfile {
+  uint32_t preinfusionMs = 5000;
+  float peakFlow = 2.0f; // g/s
+  uint32_t rampMs = 3000;
+  uint32_t dripMs = 1200;
+  float noise = 0.03f;   // g
+};
+
+// Weight over time for an espresso shot: nothing during pre-infusion, then
+// flow ramps up towards peakFlow; once the pump stops, the puck keeps
+// dripping with a flow that decays over dripMs. The analytic form gives the
+// exact final weight for any stop time, which is what stop predictors are
+// judged on. Readings add uniform noise of +-noise grams.
+class ShotCurve {
+public:
+  explicit ShotCurve(const ShotProfile& profile = ShotProfile{}, uint32_t seed = 1) : profile(profile), random(seed != 0 ? seed : 1) {}
+
+  // The pump stops at this time after the shot started.
+  void stopAt(uint32_t ms) {
+    stopped = true;
+    stopMs = ms;
+  }
+  bool isStopped() const { return stopped; }
+
+  float flowAt(uint32_t ms) const {
+    if (stopped && ms > stopMs) {
+      return pumpFlowAt(stopMs) * expf(-float(ms - stopMs) / profile.dripMs);
+    }
+    return pumpFlowAt(ms);
+  }
+
+  float trueWeightAt(uint32_t ms) const {
+    if (stopped && ms > stopMs) {
+      float drip = pumpFlowAt(stopMs) * profile.dripMs / 1000.f;
+      return pumpWeightAt(stopMs) + drip * (1.f - expf(-float(ms - stopMs) / profile.dripMs));
+    }
+    return pumpWeightAt(ms);
+  }
+
+  // Where the weight settles; only meaningful once stopAt() was called.
+  float finalWeight() const { return pumpWeightAt(stopMs) + pumpFlowAt(stopMs) * profile.dripMs / 1000.f; }
+
+  // What the scale reads: the true weight plus noise.
+  float readingAt(uint32_t ms) {
+    return trueWeightAt(ms) + profile.noise * (nextUnit() * 2.f - 1.f);
+  }
+
+  const ShotProfile& getProfile() const { return profile; }
+
+private:
+  ShotProfile profile;
+  uint32_t random;
+  bool stopped = false;
+  uint32_t stopMs = 0;
+
+  float pumpFlowAt(uint32_t ms) const {
+    if (ms <= profile.preinfusionMs) return 0.f;
+    return profile.peakFlow * (1.f - expf(-float(ms - profile.preinfusionMs) / profile.rampMs));
+  }
+
+  float pumpWeightAt(uint32_t ms) const {
+    if (ms <= profile.preinfusionMs) return 0.f;
+    float x = float(ms - profile.preinfusionMs);
+    float tau = float(profile.rampMs);
+    return profile.peakFlow * (x - tau * (1.f - expf(-x / tau))) / 1000.f;
+  }
+
+  float nextUnit() {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return (random & 0xFFFFFF) / float(0x1000000);
+  }
+};
+
+// How frames leave a virtual scale. rateHz is the notification rate;
+// maxFragmentLength > 0 splits each frame into random pieces of 1..max
+// bytes, as a small MTU or a stack that coalesces would; errorRate is the
+// fraction of frames that get one random bit flipped on the way;
+// deliveryDelayMs is how long after weighing a played frame arrives.
+struct VirtualScaleOptions {
+  uint32_t rateHz = 10;
+  size_t maxFragmentLength = 0;
+  float errorRate = 0.f;
+  uint32_t seed = 1;
+  uint32_t deliveryDelayMs = 0;
+};
+
+// Bytes a virtual scale would have notified, with the notification
+// boundaries, for feeding a decoder in a timed loop.
+struct VirtualScaleStream {
+  std::vector<uint8_t> bytes;
+  std::vector<size_t> pieceEnds;
+  size_t frames = 0;
+};
+
+// A simulated scale peripheral for the NimBLE stand-in: the protocol's GATT
+// table plus a frame encoder, so a real driver connects to it and decodes
+// what it sends. Subclasses describe one protocol each (see virtual_scales.h).
+// The scale answers its protocol's tare command by zeroing, and registers
+// itself under its address for as long as it lives.
+class VirtualScale {
+public:
+  static constexpr size_t MAX_FRAME_LENGTH = 32;
+
+  virtual ~VirtualScale() { NimBLEDevice::removePeripheral(&peripheral); }
+
+  VirtualScale(const VirtualScale&) = delete;
+  VirtualScale& operator=(const VirtualScale&) = delete;
+
+  NimBLEFakePeripheral& getPeripheral() { return peripheral; }
+  NimBLEAdvertisedDevice advertisement() const { return peripheral.advertisement(); }
+  NimBLERemoteCharacteristic* getWeightCharacteristic() { return weightCharacteristic; }
+
+  void setOptions(const VirtualScaleOptions& options) {
+    this->options = options;
+    random = options.seed != 0 ? options.seed : 1;
+  }
+  const VirtualScaleOptions& getOptions() const { return options; }
+
+  // One valid weight frame, checksum included, for a gross weight in grams
+  // at scale time timestampMs. Scales that report flow send getFlow().
+  // Returns its length.
+  virtual size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const = 0;
+
+  // Encodes the reading net of any tare and notifies it, fragmented and
+  // damaged as the options say. False when the driver is not subscribed.
+  bool send(float grossGrams, uint32_t timestampMs) {
+    lastGross = grossGrams;
+    uint8_t frame[MAX_FRAME_LENGTH];
+    size_t length = encode(grossGrams - tareOffset, timestampMs, frame);
+    damage(frame, length);
+    bool delivered = true;
+    forEachPiece(length, [&](size_t offset, size_t piece) {
+      delivered = weightCharacteristic->notify(frame + offset, piece) && delivered;
+    });
+    framesSent++;
+    return delivered;
+  }
+
+  // Plays a shot at options.rateHz for durationMs, moving the simulated clock
+  // between notifications. betweenFrames runs after every frame, e.g. the
+  // caller's update() loop or a stop decision; returning false ends the shot early.
+  template <typename Callback>
+  uint32_t playShot(ShotCurve& shot, uint32_t durationMs, SimulatedRemoteScalesClock& clock, Callback betweenFrames) {
+    uint64_t periodUs = 1000000ull / options.rateHz;
+    uint32_t frames = 0;
+    for (uint64_t elapsedUs = 0; elapsedUs <= uint64_t(durationMs) * 1000; elapsedUs += periodUs) {
+      uint32_t elapsedMs = static_cast<uint32_t>(elapsedUs / 1000);
+      uint32_t weighedMs = elapsedMs > options.deliveryDelayMs ? elapsedMs - options.deliveryDelayMs : 0;
+      flow = shot.flowAt(weighedMs);
+      send(shot.readingAt(weighedMs), weighedMs);
+      frames++;
+      if (!betweenFrames(elapsedMs)) break;
+      clock.advanceUs(static_cast<uint32_t>(periodUs));
+    }
+    return frames;
+  }
+
+  uint32_t playShot(ShotCurve& shot, uint32_t durationMs, SimulatedRemoteScalesClock& clock) {
+    return playShot(shot, durationMs, clock, [](uint32_t) { return true; });
+  }
+
+  // The same frames as playShot() would send, collected instead of notified.
+  VirtualScaleStream record(ShotCurve& shot, uint32_t durationMs) {
+    VirtualScaleStream stream;
+    uint64_t periodUs = 1000000ull / options.rateHz;
+    for (uint64_t elapsedUs = 0; elapsedUs <= uint64_t(durationMs) * 1000; elapsedUs += periodUs) {
+      uint32_t elapsedMs = static_cast<uint32_t>(elapsedUs / 1000);
+      flow = shot.flowAt(elapsedMs);
+      uint8_t frame[MAX_FRAME_LENGTH];
+      size_t length = encode(shot.readingAt(elapsedMs) - tareOffset, elapsedMs, frame);
+      damage(frame, length);
+      size_t start = stream.bytes.size();
+      stream.bytes.insert(stream.bytes.end(), frame, frame + length);
+      forEachPiece(length, [&](size_t offset, size_t piece) { stream.pieceEnds.push_back(start + offset + piece); });
+      stream.frames++;
+    }
+    return stream;
+  }
+
+  // Flow in g/s for the next frames; playShot() and record() follow the curve.
+  void setFlow(float gramsPerSecond) { flow = gramsPerSecond; }
+  float getFlow() const { return flow; }
+
+  float getTareOffset() const { return tareOffset; }
+  uint32_t getTares() const { return tares; }
+  uint32_t getFramesSent() const { return framesSent; }
+
+protected:
+  struct CharacteristicSpec {
+    const char* uuid;
+    bool notify;
+    bool indicate;
+    bool cccd;
+  };
+
+  // The first characteristic is the one weight frames are notified on.
+  VirtualScale(const char* name, const char* address, const char* service, std::initializer_list<CharacteristicSpec> characteristics)
+    : peripheral(address, name) {
+    NimBLERemoteService* gattService = peripheral.addService(NimBLEUUID(service));
+    for (const CharacteristicSpec& spec : characteristics) {
+      NimBLERemoteCharacteristic* characteristic = gattService->addCharacteristic(NimBLEUUID(spec.uuid), spec.notify, spec.indicate);
+      if (spec.cccd) characteristic->addDescriptor(NimBLEUUID(static_cast<uint16_t>(0x2902)));
+      characteristic->onWrite = [this, characteristic](const uint8_t* data, size_t length) {
+        if (isTare(characteristic, data, length)) tare();
+      };
+      if (weightCharacteristic == nullptr) weightCharacteristic = characteristic;
+    }
+    NimBLEDevice::addPeripheral(&peripheral);
+  }
+
+  // True when a write is this protocol's tare.
+  virtual bool isTare(const NimBLERemoteCharacteristic* characteristic, const uint8_t* data, size_t length) { return false; }
+
+  void tare() {
+    tareOffset = lastGross;
+    tares++;
+  }
+
+  static void put16BE(uint8_t* out, uint32_t value) {
+    out[0] = (value >> 8) & 0xFF;
+    out[1] = value & 0xFF;
+  }
+  static void put24BE(uint8_t* out, uint32_t value) {
+    out[0] = (value >> 16) & 0xFF;
+    put16BE(out + 1, value);
+  }
+  static void put32BE(uint8_t* out, uint32_t value) {
+    out[0] = (value >> 24) & 0xFF;
+    put24BE(out + 1, value);
+  }
+  static void put32LE(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (value >> (8 * i)) & 0xFF;
+  }
+  static uint8_t xorOf(const uint8_t* data, size_t length) {
+    uint8_t result = 0;
+    for (size_t i = 0; i < length; i++) result ^= data[i];
+    return result;
+  }
+  static int32_t scaled(float grams, float unitsPerGram) { return static_cast<int32_t>(lroundf(grams * unitsPerGram)); }
+
+private:
+  NimBLEFakePeripheral peripheral;
+  NimBLERemoteCharacteristic* weightCharacteristic = nullptr;
+  VirtualScaleOptions options;
+  uint32_t random = 1;
+  float lastGross = 0.f;
+  float flow = 0.f;
+  float tareOffset = 0.f;
+  uint32_t tares = 0;
+  uint32_t framesSent = 0;
+
+  uint32_t nextRandom() {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random;
+  }
+
+  void damage(uint8_t* frame, size_t length) {
+    if (options.errorRate <= 0.f || length == 0) return;
+    if ((nextRandom() & 0xFFFF) < options.errorRate * 0x10000) {
+      frame[nextRandom() % length] ^= 1 << (nextRandom() % 8);
+    }
+  }
+
+  template <typename Piece>
+  void forEachPiece(size_t length, Piece piece) {
+    size_t offset = 0;
+    while (offset < length) {
+      size_t size = length - offset;
+      if (options.maxFragmentLength > 0) {
+        size_t limit = 1 + nextRandom() % options.maxFragmentLength;
+        if (size > limit) size = limit;
+      }
+      piece(offset, size);
+      offset += size;
+    }
+  }
+};
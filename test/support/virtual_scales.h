@@ -0,0 +1,377 @@
+#pragma once
+#include "virtual_scale.h"
+#include <remote_scales_plugin_registry.h>
+#include <acaia.h>
+#include <bookoo.h>
+#include <decent.h>
+#include <difluid.h>
+#include <dot.h>
+#include <eclair.h>
+#include <eureka.h>
+#include <felicitaScale.h>
+#include <myscale.h>
+#include <timemore.h>
+#include <varia.h>
+#include <weighmybru.h>
+#include <cstring>
+#include <memory>
+
+// One virtual scale per supported protocol. Frame layouts follow the drivers'
+// decoders; where a protocol carries a checksum it is computed the way the
+// scale does, so an undamaged frame always decodes.
+
+static constexpr const char* VIRTUAL_SCALE_ADDRESS = "c8:2e:18:00:00:01";
+
+inline void applyAllScalePlugins() {
+  AcaiaScalesPlugin::apply();
+  BookooScalesPlugin::apply();
+  DecentScalesPlugin::apply();
+  DifluidScalesPlugin::apply();
+  TimemoreDotScalesPlugin::apply();
+  EclairScalesPlugin::apply();
+  EurekaScalesPlugin::apply();
+  FelicitaScalePlugin::apply();
+  myscalePlugin::apply();
+  TimemoreScalesPlugin::apply();
+  VariaScalesPlugin::apply();
+  WeighMyBrewScalePlugin::apply();
+}
+
+// The driver the library would pick for a virtual scale's advertisement.
+inline std::unique_ptr<RemoteScales> discoverDriver(const VirtualScale& scale) {
+  NimBLEAdvertisedDevice advertised = scale.advertisement();
+  return RemoteScalesFactory::getInstance()->create(DiscoveredDevice(&advertised));
+}
+
+// EF DD 0C | len 05 [weight LE16] 00 00 [scaling] [sign] | two additive checksums
+class AcaiaVirtualScale : public VirtualScale {
+public:
+  explicit AcaiaVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("LUNAR-1234", address, "49535343-fe7d-4ae5-8fa9-9fafd205e455", {
+        { "49535343-1e4d-4bd9-ba61-23c647249616", true, false, true },
+        { "49535343-8841-43f4-a8d4-ecbe34729bb3", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    uint32_t hundredths = static_cast<uint32_t>(std::abs(scaled(grams, 100.f)));
+    const uint8_t frame[] = { 0xEF, 0xDD, 0x0C, 0x08, 0x05, uint8_t(hundredths & 0xFF), uint8_t((hundredths >> 8) & 0xFF),
+      0x00, 0x00, 0x02, uint8_t(grams < 0.f ? 0x02 : 0x00), 0x00, 0x00 };
+    memcpy(out, frame, sizeof(frame));
+    for (size_t i = 0; i < 8; i++) out[11 + (i % 2)] += out[3 + i];
+    return sizeof(frame);
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length > 3 && data[0] == 0xEF && data[1] == 0xDD && data[2] == 0x04;
+  }
+};
+
+// 03 0B [timer BE24 ms] 02 [sign] [weight BE24 0.01 g] [flow sign] [flow BE16] [battery] .. [xor]
+class BookooVirtualScale : public VirtualScale {
+public:
+  explicit BookooVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("BOOKOO_SC 1234", address, "0FFE", {
+        { "FF11", true, false, false },
+        { "FF12", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 20);
+    out[0] = 0x03;
+    out[1] = 0x0B;
+    put24BE(out + 2, timestampMs & 0xFFFFFF);
+    out[5] = 0x02;
+    out[6] = grams < 0.f ? '-' : '+';
+    put24BE(out + 7, static_cast<uint32_t>(std::abs(scaled(grams, 100.f))));
+    out[10] = getFlow() < 0.f ? '-' : '+';
+    put16BE(out + 11, static_cast<uint32_t>(std::abs(scaled(getFlow(), 100.f))));
+    out[13] = 100;
+    out[19] = xorOf(out, 19);
+    return 20;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length == 6 && data[0] == 0x03 && data[1] == 0x0A && (data[2] == 0x01 || data[2] == 0x07);
+  }
+};
+
+// 03 CE [weight BE16 0.1 g] [min] [sec] [tenths] 00 00 [xor]
+class DecentVirtualScale : public VirtualScale {
+public:
+  explicit DecentVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("Decent Scale", address, "FFF0", {
+        { "FFF4", true, false, false },
+        { "36F5", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 10);
+    out[0] = 0x03;
+    out[1] = 0xCE;
+    put16BE(out + 2, static_cast<uint16_t>(static_cast<int16_t>(scaled(grams, 10.f))));
+    out[4] = (timestampMs / 60000) & 0xFF;
+    out[5] = (timestampMs / 1000) % 60;
+    out[6] = (timestampMs / 100) % 10;
+    out[9] = xorOf(out, 9);
+    return 10;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length == 7 && data[0] == 0x03 && data[1] == 0x0F;
+  }
+};
+
+// DF DF 03 00 0D [weight BE32 0.1 g] [9 bytes] [sum]
+class DifluidVirtualScale : public VirtualScale {
+public:
+  explicit DifluidVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("Microbalance", address, "00EE", {
+        { "AA01", true, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 19);
+    const uint8_t header[] = { 0xDF, 0xDF, 0x03, 0x00, 0x0D };
+    memcpy(out, header, sizeof(header));
+    put32BE(out + 5, static_cast<uint32_t>(scaled(grams, 10.f)));
+    for (size_t i = 0; i < 18; i++) out[18] += out[i];
+    return 19;
+  }
+
+protected:
+  // Commands go to the same characteristic the weight is notified on.
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length == 7 && data[0] == 0xDF && data[1] == 0xDF && data[2] == 0x03 && data[3] == 0x02;
+  }
+};
+
+// A5 5A 01 01 00 09 [weight BE32 0.1 g] [5 bytes] [crc16]. The driver does
+// not check the CRC and its polynomial is not documented, so it stays zero.
+// The scale only zeroes once the status poll that follows a tare arrives.
+class DotVirtualScale : public VirtualScale {
+public:
+  explicit DotVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("TIMEMORE_Dot", address, "FFF0", {
+        { "FFF1", true, false, false },
+        { "FFF2", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 17);
+    const uint8_t header[] = { 0xA5, 0x5A, 0x01, 0x01, 0x00, 0x09 };
+    memcpy(out, header, sizeof(header));
+    put32BE(out + 6, static_cast<uint32_t>(scaled(grams, 10.f)));
+    return 17;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    if (length < 4 || data[0] != 0xA5 || data[1] != 0x5A) return false;
+    if (data[2] == 0x02 && data[3] == 0x04) {
+      tarePending = true;
+      return false;
+    }
+    if (data[2] == 0x03 && data[3] == 0x0D && tarePending) {
+      tarePending = false;
+      return true;
+    }
+    return false;
+  }
+
+private:
+  bool tarePending = false;
+};
+
+// 57 [weight LE32 mg] [4 bytes] [xor of bytes 1..8]
+class EclairVirtualScale : public VirtualScale {
+public:
+  explicit EclairVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("ECLAIR-1234", address, "B905EAEA-2E63-0E04-7582-7913F10D8F81", {
+        { "AD736C5F-BBC9-1F96-D304-CB5D5F41E160", true, false, false },
+        { "4F9A45BA-8E1B-4E07-E157-0814D393B968", true, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 10);
+    out[0] = 0x57;
+    put32LE(out + 1, static_cast<uint32_t>(scaled(grams, 1000.f)));
+    out[9] = xorOf(out + 1, 8);
+    return 10;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length == 3 && data[0] == 0x54;
+  }
+};
+
+// AA 02 41 0C 00 00 [sign] [weight LE16 0.1 g] 00 00; no checksum.
+class EurekaVirtualScale : public VirtualScale {
+public:
+  explicit EurekaVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("CFS-9002", address, "FFF0", {
+        { "FFF1", true, false, false },
+        { "FFF2", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 11);
+    const uint8_t header[] = { 0xAA, 0x02, 0x41, 0x0C };
+    memcpy(out, header, sizeof(header));
+    uint32_t tenths = static_cast<uint32_t>(std::abs(scaled(grams, 10.f)));
+    out[6] = grams < 0.f ? 1 : 0;
+    out[7] = tenths & 0xFF;
+    out[8] = (tenths >> 8) & 0xFF;
+    return 11;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length >= 4 && data[0] == 0xAA && data[1] == 0x02 && data[2] == 0x31;
+  }
+};
+
+// 01 02 [sign] [6 ASCII digits 0.01 g] " g " .. [sum]
+class FelicitaVirtualScale : public VirtualScale {
+public:
+  explicit FelicitaVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("FELICITA", address, "FFE0", {
+        { "FFE1", true, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 18);
+    out[0] = 0x01;
+    out[1] = 0x02;
+    out[2] = grams < 0.f ? '-' : '+';
+    uint32_t hundredths = static_cast<uint32_t>(std::abs(scaled(grams, 100.f))) % 1000000;
+    for (int i = 8; i >= 3; i--) {
+      out[i] = '0' + hundredths % 10;
+      hundredths /= 10;
+    }
+    out[9] = ' ';
+    out[10] = 'g';
+    out[11] = ' ';
+    for (size_t i = 0; i < 17; i++) out[17] += out[i];
+    return 18;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length == 1 && data[0] == 0x54;
+  }
+};
+
+// AC 40 [sign nibble] [weight 28 bits BE, 0.001 g] .. [sum]
+class MyScaleVirtualScale : public VirtualScale {
+public:
+  explicit MyScaleVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("my_scale", address, "0000FFB0-0000-1000-8000-00805F9B34FB", {
+        { "0000FFB2-0000-1000-8000-00805F9B34FB", true, false, true },
+        { "0000FFB1-0000-1000-8000-00805F9B34FB", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 20);
+    out[0] = 0xAC;
+    out[1] = 0x40;
+    out[2] = grams < 0.f ? 0x80 : 0x00;
+    put32BE(out + 3, static_cast<uint32_t>(std::abs(scaled(grams, 1000.f))) & 0x0FFFFFFF);
+    for (size_t i = 0; i < 19; i++) out[19] += out[i];
+    return 20;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length == 20 && data[0] == 0xAC && data[1] == 0x40;
+  }
+};
+
+// 10 [dripper LE32 0.1 g] [scale LE32 0.1 g]; no checksum. Indications only.
+class TimemoreVirtualScale : public VirtualScale {
+public:
+  explicit TimemoreVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("Timemore Scale", address, "181D", {
+        { "2A9D", false, true, true },
+        { "553f4e49-bf21-4468-9c6c-0e4fb5b17697", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    uint32_t tenths = static_cast<uint32_t>(scaled(grams, 10.f));
+    out[0] = 0x10;
+    put32LE(out + 1, tenths);
+    put32LE(out + 5, tenths);
+    return 9;
+  }
+
+protected:
+  // Notification requests share the 0x00 payload but go to the weight characteristic.
+  bool isTare(const NimBLERemoteCharacteristic* characteristic, const uint8_t* data, size_t length) override {
+    return characteristic != getWeightCharacteristic() && length == 1 && data[0] == 0x00;
+  }
+};
+
+// FA 01 03 [sign 0x10 | weight hi nibble] [mid] [lo] [xor of bytes 1..5], 0.01 g
+class VariaVirtualScale : public VirtualScale {
+public:
+  explicit VariaVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("AKU MINI SCALE", address, "FFF0", {
+        { "FFF1", true, false, false },
+        { "FFF2", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    uint32_t hundredths = static_cast<uint32_t>(std::abs(scaled(grams, 100.f))) & 0x0FFFFF;
+    out[0] = 0xFA;
+    out[1] = 0x01;
+    out[2] = 0x03;
+    put24BE(out + 3, hundredths);
+    if (grams < 0.f) out[3] |= 0x10;
+    out[6] = xorOf(out + 1, 5);
+    return 7;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length >= 2 && data[0] == 0xFA && data[1] == 0x82;
+  }
+};
+
+// 03 0B .. 02 [sign] [weight BE24 0.01 g] .. [xor], the Bookoo layout.
+class WeighMyBruVirtualScale : public VirtualScale {
+public:
+  explicit WeighMyBruVirtualScale(const char* address = VIRTUAL_SCALE_ADDRESS)
+    : VirtualScale("WeighMyBru", address, "6E400001-B5A3-F393-E0A9-E50E24DCCA9E", {
+        { "6E400002-B5A3-F393-E0A9-E50E24DCCA9E", true, false, false },
+        { "6E400003-B5A3-F393-E0A9-E50E24DCCA9E", false, false, false } }) {}
+
+  size_t encode(float grams, uint32_t timestampMs, uint8_t* out) const override {
+    memset(out, 0, 20);
+    out[0] = 0x03;
+    out[1] = 0x0B;
+    out[5] = 0x02;
+    out[6] = grams < 0.f ? '-' : '+';
+    put24BE(out + 7, static_cast<uint32_t>(std::abs(scaled(grams, 100.f))));
+    out[19] = xorOf(out, 19);
+    return 20;
+  }
+
+protected:
+  bool isTare(const NimBLERemoteCharacteristic*, const uint8_t* data, size_t length) override {
+    return length == 6 && data[0] == 0x03 && data[1] == 0x0A && data[2] == 0x01;
+  }
+};
+
+// Every protocol once, each under its own address so they can coexist.
+inline std::vector<std::unique_ptr<VirtualScale>> makeAllVirtualScales() {
+  static const char* addresses[] = {
+    "c8:2e:18:00:01:01", "c8:2e:18:00:01:02", "c8:2e:18:00:01:03", "c8:2e:18:00:01:04",
+    "c8:2e:18:00:01:05", "c8:2e:18:00:01:06", "c8:2e:18:00:01:07", "c8:2e:18:00:01:08",
+    "c8:2e:18:00:01:09", "c8:2e:18:00:01:0a", "c8:2e:18:00:01:0b", "c8:2e:18:00:01:0c" };
+  std::vector<std::unique_ptr<VirtualScale>> scales;
+  scales.push_back(std::make_unique<AcaiaVirtualScale>(addresses[0]));
+  scales.push_back(std::make_unique<BookooVirtualScale>(addresses[1]));
+  scales.push_back(std::make_unique<DecentVirtualScale>(addresses[2]));
+  scales.push_back(std::make_unique<DifluidVirtualScale>(addresses[3]));
+  scales.push_back(std::make_unique<DotVirtualScale>(addresses[4]));
+  scales.push_back(std::make_unique<EclairVirtualScale>(addresses[5]));
+  scales.push_back(std::make_unique<EurekaVirtualScale>(addresses[6]));
+  scales.push_back(std::make_unique<FelicitaVirtualScale>(addresses[7]));
+  scales.push_back(std::make_unique<MyScaleVirtualScale>(addresses[8]));
+  scales.push_back(std::make_unique<TimemoreVirtualScale>(addresses[9]));
+  scales.push_back(std::make_unique<VariaVirtualScale>(addresses[10]));
+  scales.push_back(std::make_unique<WeighMyBruVirtualScale>(addresses[11]));
+  return scales;
+}